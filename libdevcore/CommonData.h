@@ -42,21 +42,34 @@ enum class WhenError
 	Throw = 1,
 };
 
+/// The two lowercase hex digits of each byte value, back to back: one lookup encodes a whole byte.
+extern char const c_hexPairs[513];
+
+/// Writes the lowercase hex encoding of [@a _it, @a _end) to @a o_out, which must have room for twice as many characters.
+/// @returns the position just past the last character written.
 template <class Iterator>
-std::string toHex(Iterator _it, Iterator _end, std::string _prefix)
+char* writeHex(Iterator _it, Iterator _end, char* o_out)
 {
 	typedef std::iterator_traits<Iterator> traits;
 	static_assert(sizeof(typename traits::value_type) == 1, "toHex needs byte-sized element type");
 
-	static char const* hexdigits = "0123456789abcdef";
-	size_t off = _prefix.size();
-	std::string hex(std::distance(_it, _end)*2 + off, '0');
-	hex.replace(0, off, _prefix);
-	for (; _it != _end; _it++)
+	for (; _it != _end; ++_it)
 	{
-		hex[off++] = hexdigits[(*_it >> 4) & 0x0f];
-		hex[off++] = hexdigits[*_it & 0x0f];
+		char const* pair = c_hexPairs + 2 * static_cast<uint8_t>(*_it);
+		*o_out++ = pair[0];
+		*o_out++ = pair[1];
 	}
+	return o_out;
+}
+
+template <class Iterator>
+std::string toHex(Iterator _it, Iterator _end, std::string const& _prefix)
+{
+	size_t off = _prefix.size();
+	std::string hex(std::distance(_it, _end) * 2 + off, '0');
+	hex.replace(0, off, _prefix);
+	if (_it != _end)
+		writeHex(_it, _end, &hex[off]);
 	return hex;
 }
 
@@ -38,32 +38,70 @@ template <unsigned S> std::string toJS(FixedHash<S> const& _h)
 
 template <unsigned N> std::string toJS(boost::multiprecision::number<boost::multiprecision::cpp_int_backend<N, N, boost::multiprecision::unsigned_magnitude, boost::multiprecision::unchecked, void>> const& _n)
 {
-	std::string h = toHex(toCompactBigEndian(_n, 1));
-	// remove first 0, if it is necessary;
-	std::string res = h[0] != '0' ? h : h.substr(1);
-	return "0x" + res;
+	// Read the limbs directly; shifting the whole number a byte at a time dominates RPC serialisation otherwise.
+	auto const& backend = _n.backend();
+	char digits[N / 4 + 2 * sizeof(*backend.limbs())];
+	char* const end = digits + sizeof(digits);
+	char* p = end;
+	for (unsigned i = 0; i < backend.size(); ++i)
+	{
+		auto limb = backend.limbs()[i];
+		for (unsigned j = 0; j < sizeof(limb) * 2; ++j, limb >>= 4)
+			*--p = c_hexPairs[2 * (limb & 0xf) + 1];
+	}
+	// Quantities carry no leading zeroes, but zero itself is "0x0".
+	while (p + 1 < end && *p == '0')
+		++p;
+	std::string ret(2 + (end - p), 'x');
+	ret[0] = '0';
+	std::copy(p, end, ret.begin() + 2);
+	return ret;
 }
 
 inline std::string toJS(bytes const& _n, std::size_t _padding = 0)
 {
-	bytes n = _n;
-	n.resize(std::max<unsigned>(n.size(), _padding));
-	return toHexPrefixed(n);
+	std::string ret = toHexPrefixed(_n);
+	if (_n.size() < _padding)
+		ret.append((_padding - _n.size()) * 2, '0');
+	return ret;
 }
 
 template<unsigned T> std::string toJS(SecureFixedHash<T> const& _i)
 {
-	std::stringstream stream;
-	stream << "0x" << _i.makeInsecure().hex();
-	return stream.str();
+	return toHexPrefixed(_i.makeInsecure().ref());
 }
 
-template<typename T> std::string toJS(T const& _i)
+namespace detail
+{
+template<typename T> std::string toJS(T const& _i, std::true_type)
+{
+	// Same digits as streaming with std::hex, i.e. negative values in two's complement, without the stream.
+	typename std::make_unsigned<T>::type v = _i;
+	char digits[sizeof(T) * 2];
+	char* const end = digits + sizeof(digits);
+	char* p = end;
+	do
+		*--p = c_hexPairs[2 * (v & 0xf) + 1];
+	while (v >>= 4);
+	std::string ret(2 + (end - p), 'x');
+	ret[0] = '0';
+	std::copy(p, end, ret.begin() + 2);
+	return ret;
+}
+
+template<typename T> std::string toJS(T const& _i, std::false_type)
 {
 	std::stringstream stream;
 	stream << "0x" << std::hex << _i;
 	return stream.str();
 }
+}
+
+template<typename T> std::string toJS(T const& _i)
+{
+	// Character types stream as characters rather than numbers, so leave them to the stream.
+	return detail::toJS(_i, std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > 1)>());
+}
 
 enum class OnFailed { InterpretRaw, Empty, Throw };
 
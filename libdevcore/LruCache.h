@@ -0,0 +1,94 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file LruCache.h
+ * @date 2018
+ */
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include "Guards.h"
+
+namespace dev
+{
+
+/**
+ * @brief Thread-safe map of bounded size.
+ * When full, inserting a new key evicts the least recently used entry.
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LruCache
+{
+public:
+	explicit LruCache(size_t _capacity): m_capacity(_capacity) {}
+
+	/// Copies the value cached for @a _key into @a o_value and marks it as recently used.
+	/// @returns false, leaving @a o_value untouched, if @a _key is not cached.
+	bool get(Key const& _key, Value& o_value) const
+	{
+		Guard l(x_cache);
+		auto it = m_index.find(_key);
+		if (it == m_index.end())
+			return false;
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		o_value = it->second->second;
+		return true;
+	}
+
+	void put(Key const& _key, Value const& _value)
+	{
+		Guard l(x_cache);
+		auto it = m_index.find(_key);
+		if (it != m_index.end())
+		{
+			it->second->second = _value;
+			m_entries.splice(m_entries.begin(), m_entries, it->second);
+			return;
+		}
+		if (!m_capacity)
+			return;
+		if (m_entries.size() >= m_capacity)
+		{
+			m_index.erase(m_entries.back().first);
+			m_entries.pop_back();
+		}
+		m_entries.emplace_front(_key, _value);
+		m_index[_key] = m_entries.begin();
+	}
+
+	void clear()
+	{
+		Guard l(x_cache);
+		m_entries.clear();
+		m_index.clear();
+	}
+
+	size_t size() const { Guard l(x_cache); return m_entries.size(); }
+	size_t capacity() const { return m_capacity; }
+
+private:
+	using Entries = std::list<std::pair<Key, Value>>;
+
+	size_t const m_capacity;
+	mutable Mutex x_cache;
+	mutable Entries m_entries;		///< Most recently used first.
+	std::unordered_map<Key, typename Entries::iterator, Hash> m_index;
+};
+
+}
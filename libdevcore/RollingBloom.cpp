@@ -0,0 +1,77 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RollingBloom.cpp
+ * @date 2018
+ */
+
+#include "RollingBloom.h"
+
+using namespace std;
+using namespace dev;
+
+RollingBloom::RollingBloom(unsigned _capacity):
+	m_capacity(max(_capacity, 1u))
+{
+	// Sixteen bits per entry and four probes keep the false positive rate of a full generation near 0.25%.
+	uint32_t bits = 64;
+	while (bits < m_capacity * 16)
+		bits <<= 1;
+	m_mask = bits - 1;
+	m_current.assign(bits / 64, 0);
+	m_previous.assign(bits / 64, 0);
+}
+
+array<uint32_t, RollingBloom::c_hashes> RollingBloom::indices(h256 const& _h) const
+{
+	array<uint32_t, c_hashes> ret;
+	for (unsigned i = 0; i < c_hashes; ++i)
+		ret[i] = (uint32_t(_h[i * 4]) << 24 | uint32_t(_h[i * 4 + 1]) << 16 | uint32_t(_h[i * 4 + 2]) << 8 | uint32_t(_h[i * 4 + 3])) & m_mask;
+	return ret;
+}
+
+void RollingBloom::insert(h256 const& _h)
+{
+	if (m_inserted == m_capacity)
+	{
+		m_previous.swap(m_current);
+		fill(m_current.begin(), m_current.end(), 0);
+		m_inserted = 0;
+	}
+	for (uint32_t i: indices(_h))
+		m_current[i / 64] |= uint64_t(1) << (i % 64);
+	++m_inserted;
+}
+
+bool RollingBloom::contains(h256 const& _h) const
+{
+	auto const is = indices(_h);
+	auto in = [&](vector<uint64_t> const& _bits)
+	{
+		for (uint32_t i: is)
+			if (!(_bits[i / 64] & (uint64_t(1) << (i % 64))))
+				return false;
+		return true;
+	};
+	return in(m_current) || in(m_previous);
+}
+
+void RollingBloom::clear()
+{
+	fill(m_current.begin(), m_current.end(), 0);
+	fill(m_previous.begin(), m_previous.end(), 0);
+	m_inserted = 0;
+}
@@ -0,0 +1,63 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RollingBloom.h
+ * @date 2018
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include "FixedHash.h"
+
+namespace dev
+{
+
+/**
+ * @brief Approximate set of the most recently inserted hashes, in fixed memory.
+ * Two generations of Bloom filter are kept; once the current one has taken @a _capacity
+ * insertions it becomes the previous one and a fresh generation is started. Lookups consult
+ * both, so at least the last @a _capacity insertions are always remembered. False positives
+ * are possible (well under one percent at capacity); false negatives are not, until a
+ * hash ages out.
+ * Keys are expected to be cryptographic hashes, so their bytes are used directly as the
+ * filter indices. Not thread-safe.
+ */
+class RollingBloom
+{
+public:
+	explicit RollingBloom(unsigned _capacity = 8192);
+
+	void insert(h256 const& _h);
+	bool contains(h256 const& _h) const;
+	void clear();
+
+	unsigned capacity() const { return m_capacity; }
+
+private:
+	static unsigned const c_hashes = 4;
+
+	std::array<uint32_t, c_hashes> indices(h256 const& _h) const;
+
+	unsigned m_capacity;
+	uint32_t m_mask;				///< Number of bits in a generation, less one.
+	std::vector<uint64_t> m_current;
+	std::vector<uint64_t> m_previous;
+	unsigned m_inserted = 0;		///< Insertions into the current generation.
+};
+
+}
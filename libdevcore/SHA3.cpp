@@ -220,4 +220,32 @@ bool sha3(bytesConstRef _input, bytesRef o_output)
 	return true;
 }
 
+void SHA3Sponge::update(bytesConstRef _input)
+{
+	uint8_t* state = reinterpret_cast<uint8_t*>(m_lanes);
+	while (!_input.empty())
+	{
+		size_t n = min<size_t>(c_rate - m_offset, _input.size());
+		keccak::xorin(state + m_offset, _input.data(), n);
+		m_offset += n;
+		_input = _input.cropped(n);
+		if (m_offset == c_rate)
+		{
+			keccak::keccakf(m_lanes);
+			m_offset = 0;
+		}
+	}
+}
+
+void SHA3Sponge::peek(bytesRef o_output) const
+{
+	uint64_t lanes[25];
+	memcpy(lanes, m_lanes, sizeof(lanes));
+	uint8_t* state = reinterpret_cast<uint8_t*>(lanes);
+	state[m_offset] ^= 0x01;
+	state[c_rate - 1] ^= 0x80;
+	keccak::keccakf(lanes);
+	memcpy(o_output.data(), state, min<size_t>(o_output.size(), h256::size));
+}
+
 }
@@ -64,6 +64,31 @@ inline std::string sha3(std::string const& _input, bool _isNibbles) { return asS
 /// Calculate SHA3-256 MAC
 inline void sha3mac(bytesConstRef _secret, bytesConstRef _plain, bytesRef _output) { sha3(_secret.toBytes() + _plain.toBytes()).ref().populate(_output); }
 
+/**
+ * @brief Incremental SHA3-256 whose digest can be read at any point without disturbing the running state.
+ *
+ * Input is XORed straight into the lanes, so there is no block buffer; peeking at the digest
+ * pads and permutes a copy of the 200-byte lane array only. Used for the running RLPx MACs.
+ */
+class SHA3Sponge
+{
+public:
+	/// Absorb _input into the running state.
+	void update(bytesConstRef _input);
+
+	/// Write the first o_output.size() bytes (at most 32) of the hash of everything absorbed so far.
+	void peek(bytesRef o_output) const;
+
+	/// @returns the hash of everything absorbed so far.
+	h256 digest() const { h256 ret; peek(ret.ref()); return ret; }
+
+private:
+	static unsigned const c_rate = 136;
+
+	uint64_t m_lanes[25] = {};	///< Keccak-f[1600] state.
+	unsigned m_offset = 0;		///< Bytes already absorbed into the current block.
+};
+
 extern h256 EmptySHA3;
 
 extern h256 EmptyListSHA3;
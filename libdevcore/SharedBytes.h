@@ -0,0 +1,76 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SharedBytes.h
+ * @date 2018
+ */
+
+#pragma once
+
+#include <memory>
+#include "Common.h"
+#include "vector_ref.h"
+
+namespace dev
+{
+
+/**
+ * @brief Read-only view into a reference-counted byte buffer.
+ * Copies and slices share the buffer rather than duplicating it, so a single network read
+ * buffer can back the packet, transactions and blocks decoded from it for as long as any of
+ * them is still queued.
+ */
+class SharedBytesRef
+{
+public:
+	SharedBytesRef() = default;
+	/// Take ownership of @a _data.
+	explicit SharedBytesRef(bytes&& _data): m_buffer(std::make_shared<bytes>(std::move(_data))), m_ref(m_buffer.get()) {}
+
+	SharedBytesRef(SharedBytesRef const&) = default;
+	SharedBytesRef& operator=(SharedBytesRef const&) = default;
+	SharedBytesRef(SharedBytesRef&& _other): m_buffer(std::move(_other.m_buffer)), m_ref(_other.m_ref) { _other.m_ref.reset(); }
+	SharedBytesRef& operator=(SharedBytesRef&& _other)
+	{
+		m_buffer = std::move(_other.m_buffer);
+		m_ref = _other.m_ref;
+		if (&_other != this)
+			_other.m_ref.reset();
+		return *this;
+	}
+
+	/// @returns a view of @a _sub sharing this buffer, or an owning copy of @a _sub if it does not lie within the view.
+	SharedBytesRef slice(bytesConstRef _sub) const
+	{
+		if (m_buffer && _sub.data() >= m_ref.data() && _sub.data() + _sub.size() <= m_ref.data() + m_ref.size())
+			return SharedBytesRef(m_buffer, _sub);
+		return SharedBytesRef(_sub.toBytes());
+	}
+
+	bytesConstRef ref() const { return m_ref; }
+	byte const* data() const { return m_ref.data(); }
+	size_t size() const { return m_ref.size(); }
+	bool empty() const { return m_ref.empty(); }
+	bytes toBytes() const { return m_ref.toBytes(); }
+
+private:
+	SharedBytesRef(std::shared_ptr<bytes const> const& _buffer, bytesConstRef _ref): m_buffer(_buffer), m_ref(_ref) {}
+
+	std::shared_ptr<bytes const> m_buffer;	///< Keeps the viewed memory alive. Null for an empty view.
+	bytesConstRef m_ref;					///< The viewed part of *m_buffer.
+};
+
+}
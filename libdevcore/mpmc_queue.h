@@ -0,0 +1,205 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace dev
+{
+
+/// Bounded lock-free multi-producer/multi-consumer queue.
+/// A ring of cells, each carrying a sequence number that tells producers and consumers
+/// whether the cell is free or filled for their lap (D. Vyukov's bounded MPMC queue).
+/// push() never blocks: when the ring is full the element is refused and counted as dropped.
+/// pop_batch() takes as many elements as are available up to a limit, and only parks on a
+/// condition variable when the ring is empty, so producers touch the mutex only if somebody sleeps.
+template<typename _T>
+class mpmc_queue
+{
+public:
+	/// @param _capacity rounded up to a power of two.
+	explicit mpmc_queue(size_t _capacity):
+		m_mask(roundUp(_capacity) - 1),
+		m_cells(new Cell[m_mask + 1])
+	{
+		for (size_t i = 0; i <= m_mask; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	mpmc_queue(mpmc_queue const&) = delete;
+	mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+	/// @returns false if the queue is full; @a _elem is then left untouched.
+	template<typename _U>
+	bool push(_U&& _elem)
+	{
+		Cell* cell;
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t const seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t const diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				++m_dropped;
+				return false;
+			}
+			else
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+		cell->data = std::forward<_U>(_elem);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		++m_pushed;
+
+		// Pairs with the increment of m_sleepers in pop_batch() so a consumer about to park sees the element.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleepers.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> l(x_sleep);
+			m_cv.notify_one();
+		}
+		return true;
+	}
+
+	/// @returns false if the queue is empty.
+	bool try_pop(_T& o_elem)
+	{
+		Cell* cell;
+		size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &m_cells[pos & m_mask];
+			size_t const seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t const diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+		o_elem = std::move(cell->data);
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Appends up to @a _max elements to @a o_elems without blocking.
+	/// @returns the number of elements appended.
+	size_t try_pop_batch(std::vector<_T>& o_elems, size_t _max)
+	{
+		size_t n = 0;
+		_T elem;
+		while (n < _max && try_pop(elem))
+		{
+			o_elems.push_back(std::move(elem));
+			++n;
+		}
+		return n;
+	}
+
+	/// Appends up to @a _max elements to @a o_elems, waiting until at least one is available.
+	/// @returns the number of elements appended, or 0 once the queue has been closed.
+	size_t pop_batch(std::vector<_T>& o_elems, size_t _max)
+	{
+		while (!m_closed)
+		{
+			if (size_t n = try_pop_batch(o_elems, _max))
+				return n;
+			std::unique_lock<std::mutex> l(x_sleep);
+			if (m_closed)
+				return 0;
+			++m_sleepers;
+			m_cv.wait(l, [&](){ return depth() || m_closed; });
+			--m_sleepers;
+		}
+		return 0;
+	}
+
+	/// Wakes all waiting consumers; pop_batch() returns 0 from now on.
+	void close()
+	{
+		std::lock_guard<std::mutex> l(x_sleep);
+		m_closed = true;
+		m_cv.notify_all();
+	}
+
+	/// Drops everything currently queued.
+	void clear()
+	{
+		_T elem;
+		while (try_pop(elem)) {}
+	}
+
+	/// @returns the number of queued elements; approximate while producers or consumers are active.
+	size_t depth() const
+	{
+		size_t const enqueued = m_enqueuePos.load();
+		size_t const dequeued = m_dequeuePos.load();
+		return enqueued > dequeued ? enqueued - dequeued : 0;
+	}
+
+	bool empty() const { return !depth(); }
+	bool closed() const { return m_closed; }
+	size_t capacity() const { return m_mask + 1; }
+	/// @returns the number of elements accepted since construction.
+	size_t pushed() const { return m_pushed; }
+	/// @returns the number of elements refused because the queue was full.
+	size_t dropped() const { return m_dropped; }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		_T data;
+	};
+
+	static size_t roundUp(size_t _n)
+	{
+		size_t ret = 2;
+		while (ret < _n)
+			ret <<= 1;
+		return ret;
+	}
+
+	size_t const m_mask;
+	std::unique_ptr<Cell[]> m_cells;
+	std::atomic<size_t> m_enqueuePos = {0};
+	std::atomic<size_t> m_dequeuePos = {0};
+	std::atomic<size_t> m_pushed = {0};
+	std::atomic<size_t> m_dropped = {0};
+	std::atomic<unsigned> m_sleepers = {0};
+	std::atomic<bool> m_closed = {false};
+	std::mutex x_sleep;
+	std::condition_variable m_cv;
+};
+
+}
@@ -28,6 +28,10 @@ using namespace std;
 using namespace dev;
 using namespace eth;
 
+const int64_t Ethash::c_ticketLookahead;
+const unsigned Ethash::c_maxTicketParents;
+const unsigned Ethash::c_ticketWaitMs;
+
 void Ethash::init()
 {
 	ETH_REGISTER_SEAL_ENGINE(Ethash);
@@ -206,55 +210,181 @@ bool Ethash::verifySeal(BlockHeader const& _bi, BlockHeader const& _parent, Bala
     }
 }
 
+std::map<Address, u256> Ethash::agedBalances(BlockHeader const& _parent, BalanceRetriever _balanceRetriever) const
+{
+	std::map<Address, u256> ret;
+	for (auto const& kp: m_keyPairs)
+		ret[kp.address()] = getAgedBalance(kp.address(), (BlockNumber) _parent.number(), _balanceRetriever);
+	return ret;
+}
+
+StakeTickets Ethash::computeStakeTickets(BlockHeader const& _parent, int64_t _from, int64_t _to, std::map<Address, u256> const& _balances) const
+{
+	StakeTickets ret;
+	BlockHeader probe;
+	probe.setNumber(_parent.number() + 1);
+	for (int64_t timestamp = _from; timestamp <= _to; ++timestamp)
+	{
+		probe.setTimestamp(timestamp);
+		probe.setDifficulty(calculateDifficulty(probe, _parent));
+		StakeMessage const message = computeStakeMessage(stakeModifier(_parent), timestamp);
+		for (auto const& kp: m_keyPairs)
+		{
+			auto it = _balances.find(kp.address());
+			if (it == _balances.end() || it->second == 0)
+				continue;
+			StakeKeys::Signature const r = computeStakeSignature(message, kp.secret());
+			if (computeStakeSignatureHash(r) <= boundary(probe, it->second))
+				ret.push_back(StakeTicket{timestamp, kp, r});
+		}
+	}
+	return ret;
+}
+
+StakeTickets Ethash::stakeTickets(BlockHeader const& _parent, int64_t _from, int64_t _to, BalanceRetriever _balanceRetriever)
+{
+	h256 const parentHash = _parent.hash();
+	_from = max<int64_t>(_from, _parent.timestamp() + 1);
+	if (_from > _to)
+		return StakeTickets();
+
+	// Work out which part of the range isn't covered yet; the signing itself happens outside the lock.
+	std::map<Address, u256> balances;
+	int64_t lowTo = _to;
+	int64_t highFrom = _to + 1;
+	DEV_GUARDED(x_tickets)
+	{
+		auto it = m_tickets.find(parentHash);
+		if (it != m_tickets.end() && it->second.from <= _to && it->second.until >= _from)
+		{
+			balances = it->second.balances;
+			lowTo = it->second.from - 1;
+			highFrom = max(_from, it->second.until + 1);
+		}
+	}
+	if (balances.empty())
+		balances = agedBalances(_parent, _balanceRetriever);
+
+	StakeTickets fresh = computeStakeTickets(_parent, _from, lowTo, balances);
+	StakeTickets high = computeStakeTickets(_parent, highFrom, _to, balances);
+	fresh.insert(fresh.end(), high.begin(), high.end());
+
+	StakeTickets ret;
+	DEV_GUARDED(x_tickets)
+	{
+		auto it = m_tickets.find(parentHash);
+		if (it == m_tickets.end() || it->second.from > _to || it->second.until < _from)
+		{
+			// Nothing (contiguous) to merge with; start afresh, making room if need be.
+			if (it == m_tickets.end() && m_tickets.size() >= c_maxTicketParents)
+				m_tickets.erase(min_element(m_tickets.begin(), m_tickets.end(), [](std::pair<h256 const, ParentTickets> const& _a, std::pair<h256 const, ParentTickets> const& _b) { return _a.second.number < _b.second.number; }));
+			ParentTickets& p = m_tickets[parentHash];
+			p.number = (int64_t)_parent.number();
+			p.from = _from;
+			p.until = _to;
+			p.balances = balances;
+			p.tickets = move(fresh);
+			it = m_tickets.find(parentHash);
+		}
+		else
+		{
+			ParentTickets& p = it->second;
+			p.from = min(p.from, _from);
+			p.until = max(p.until, _to);
+			p.tickets.insert(p.tickets.end(), fresh.begin(), fresh.end());
+			// Another thread may have covered the same range meanwhile.
+			sort(p.tickets.begin(), p.tickets.end(), [](StakeTicket const& _a, StakeTicket const& _b) { return _a.timestamp < _b.timestamp || (_a.timestamp == _b.timestamp && _a.key.address() < _b.key.address()); });
+			p.tickets.erase(unique(p.tickets.begin(), p.tickets.end(), [](StakeTicket const& _a, StakeTicket const& _b) { return _a.timestamp == _b.timestamp && _a.key.address() == _b.key.address(); }), p.tickets.end());
+		}
+		for (auto const& t: it->second.tickets)
+			if (t.timestamp >= _from && t.timestamp <= _to)
+				ret.push_back(t);
+	}
+	return ret;
+}
+
+void Ethash::prepareSeal(BlockHeader const& _parent, BalanceRetriever _balanceRetriever)
+{
+	int64_t const from = max<int64_t>(utcTime() - 1, _parent.timestamp() + 1);
+	stakeTickets(_parent, from, from + c_ticketLookahead, _balanceRetriever);
+}
+
+void Ethash::sealWithTicket(BlockHeader& _bi, BlockHeader const& _parent, StakeTicket const& _ticket) const
+{
+	_bi.setTimestamp(_ticket.timestamp);
+	_bi.setDifficulty(calculateDifficulty(_bi, _parent));
+	setStakeModifier(_bi, computeChildStakeModifier(stakeModifier(_parent), _ticket.key.pub(), _ticket.signature));
+	setPublicKey(_bi, _ticket.key.pub());
+	setStakeSignature(_bi, _ticket.signature);
+	setBlockSignature(_bi, sign<BLS>(_ticket.key.secret(), _bi.hash(WithoutSeal)));
+}
+
+Ethash::~Ethash()
+{
+	m_generating = false;
+	if (sealThread.joinable())
+		sealThread.join();
+}
+
 void Ethash::generateSeal(BlockHeader _bi, BlockHeader const& parent, BalanceRetriever balanceRetriever)
 {
-    clog << " generate seal for " << _bi.number() << " m_parent.number: " << parent.number() << "\n";
-      if (!m_generating || (m_sealing.hash(WithoutSeal) != _bi.hash(WithoutSeal))) {
-
-        Guard l(m_submitLock);
-        if (sealThread.joinable()) sealThread.join();
-        m_sealing = _bi;
-        m_generating = true;
-        sealThread = std::thread([balanceRetriever, parent, this](){
-
-            std::map<Address, u256> balanceMap;
-            for (auto kp: m_keyPairs) balanceMap.insert(std::make_pair(kp.address(), getAgedBalance(kp.address(), (BlockNumber) parent.number(), balanceRetriever)));
-	
-	        int64_t currentTime = utcTime();
-
-            for (int64_t timestamp = currentTime; timestamp > (currentTime - 2); timestamp--){
-
-                m_sealing.setTimestamp(timestamp);
-                m_sealing.setDifficulty(calculateDifficulty(m_sealing, parent));
-                for (auto kp: m_keyPairs) {
-                    u256 balance = balanceMap.find(kp.address())->second;
-                    if (balance != (u256) 0) {
-                        clog << "[parent ts: " << parent.timestamp() << " ts: " << timestamp << " delta:" << (timestamp - parent.timestamp()) << "]" << std::endl;
-                        const StakeKeys::Signature r = computeStakeSignature(computeStakeMessage(stakeModifier(parent), timestamp), kp.secret());
-                        if (computeStakeSignatureHash(r) <= boundary(m_sealing, balance)) {
-                            std::unique_lock<Mutex> l(m_submitLock);
-                            setStakeModifier(m_sealing, computeChildStakeModifier(stakeModifier(parent), kp.pub(), r));
-                            setPublicKey(m_sealing, kp.pub());
-                            setStakeSignature(m_sealing, r);
-                            setBlockSignature(m_sealing, sign<BLS>(kp.secret(), m_sealing.hash(WithoutSeal)));
-
-                            if (m_onSealGenerated)
-                            {
-                                assert(verifySeal(m_sealing, parent, balanceRetriever));
-                                RLPStream ret;
-                                m_sealing.streamRLP(ret);
-                                l.unlock();
-                                m_onSealGenerated(ret.out());
-                            }
-                            m_generating = false;
-                            return true;
-                        }
-                    }
-                }
-            }
-            return true;
-        });
-    }
+	Guard l(m_sealThreadLock);
+	// m_sealing gets its timestamp and seal filled in, so compare against what we were asked for.
+	if (m_generating && m_sealingRequest.hash(WithoutSeal) == _bi.hash(WithoutSeal))
+		return;
+
+	clog << " generate seal for " << _bi.number() << " m_parent.number: " << parent.number() << "\n";
+	m_generating = false;
+	if (sealThread.joinable())
+		sealThread.join();
+	m_sealingRequest = _bi;
+	m_generating = true;
+	// The client may install a new callback while this seal is still being waited for; keep the one we were started with.
+	auto onSealGenerated = m_onSealGenerated;
+	sealThread = std::thread([=]() mutable
+	{
+		// Tickets for this parent have usually been found by prepareSeal() while it was still in the block queue.
+		// If not, sign only for the seconds we could publish in right now, and look further ahead only if neither is ours.
+		int64_t const now = utcTime();
+		int64_t const from = max<int64_t>(now - 1, parent.timestamp() + 1);
+		StakeTickets tickets = stakeTickets(parent, from, now, balanceRetriever);
+		if (tickets.empty())
+			tickets = stakeTickets(parent, from, from + c_ticketLookahead, balanceRetriever);
+
+		// As before, prefer the latest ticket we may publish right now; otherwise wait for the earliest one to come due.
+		StakeTicket const* ticket = nullptr;
+		for (auto const& t: tickets)
+			if (t.timestamp <= now)
+				ticket = &t;
+			else
+			{
+				if (!ticket)
+					ticket = &t;
+				break;
+			}
+		if (!ticket)
+		{
+			m_generating = false;
+			return;
+		}
+		clog << "[parent ts: " << parent.timestamp() << " ts: " << ticket->timestamp << " delta:" << (ticket->timestamp - parent.timestamp()) << "]" << std::endl;
+		while (m_generating && utcTime() < ticket->timestamp)
+			this_thread::sleep_for(chrono::milliseconds(c_ticketWaitMs));
+		if (!m_generating)
+			return;
+
+		sealWithTicket(_bi, parent, *ticket);
+		assert(verifySeal(_bi, parent, balanceRetriever));
+		DEV_GUARDED(m_submitLock)
+			m_sealing = _bi;
+		if (onSealGenerated)
+		{
+			RLPStream ret;
+			_bi.streamRLP(ret);
+			onSealGenerated(ret.out());
+		}
+		m_generating = false;
+	});
 }
 
 bool Ethash::shouldSeal(Interface*)
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <map>
 #include <thread>
 
 #include <libethcore/SealEngine.h>
@@ -37,9 +39,21 @@ namespace eth
 {
 
 
+/// A precomputed right to seal: the stake signature of one of our keys over a parent's stake modifier
+/// and a timestamp, already known to meet the boundary for that timestamp.
+struct StakeTicket
+{
+	int64_t timestamp;
+	KeyPair<BLS> key;
+	StakeKeys::Signature signature;
+};
+using StakeTickets = std::vector<StakeTicket>;
+
 class Ethash: public SealEngineBase
 {
 public:
+	~Ethash();
+
 	std::string name() const override { return "PoS v4"; }
 	unsigned revision() const override { return 1; }
     enum { PublicKeyField, StakeModifierField, StakeSignatureField, BlockSignatureField, SealFieldCount };
@@ -62,6 +76,7 @@ public:
 	void setSealer(std::string const& _sealer) override { m_sealer = _sealer; }
     void cancelGeneration() override { m_generating = false; }
     void generateSeal(BlockHeader _bi, BlockHeader const& parent, BalanceRetriever balanceRetriever) override;
+	void prepareSeal(BlockHeader const& _parent, BalanceRetriever _balanceRetriever) override;
 	bool shouldSeal(Interface* _i) override;
 
     static StakeKeys::Public publicKey(BlockHeader const& _bi) { return _bi.seal<StakeKeys::Public>(PublicKeyField); }
@@ -78,6 +93,10 @@ public:
     u256 calculateDifficulty(BlockHeader const& _bi, BlockHeader const& parent) const;
     u256 childGasLimit(BlockHeader const& _bi, u256 const& _gasFloorTarget = Invalid256) const;
 
+	/// @returns the tickets our keys hold for sealing on @a _parent at timestamps in [@a _from, @a _to], earliest first.
+	/// Results are cached per parent, so only the part of the range not seen before is signed.
+	StakeTickets stakeTickets(BlockHeader const& _parent, int64_t _from, int64_t _to, BalanceRetriever _balanceRetriever);
+
 	void manuallySetWork(BlockHeader const& _work) { m_sealing = _work; }
 
 	static void init();
@@ -86,17 +105,38 @@ public:
 private:
     u256 getAgedBalance(Address a, BlockNumber bn, BalanceRetriever balanceRetriever) const;
     bool verifySeal(BlockHeader const& _bi, BlockHeader const& m_parent, BalanceRetriever balanceRetriever) const;
+	StakeTickets computeStakeTickets(BlockHeader const& _parent, int64_t _from, int64_t _to, std::map<Address, u256> const& _balances) const;
+	std::map<Address, u256> agedBalances(BlockHeader const& _parent, BalanceRetriever _balanceRetriever) const;
+	void sealWithTicket(BlockHeader& _bi, BlockHeader const& _parent, StakeTicket const& _ticket) const;
+
+	/// Stake tickets computed for one parent, covering timestamps [from, until].
+	struct ParentTickets
+	{
+		int64_t number = 0;
+		int64_t from = 0;
+		int64_t until = -1;
+		std::map<Address, u256> balances;
+		StakeTickets tickets;
+	};
+
+	static const int64_t c_ticketLookahead = 30;		///< Seconds past the earliest usable timestamp to find tickets for.
+	static const unsigned c_maxTicketParents = 8;		///< Number of parents to keep tickets for.
+	static const unsigned c_ticketWaitMs = 50;			///< Granularity at which a sealing thread waits for its ticket's second.
 
 	std::string m_sealer = "cpu";
     BlockHeader m_sealing;
+	BlockHeader m_sealingRequest;		///< The header generateSeal() was last asked to seal, before we filled in timestamp and seal.
 
     //StakeModifier m_parentStakeModifier;
     u256 minimalTimeStamp(BlockHeader const& parent) { return parent.timestamp() + 1; }
 
-    bool m_generating = false;
+    std::atomic<bool> m_generating = { false };
     std::thread sealThread;
-	/// A mutex covering m_sealing
+	/// A mutex covering m_sealing and one covering sealThread and m_sealingRequest
     Mutex m_submitLock, m_sealThreadLock;
+
+	mutable Mutex x_tickets;
+	std::map<h256, ParentTickets> m_tickets;	///< Stake tickets by parent hash.
 };
 
 }
@@ -109,6 +109,7 @@ public:
     u256 istanbulForkBlock = c_infiniteBlockNumber;
     u256 constantinopleFixForkBlock = c_infiniteBlockNumber;
     u256 eWASMForkBlock = c_infiniteBlockNumber;
+	u256 signatureVerificationForkBlock = c_infiniteBlockNumber;	///< From here on blocks may only carry transactions whose BLS signature verifies.
 
 	/// Precompiled contracts as specified in the chain params.
 	std::unordered_map<Address, PrecompiledContract> precompiled;
@@ -37,7 +37,7 @@ namespace dev
 namespace eth
 {
 
-const unsigned c_protocolVersion = 63;
+const unsigned c_protocolVersion = 64;
 #if ETH_FATDB
 const unsigned c_minorProtocolVersion = 3;
 const unsigned c_databaseBaseVersion = 9;
@@ -113,6 +113,7 @@ struct ImportRoute
 	h256s deadBlocks;
 	h256s liveBlocks;
 	std::vector<Transaction> goodTranactions;
+	AddressHash touchedAccounts;	///< Accounts changed by the live blocks; only meaningful when there are no dead blocks.
 };
 
 enum class ImportResult
@@ -126,7 +127,10 @@ enum class ImportResult
 	Malformed,
 	OverbidGasPrice,
 	BadChain,
-	ZeroSignature
+	ZeroSignature,
+	NonceTooLow,
+	InsufficientBalance,
+	Aborted
 };
 
 struct ImportRequirements
@@ -55,6 +55,9 @@ void SealEngineFace::verifyTransaction(ImportRequirements::value _ir, Transactio
 
 	if (_header.number() >= chainParams().homesteadForkBlock && (_ir & ImportRequirements::TransactionSignatures) && _t.hasSignature())
 		_t.checkLowS();
+
+	if (_header.number() >= chainParams().signatureVerificationForkBlock && (_ir & ImportRequirements::TransactionSignatures) && _t.hasSignature())
+		_t.checkSignature();
 }
 
 SealEngineFace* SealEngineRegistrar::create(ChainOperationParams const& _params)
@@ -77,6 +77,9 @@ public:
     virtual void generateSeal(BlockHeader _bi, BlockHeader const& parent, BalanceRetriever balanceRetriever) = 0;
 	virtual void onSealGenerated(std::function<void(bytes const& s)> const& _f) = 0;
 	virtual void cancelGeneration() {}
+	/// Called as soon as a probable next parent is known (e.g. verified but not yet imported) so that any
+	/// sealing work which depends only on the parent header can be done ahead of generateSeal().
+	virtual void prepareSeal(BlockHeader const&, BalanceRetriever) {}
 
 	ChainOperationParams const& chainParams() const { return m_params; }
 	void setChainParams(ChainOperationParams const& _params) { m_params = _params; }
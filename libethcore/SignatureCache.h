@@ -0,0 +1,118 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SignatureCache.h
+ * @date 2026
+ */
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <atomic>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/Guards.h>
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief Thread-safe, bounded set of transaction hashes whose signatures have been verified.
+ * Shared by the transaction queue, the block queue and block import so that a transaction
+ * is only pairing-checked by whichever of them sees it first. The hash covers the payload,
+ * the signature and the public key, so a hit implies the very same signature verified before.
+ * Each shard evicts its oldest entries once full.
+ */
+class SignatureCache
+{
+public:
+	bool contains(h256 const& _hash) const
+	{
+		Shard const& s = shard(_hash);
+		bool ret = false;
+		DEV_READ_GUARDED(s.x_hashes)
+			ret = s.hashes.count(_hash);
+		if (ret)
+			++m_hits;
+		else
+			++m_misses;
+		return ret;
+	}
+
+	void store(h256 const& _hash)
+	{
+		Shard& s = shard(_hash);
+		WriteGuard l(s.x_hashes);
+		if (!s.hashes.insert(_hash).second)
+			return;
+		s.order.push_back(_hash);
+		while (s.order.size() > c_maxSize / c_shards)
+		{
+			s.hashes.erase(s.order.front());
+			s.order.pop_front();
+		}
+	}
+
+	size_t size() const
+	{
+		size_t ret = 0;
+		for (Shard const& s: m_shards)
+			DEV_READ_GUARDED(s.x_hashes)
+				ret += s.hashes.size();
+		return ret;
+	}
+
+	void clear()
+	{
+		for (Shard& s: m_shards)
+			DEV_WRITE_GUARDED(s.x_hashes)
+			{
+				s.hashes.clear();
+				s.order.clear();
+			}
+		m_hits = 0;
+		m_misses = 0;
+	}
+
+	unsigned hits() const { return m_hits; }
+	unsigned misses() const { return m_misses; }
+
+	static SignatureCache& instance() { static SignatureCache cache; return cache; }
+
+	static const size_t c_maxSize = 65536;
+
+private:
+	struct Shard
+	{
+		mutable SharedMutex x_hashes;
+		h256Hash hashes;
+		std::deque<h256> order;
+	};
+
+	static const size_t c_shards = 16;
+
+	Shard& shard(h256 const& _hash) { return m_shards[_hash[0] % c_shards]; }
+	Shard const& shard(h256 const& _hash) const { return m_shards[_hash[0] % c_shards]; }
+
+	std::array<Shard, c_shards> m_shards;
+	mutable std::atomic<unsigned> m_hits{0};
+	mutable std::atomic<unsigned> m_misses{0};
+};
+
+}
+}
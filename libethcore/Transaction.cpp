@@ -23,6 +23,7 @@
 #include <libdevcore/Log.h>
 #include <libdevcrypto/Common.h>
 #include <libethcore/Exceptions.h>
+#include "SignatureCache.h"
 #include "Transaction.h"
 #include "EVMSchedule.h"
 
@@ -112,6 +113,29 @@ void TransactionBase::checkLowS() const
 		BOOST_THROW_EXCEPTION(InvalidSignature());
 }
 
+void TransactionBase::checkSignature() const
+{
+	if (!m_vrs)
+		BOOST_THROW_EXCEPTION(TransactionIsUnsigned());
+
+	// A zero signature is only the mark of a keyless transaction, which SealEngineFace::verifyTransaction
+	// rules on; with a key it is merely a signature that does not verify.
+	if (m_vrs->isZero())
+	{
+		if (m_vrs->publicKey)
+			BOOST_THROW_EXCEPTION(InvalidSignature());
+		return;
+	}
+
+	SignatureCache& cache = SignatureCache::instance();
+	h256 const h = sha3(WithSignature);
+	if (cache.contains(h))
+		return;
+	if (!verify<AccountKeys::Type>(m_vrs->publicKey, *m_vrs, sha3(WithoutSignature)))
+		BOOST_THROW_EXCEPTION(InvalidSignature());
+	cache.store(h);
+}
+
 int64_t TransactionBase::baseGasRequired(bool _contractCreation, bytesConstRef _data, EVMSchedule const& _es)
 {
 	int64_t g = _contractCreation ? _es.txCreateGas : _es.txGas;
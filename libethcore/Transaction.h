@@ -82,6 +82,11 @@ public:
 	/// @throws InvalidSValue if the signature has an invalid S value.
     void checkLowS() const;
 
+	/// Verifies the signature against the embedded public key, consulting SignatureCache first.
+	/// @throws TransactionIsUnsigned if signature was not initialized
+	/// @throws InvalidSignature if the signature does not verify, or is zero yet comes with a public key.
+	void checkSignature() const;
+
 	/// @returns true if transaction is non-null.
 	explicit operator bool() const { return m_type != NullTransaction; }
 
@@ -91,6 +91,8 @@ Block::Block(Block const& _s):
 	m_transactions(_s.m_transactions),
 	m_receipts(_s.m_receipts),
 	m_transactionSet(_s.m_transactionSet),
+	m_queueSynced(_s.m_queueSynced),
+	m_gasLimited(_s.m_gasLimited),
 	m_precommit(_s.m_state),
 	m_previousBlock(_s.m_previousBlock),
 	m_currentBlock(_s.m_currentBlock),
@@ -110,6 +112,8 @@ Block& Block::operator=(Block const& _s)
 	m_transactions = _s.m_transactions;
 	m_receipts = _s.m_receipts;
 	m_transactionSet = _s.m_transactionSet;
+	m_queueSynced = _s.m_queueSynced;
+	m_gasLimited = _s.m_gasLimited;
 	m_previousBlock = _s.m_previousBlock;
 	m_currentBlock = _s.m_currentBlock;
 	m_currentBytes = _s.m_currentBytes;
@@ -126,6 +130,8 @@ void Block::resetCurrent(int64_t const& _timestamp)
 	m_transactions.clear();
 	m_receipts.clear();
 	m_transactionSet.clear();
+	m_queueSynced = false;
+	m_gasLimited.clear();
 	m_currentBlock = BlockHeader();
     m_currentBlock.setAuthor(m_author);
 	m_currentBlock.setTimestamp(std::max(m_previousBlock.timestamp() + 1, _timestamp));
@@ -329,75 +335,12 @@ pair<TransactionReceipts, bool> Block::sync(BlockChain const& _bc, TransactionQu
 	for (int goodTxs = max(0, (int)ts.size() - 1); goodTxs < (int)ts.size(); )
 	{
 		goodTxs = 0;
+		u256 const ask = _gp.ask(*this);
 		for (auto const& t: ts)
-			if (!m_transactionSet.count(t.sha3()))
+			if (!m_transactionSet.count(t.sha3()) && syncTransaction(_bc, _tq, t, ask))
 			{
-				try
-				{
-					if (t.gasPrice() >= _gp.ask(*this))
-					{
-//						Timer t;
-						execute(_bc.lastBlockHashes(), t);
-						ret.first.push_back(m_receipts.back());
-						++goodTxs;
-//						cnote << "TX took:" << t.elapsed() * 1000;
-					}
-					else if (t.gasPrice() < _gp.ask(*this) * 9 / 10)
-					{
-						clog(StateTrace) << t.sha3() << "Dropping El Cheapo transaction (<90% of ask price)";
-						_tq.drop(t.sha3());
-					}
-				}
-				catch (InvalidNonce const& in)
-				{
-					bigint const& req = *boost::get_error_info<errinfo_required>(in);
-					bigint const& got = *boost::get_error_info<errinfo_got>(in);
-
-					if (req > got)
-					{
-						// too old
-						clog(StateTrace) << t.sha3() << "Dropping old transaction (nonce too low)";
-						_tq.drop(t.sha3());
-					}
-					else if (got > req + _tq.waiting(t.sender()))
-					{
-						// too new
-						clog(StateTrace) << t.sha3() << "Dropping new transaction (too many nonces ahead)";
-						_tq.drop(t.sha3());
-					}
-					else
-						_tq.setFuture(t.sha3());
-				}
-				catch (BlockGasLimitReached const& e)
-				{
-					bigint const& got = *boost::get_error_info<errinfo_got>(e);
-					if (got > m_currentBlock.gasLimit())
-					{
-						clog(StateTrace) << t.sha3() << "Dropping over-gassy transaction (gas > block's gas limit)";
-						clog(StateTrace) << "got: " << got << " required: " << m_currentBlock.gasLimit();
-						_tq.drop(t.sha3());
-					}
-					else
-					{
-						clog(StateTrace) << t.sha3() << "Temporarily no gas left in current block (txs gas > block's gas limit)";
-						//_tq.drop(t.sha3());
-						// Temporarily no gas left in current block.
-						// OPTIMISE: could note this and then we don't evaluate until a block that does have the gas left.
-						// for now, just leave alone.
-					}
-				}
-				catch (Exception const& _e)
-				{
-					// Something else went wrong - drop it.
-					clog(StateTrace) << t.sha3() << "Dropping invalid transaction:" << diagnostic_information(_e);
-					_tq.drop(t.sha3());
-				}
-				catch (std::exception const&)
-				{
-					// Something else went wrong - drop it.
-					_tq.drop(t.sha3());
-					cwarn << t.sha3() << "Transaction caused low-level exception :(";
-				}
+				ret.first.push_back(m_receipts.back());
+				++goodTxs;
 			}
 		if (chrono::steady_clock::now() > deadline)
 		{
@@ -405,9 +348,106 @@ pair<TransactionReceipts, bool> Block::sync(BlockChain const& _bc, TransactionQu
 			break;
 		}
 	}
+	m_queueSynced = !ret.second;
+	return ret;
+}
+
+pair<TransactionReceipts, bool> Block::syncArrived(BlockChain const& _bc, TransactionQueue& _tq, GasPricer const& _gp, Transactions const& _arrived, unsigned msTimeout)
+{
+	if (!m_queueSynced)
+		return sync(_bc, _tq, _gp, msTimeout);
+
+	if (isSealed())
+		BOOST_THROW_EXCEPTION(InvalidOperationOnSealedBlock());
+
+	pair<TransactionReceipts, bool> ret;
+	assert(_bc.currentHash() == m_currentBlock.parentHash());
+	auto deadline =  chrono::steady_clock::now() + chrono::milliseconds(msTimeout);
+
+	u256 const ask = _gp.ask(*this);
+	for (auto const& t: _arrived)
+	{
+		if (!m_transactionSet.count(t.sha3()) && syncTransaction(_bc, _tq, t, ask))
+			ret.first.push_back(m_receipts.back());
+		if (chrono::steady_clock::now() > deadline)
+		{
+			// The rest of _arrived is lost; go through the whole queue next time.
+			m_queueSynced = false;
+			ret.second = true;
+			break;
+		}
+	}
 	return ret;
 }
 
+bool Block::syncTransaction(BlockChain const& _bc, TransactionQueue& _tq, Transaction const& _t, u256 const& _ask)
+{
+	try
+	{
+		if (!m_gasLimited.empty() && m_gasLimited.count(_t.sender()))
+			return false;
+		if (_t.gasPrice() >= _ask)
+		{
+			execute(_bc.lastBlockHashes(), _t);
+			return true;
+		}
+		else if (_t.gasPrice() < _ask * 9 / 10)
+		{
+			clog(StateTrace) << _t.sha3() << "Dropping El Cheapo transaction (<90% of ask price)";
+			_tq.drop(_t.sha3());
+		}
+	}
+	catch (InvalidNonce const& in)
+	{
+		bigint const& req = *boost::get_error_info<errinfo_required>(in);
+		bigint const& got = *boost::get_error_info<errinfo_got>(in);
+
+		if (req > got)
+		{
+			// too old
+			clog(StateTrace) << _t.sha3() << "Dropping old transaction (nonce too low)";
+			_tq.drop(_t.sha3());
+		}
+		else if (got > req + _tq.waiting(_t.sender()))
+		{
+			// too new
+			clog(StateTrace) << _t.sha3() << "Dropping new transaction (too many nonces ahead)";
+			_tq.drop(_t.sha3());
+		}
+		else
+			_tq.setFuture(_t.sha3());
+	}
+	catch (BlockGasLimitReached const& e)
+	{
+		bigint const& got = *boost::get_error_info<errinfo_got>(e);
+		if (got > m_currentBlock.gasLimit())
+		{
+			clog(StateTrace) << _t.sha3() << "Dropping over-gassy transaction (gas > block's gas limit)";
+			clog(StateTrace) << "got: " << got << " required: " << m_currentBlock.gasLimit();
+			_tq.drop(_t.sha3());
+		}
+		else
+		{
+			clog(StateTrace) << _t.sha3() << "Temporarily no gas left in current block (txs gas > block's gas limit)";
+			// Gas left only shrinks and the sender's later nonces depend on this one, so skip the sender until the block is reset.
+			m_gasLimited.insert(_t.sender());
+		}
+	}
+	catch (Exception const& _e)
+	{
+		// Something else went wrong - drop it.
+		clog(StateTrace) << _t.sha3() << "Dropping invalid transaction:" << diagnostic_information(_e);
+		_tq.drop(_t.sha3());
+	}
+	catch (std::exception const&)
+	{
+		// Something else went wrong - drop it.
+		_tq.drop(_t.sha3());
+		cwarn << _t.sha3() << "Transaction caused low-level exception :(";
+	}
+	return false;
+}
+
 u256 Block::enactOn(VerifiedBlockRef const& _block, BlockChain const& _bc)
 {
 	noteChain(_bc);
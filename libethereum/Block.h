@@ -225,6 +225,11 @@ public:
 	/// @returns a list of receipts one for each transaction placed from the queue into the state and bool, true iff there are more transactions to be processed.
 	std::pair<TransactionReceipts, bool> sync(BlockChain const& _bc, TransactionQueue& _tq, GasPricer const& _gp, unsigned _msTimeout = 100);
 
+	/// Append the transactions that became current in the queue since the last call, in the order they did so.
+	/// Falls back to the full sync() above unless that has gone through the whole queue since the block was last reset.
+	/// @returns a list of receipts one for each transaction placed from the queue into the state and bool, true iff there are more transactions to be processed.
+	std::pair<TransactionReceipts, bool> syncArrived(BlockChain const& _bc, TransactionQueue& _tq, GasPricer const& _gp, Transactions const& _arrived, unsigned _msTimeout = 100);
+
 	/// Sync our state with the block chain.
 	/// This basically involves wiping ourselves if we've been superceded and rebuilding from the transaction queue.
 	bool sync(BlockChain const& _bc);
@@ -299,6 +304,10 @@ private:
 	/// @returns gas used by transactions thus far executed.
 	u256 gasUsed() const { return m_receipts.size() ? m_receipts.back().gasUsed() : 0; }
 
+	/// Try to execute a transaction from the queue, dropping it from or deferring it in @a _tq if it cannot go in.
+	/// @returns true iff it was appended to the block.
+	bool syncTransaction(BlockChain const& _bc, TransactionQueue& _tq, Transaction const& _t, u256 const& _ask);
+
 	/// Performs irregular modifications right after initialization, e.g. to implement a hard fork.
 	void performIrregularModifications();
 
@@ -309,6 +318,8 @@ private:
 	Transactions m_transactions;				///< The current list of transactions that we've included in the state.
 	TransactionReceipts m_receipts;				///< The corresponding list of transaction receipts.
 	h256Hash m_transactionSet;					///< The set of transaction hashes that we've included in the state.
+	bool m_queueSynced = false;					///< Has sync() gone through the whole transaction queue since the last reset?
+	AddressHash m_gasLimited;					///< Senders whose next transaction did not fit into the gas left in the block.
 	State m_precommit;							///< State at the point immediately prior to rewards.
 
 	BlockHeader m_previousBlock;				///< The previous block's information.
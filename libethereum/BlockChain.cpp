@@ -456,6 +456,7 @@ tuple<ImportRoute, bool, unsigned> BlockChain::sync(BlockQueue& _bq, OverlayDB c
 	h256s dead;
 	h256s badBlocks;
 	Transactions goodTransactions;
+	AddressHash touched;
 	unsigned count = 0;
 	for (VerifiedBlock const& block: blocks)
 	{
@@ -470,6 +471,7 @@ tuple<ImportRoute, bool, unsigned> BlockChain::sync(BlockQueue& _bq, OverlayDB c
 				dead += r.deadBlocks;
 				goodTransactions.reserve(goodTransactions.size() + r.goodTranactions.size());
 				std::move(std::begin(r.goodTranactions), std::end(r.goodTranactions), std::back_inserter(goodTransactions));
+				touched += r.touchedAccounts;
 				++count;
 			}
 			catch (dev::eth::AlreadyHaveBlock const&)
@@ -506,7 +508,7 @@ tuple<ImportRoute, bool, unsigned> BlockChain::sync(BlockQueue& _bq, OverlayDB c
 			}
 		} while (false);
 	}
-	return make_tuple(ImportRoute{dead, fresh, goodTransactions}, _bq.doneDrain(badBlocks), count);
+	return make_tuple(ImportRoute{dead, fresh, goodTransactions, touched}, _bq.doneDrain(badBlocks), count);
 }
 
 pair<ImportResult, ImportRoute> BlockChain::attemptImport(bytes const& _block, OverlayDB const& _stateDB, bool _mustBeNew) noexcept
@@ -688,6 +690,7 @@ ImportRoute BlockChain::import(VerifiedBlockRef const& _block, OverlayDB const&
 
 	BlockReceipts br;
 	u256 td;
+	AddressHash touched;
 	try
 	{
 		// Check transactions are valid and that they result in a state equivalent to our state_root.
@@ -699,6 +702,7 @@ ImportRoute BlockChain::import(VerifiedBlockRef const& _block, OverlayDB const&
 			br.receipts.push_back(s.receipt(i));
 
 		s.cleanup();
+		touched = s.state().touched();
 
 		td = pd.totalDifficulty + tdIncrease;
 
@@ -723,7 +727,10 @@ ImportRoute BlockChain::import(VerifiedBlockRef const& _block, OverlayDB const&
 
 	// All ok - insert into DB
 	bytes const receipts = br.rlp();
-	return insertBlockAndExtras(_block, ref(receipts), td, performanceLogger);
+	ImportRoute ret = insertBlockAndExtras(_block, ref(receipts), td, performanceLogger);
+	if (!ret.liveBlocks.empty())
+		ret.touchedAccounts = move(touched);
+	return ret;
 }
 
 ImportRoute BlockChain::insertWithoutParent(bytes const& _block, OverlayDB const& _db, bytesConstRef _receipts, u256 const& _totalDifficulty)
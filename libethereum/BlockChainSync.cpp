@@ -31,6 +31,7 @@
 #include "BlockQueue.h"
 #include "EthereumPeer.h"
 #include "EthereumHost.h"
+#include "SnapshotDownloader.h"
 
 using namespace std;
 using namespace dev;
@@ -40,6 +41,34 @@ using namespace p2p;
 unsigned const c_maxPeerUknownNewBlocks = 1024; /// Max number of unknown new blocks peer can give us
 unsigned const c_maxRequestHeaders = 1024;
 unsigned const c_maxRequestBodies = 1024;
+unsigned const c_minRequestHeaders = 32;
+unsigned const c_minRequestBodies = 16;
+unsigned const c_initialRequestHeaders = 192;
+unsigned const c_initialRequestBodies = 128;
+unsigned const c_skeletonSpan = 192;			///< Distance between skeleton anchor headers
+unsigned const c_maxSkeletonHeaders = 128;		///< Anchors requested in one skeleton request
+
+constexpr std::chrono::milliseconds SyncThroughput::c_targetResponseTime;
+
+void SyncThroughput::requested(unsigned _count, Clock::time_point _at)
+{
+	m_pending = _count;
+	m_requested = _at;
+}
+
+void SyncThroughput::received(unsigned _count, Clock::time_point _at)
+{
+	if (!m_pending)
+		return;
+	double elapsed = std::max(std::chrono::duration<double>(_at - m_requested).count(), 0.001);
+	double rate = _count / elapsed;
+	m_rate = m_rate == 0 ? rate : m_rate * 0.7 + rate * 0.3;
+	// Grow at most twofold per response so a single fast answer cannot swamp a peer.
+	double target = m_rate * std::chrono::duration<double>(c_targetResponseTime).count();
+	double size = std::min(target, 2.0 * m_pending);
+	m_size = static_cast<unsigned>(std::max<double>(m_min, std::min<double>(m_max, size)));
+	m_pending = 0;
+}
 
 
 std::ostream& dev::eth::operator<<(std::ostream& _out, SyncStatus const& _sync)
@@ -210,7 +239,7 @@ void BlockChainSync::onPeerStatus(std::shared_ptr<EthereumPeer> _peer)
 		return; // Expired
 	if (_peer->m_genesisHash != host().chain().genesisHash())
 		_peer->disable("Invalid genesis hash");
-	else if (_peer->m_protocolVersion != host().protocolVersion() && _peer->m_protocolVersion != EthereumHost::c_oldProtocolVersion)
+	else if (_peer->m_protocolVersion != host().protocolVersion() && _peer->m_protocolVersion != EthereumHost::c_previousProtocolVersion && _peer->m_protocolVersion != EthereumHost::c_oldProtocolVersion)
 		_peer->disable("Invalid protocol version.");
 	else if (_peer->m_networkId != host().networkId())
 		_peer->disable("Invalid network identifier.");
@@ -232,6 +261,14 @@ void BlockChainSync::syncPeer(std::shared_ptr<EthereumPeer> _peer, bool _force)
 		return;
 	}
 
+	if (auto downloader = host().snapshotDownloader())
+	{
+		// State comes from the snapshot; blocks resume once it is imported.
+		m_state = SyncState::State;
+		downloader->requestNext(_peer);
+		return;
+	}
+
 	if (m_state == SyncState::Waiting)
 		return;
 
@@ -278,13 +315,15 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 		return;
 	}
 	// check to see if we need to download any block bodies first
+	PeerThroughput& peerThroughput = throughput(_peer);
 	auto header = m_headers.begin();
 	h256s neededBodies;
 	vector<unsigned> neededNumbers;
 	unsigned index = 0;
 	if (m_haveCommonHeader && !m_headers.empty() && m_headers.begin()->first == m_lastImportedBlock + 1)
 	{
-		while (header != m_headers.end() && neededBodies.size() < c_maxRequestBodies && index < header->second.size())
+		unsigned const maxBodies = peerThroughput.bodies.requestSize();
+		while (header != m_headers.end() && neededBodies.size() < maxBodies && index < header->second.size())
 		{
 			unsigned block = header->first + index;
 			if (m_downloadingBodies.count(block) == 0 && !haveItem(m_bodies, block))
@@ -302,6 +341,7 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 	if (neededBodies.size() > 0)
 	{
 		m_bodySyncPeers[_peer] = neededNumbers;
+		peerThroughput.bodies.requested(neededBodies.size());
 		_peer->requestBlockBodies(neededBodies);
 	}
 	else
@@ -331,26 +371,33 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 				++next;
 			}
 
+			// Lay anchors across a long gap first, so that the headers between them can be
+			// fetched from many peers at once and checked against both ends.
+			if (next != m_headers.end() && requestSkeleton(_peer, start, next->first))
+				return;
+
+			unsigned const maxHeaders = peerThroughput.headers.requestSize();
 			while (count == 0 && next != m_headers.end())
 			{
-				count = std::min(c_maxRequestHeaders, next->first - start);
+				count = std::min(maxHeaders, next->first - start);
 				while(count > 0 && m_downloadingHeaders.count(start) != 0)
 				{
 					start++;
 					count--;
 				}
+				// The request is for a contiguous range, so stop at the next header somebody else is fetching.
 				std::vector<unsigned> headers;
-				for (unsigned block = start; block < start + count; block++)
-					if (m_downloadingHeaders.count(block) == 0)
-					{
-						headers.push_back(block);
-						m_downloadingHeaders.insert(block);
-					}
+				for (unsigned block = start; block < start + count && m_downloadingHeaders.count(block) == 0; block++)
+				{
+					headers.push_back(block);
+					m_downloadingHeaders.insert(block);
+				}
 				count = headers.size();
 				if (count > 0)
 				{
 					m_headerSyncPeers[_peer] = headers;
 					assert(!haveItem(m_headers, start));
+					peerThroughput.headers.requested(count);
 					_peer->requestBlockHeaders(start, count, 0, false);
 				}
 				else if (start >= next->first)
@@ -365,8 +412,42 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 	}
 }
 
+bool BlockChainSync::requestSkeleton(std::shared_ptr<EthereumPeer> _peer, unsigned _start, unsigned _end)
+{
+	if (!m_skeletonPeer.expired() || _end <= _start || _end - _start < 2 * c_skeletonSpan)
+		return false;
+	unsigned const first = _start + c_skeletonSpan - 1;
+	std::vector<unsigned> anchors;
+	for (unsigned block = first; block < _end && anchors.size() < c_maxSkeletonHeaders; block += c_skeletonSpan)
+	{
+		if (m_downloadingHeaders.count(block) != 0 || haveItem(m_headers, block))
+			return false;
+		anchors.push_back(block);
+	}
+	for (unsigned block: anchors)
+		m_downloadingHeaders.insert(block);
+	m_headerSyncPeers[_peer] = anchors;
+	m_skeletonPeer = _peer;
+	clog(NetAllDetail) << "Requesting " << anchors.size() << " skeleton headers from " << first;
+	_peer->requestBlockHeaders(first, static_cast<unsigned>(anchors.size()), c_skeletonSpan - 1, false);
+	return true;
+}
+
+BlockChainSync::PeerThroughput& BlockChainSync::throughput(std::shared_ptr<EthereumPeer> const& _peer)
+{
+	auto it = m_peerThroughput.find(_peer);
+	if (it == m_peerThroughput.end())
+		it = m_peerThroughput.emplace(_peer, PeerThroughput{
+			SyncThroughput(c_initialRequestHeaders, c_minRequestHeaders, c_maxRequestHeaders),
+			SyncThroughput(c_initialRequestBodies, c_minRequestBodies, c_maxRequestBodies)
+		}).first;
+	return it->second;
+}
+
 void BlockChainSync::clearPeerDownload(std::shared_ptr<EthereumPeer> _peer)
 {
+	if (m_skeletonPeer.lock() == _peer)
+		m_skeletonPeer.reset();
 	auto syncPeer = m_headerSyncPeers.find(_peer);
 	if (syncPeer != m_headerSyncPeers.end())
 	{
@@ -407,6 +488,13 @@ void BlockChainSync::clearPeerDownload()
 		else
 			++s;
 	}
+	for (auto s = m_peerThroughput.begin(); s != m_peerThroughput.end();)
+	{
+		if (s->first.expired())
+			m_peerThroughput.erase(s++);
+		else
+			++s;
+	}
 }
 
 void BlockChainSync::logNewBlock(h256 const& _h)
@@ -420,6 +508,10 @@ void BlockChainSync::onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP
 	DEV_INVARIANT_CHECK;
 	size_t itemCount = _r.itemCount();
 	clog(NetMessageSummary) << "BlocksHeaders (" << dec << itemCount << "entries)" << (itemCount ? "" : ": NoMoreHeaders");
+	if (m_skeletonPeer.lock() == _peer)
+		m_skeletonPeer.reset();
+	else if (m_headerSyncPeers.count(_peer))
+		throughput(_peer).headers.received(itemCount);
 	clearPeerDownload(_peer);
 	if (m_state != SyncState::Blocks && m_state != SyncState::Waiting)
 	{
@@ -512,7 +604,7 @@ void BlockChainSync::onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP
 				r.appendRaw(RLPEmptyList);
 				bytes body;
 				r.swapOut(body);
-				mergeInto(m_bodies, blockNumber, std::move(body));
+				mergeInto(m_bodies, blockNumber, SharedBytesRef(std::move(body)));
 			}
 			else
 				m_headerIdToNumber[headerId] = blockNumber;
@@ -528,6 +620,8 @@ void BlockChainSync::onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP
 	DEV_INVARIANT_CHECK;
 	size_t itemCount = _r.itemCount();
 	clog(NetMessageSummary) << "BlocksBodies (" << dec << itemCount << "entries)" << (itemCount ? "" : ": NoMoreBodies");
+	if (m_bodySyncPeers.count(_peer))
+		throughput(_peer).bodies.received(itemCount);
 	clearPeerDownload(_peer);
 	if (m_state != SyncState::Blocks && m_state != SyncState::Waiting) {
 		clog(NetMessageSummary) << "Ignoring unexpected blocks";
@@ -564,7 +658,7 @@ void BlockChainSync::onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP
 			continue;
 		}
 		m_headerIdToNumber.erase(id);
-		mergeInto(m_bodies, blockNumber, body.data().toBytes());
+		mergeInto(m_bodies, blockNumber, _peer->packet().slice(body.data()));
 	}
 	collectBlocks();
 	continueSync();
@@ -590,12 +684,12 @@ void BlockChainSync::collectBlocks()
 	{
 		RLPStream blockStream(3);
 		blockStream.appendRaw(headers.second[i].data);
-		RLP body(bodies.second[i]);
+		RLP body(bodies.second[i].ref());
 		blockStream.appendRaw(body[0].data());
 		blockStream.appendRaw(body[1].data());
 		bytes block;
 		blockStream.swapOut(block);
-		switch (host().bq().import(&block))
+		switch (host().bq().import(SharedBytesRef(move(block))))
 		{
 		case ImportResult::Success:
 			success++;
@@ -680,7 +774,7 @@ void BlockChainSync::onPeerNewBlock(std::shared_ptr<EthereumPeer> _peer, RLP con
 		syncPeer(_peer, true);
 		return;
 	}
-	switch (host().bq().import(_r[0].data()))
+	switch (host().bq().import(_peer->packet().slice(_r[0].data())))
 	{
 	case ImportResult::Success:
 		_peer->addRating(100);
@@ -761,6 +855,7 @@ void BlockChainSync::resetSync()
 	m_bodies.clear();
 	m_headerSyncPeers.clear();
 	m_bodySyncPeers.clear();
+	m_skeletonPeer.reset();
 	m_headerIdToNumber.clear();
 	m_syncingTotalDifficulty = 0;
 	m_state = SyncState::NotSynced;
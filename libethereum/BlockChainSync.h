@@ -21,10 +21,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <mutex>
 #include <unordered_map>
 
 #include <libdevcore/Guards.h>
+#include <libdevcore/SharedBytes.h>
 #include <libethcore/Common.h>
 #include <libethcore/BlockHeader.h>
 #include <libp2p/Common.h>
@@ -42,6 +44,39 @@ class EthereumHost;
 class BlockQueue;
 class EthereumPeer;
 
+/**
+ * @brief Measures how fast a peer answers one kind of sync request and sizes the next request
+ * so that the answer takes about @a c_targetResponseTime to arrive.
+ */
+class SyncThroughput
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/// Responses are aimed at this latency, well inside the peer's ask timeout.
+	static constexpr std::chrono::milliseconds c_targetResponseTime{2000};
+
+	SyncThroughput(unsigned _initial, unsigned _min, unsigned _max): m_size(_initial), m_min(_min), m_max(_max) {}
+
+	/// Note that @a _count items were asked for at @a _at.
+	void requested(unsigned _count, Clock::time_point _at = Clock::now());
+	/// Note that @a _count items arrived at @a _at for the outstanding request, if any.
+	void received(unsigned _count, Clock::time_point _at = Clock::now());
+
+	/// @returns the number of items to ask for next.
+	unsigned requestSize() const { return m_size; }
+	/// @returns the smoothed delivery rate, 0 until the first response.
+	double itemsPerSecond() const { return m_rate; }
+
+private:
+	unsigned m_size;
+	unsigned const m_min;
+	unsigned const m_max;
+	double m_rate = 0;					///< Exponentially smoothed items per second
+	unsigned m_pending = 0;				///< Items asked for by the outstanding request
+	Clock::time_point m_requested;		///< When the outstanding request was sent
+};
+
 /**
  * @brief Base BlockChain synchronization strategy class.
  * Syncs to peers and keeps up to date. Base class handles blocks downloading but does not contain any details on state transfer logic.
@@ -86,12 +121,12 @@ public:
 	/// @returns Synchonization status
 	SyncStatus status() const;
 
+	/// Resume downloading after waiting state or a snapshot download
+	void continueSync();
+
 	static char const* stateName(SyncState _s) { return s_stateNames[static_cast<int>(_s)]; }
 
 private:
-	/// Resume downloading after witing state
-	void continueSync();
-
 	/// Enter waiting state
 	void pauseSync();
 
@@ -104,8 +139,19 @@ private:
 	void clearPeerDownload(std::shared_ptr<EthereumPeer> _peer);
 	void clearPeerDownload();
 	void collectBlocks();
+	/// @returns true if a skeleton of anchor headers was requested from @a _peer for the gap starting at @a _start.
+	bool requestSkeleton(std::shared_ptr<EthereumPeer> _peer, unsigned _start, unsigned _end);
 
 private:
+	/// Per-peer request sizing for headers and bodies.
+	struct PeerThroughput
+	{
+		SyncThroughput headers;
+		SyncThroughput bodies;
+	};
+
+	PeerThroughput& throughput(std::shared_ptr<EthereumPeer> const& _peer);
+
 	struct Header
 	{
 		bytes data;		///< Header data
@@ -148,9 +194,11 @@ private:
 	std::unordered_set<unsigned> m_downloadingHeaders;		///< Set of block body numbers being downloaded
 	std::unordered_set<unsigned> m_downloadingBodies;		///< Set of block header numbers being downloaded
 	std::map<unsigned, std::vector<Header>> m_headers;	    ///< Downloaded headers
-	std::map<unsigned, std::vector<bytes>> m_bodies;	    ///< Downloaded block bodies
+	std::map<unsigned, std::vector<SharedBytesRef>> m_bodies;	///< Downloaded block bodies, sharing the buffers they were received in
 	std::map<std::weak_ptr<EthereumPeer>, std::vector<unsigned>, std::owner_less<std::weak_ptr<EthereumPeer>>> m_headerSyncPeers; ///< Peers to m_downloadingSubchain number map
 	std::map<std::weak_ptr<EthereumPeer>, std::vector<unsigned>, std::owner_less<std::weak_ptr<EthereumPeer>>> m_bodySyncPeers; ///< Peers to m_downloadingSubchain number map
+	std::map<std::weak_ptr<EthereumPeer>, PeerThroughput, std::owner_less<std::weak_ptr<EthereumPeer>>> m_peerThroughput; ///< Measured delivery rates used to size requests
+	std::weak_ptr<EthereumPeer> m_skeletonPeer;	///< Peer currently delivering skeleton headers, if any
 	std::unordered_map<HeaderId, unsigned, HeaderIdHash> m_headerIdToNumber;
 	bool m_haveCommonHeader = false;			///< True if common block for our and remote chain has been found
 	unsigned m_lastImportedBlock = 0; 			///< Last imported block number
@@ -43,8 +43,12 @@ size_t const c_maxKnownCount = 100000;
 size_t const c_maxKnownSize = 128 * 1024 * 1024;
 size_t const c_maxUnknownCount = 100000;
 size_t const c_maxUnknownSize = 512 * 1024 * 1024; // Block size can be ~50kb
+size_t const c_unverifiedCapacity = 8192;
+size_t const c_verifyBatch = 4;
+size_t const c_maxUnknownMemory = 64 * 1024 * 1024; // Beyond this, future and unknown blocks go to the spill file if there is one
 
-BlockQueue::BlockQueue()
+BlockQueue::BlockQueue():
+	m_unverified(c_unverifiedCapacity)
 {
 	// Allow some room for other activity
 	unsigned verifierThreads = std::max(thread::hardware_concurrency(), 3U) - 2U;
@@ -62,15 +66,40 @@ BlockQueue::~BlockQueue()
 
 void BlockQueue::stop()
 {
-	DEV_GUARDED(m_verification)
-		m_deleting = true;
-
-	m_moreToVerify.notify_all();
+	m_deleting = true;
+	m_unverified.close();
 	for (auto& i: m_verifiers)
 		i.join();
 	m_verifiers.clear();
 }
 
+void BlockQueue::setSpill(boost::filesystem::path const& _path, uint64_t _capacity)
+{
+	WriteGuard l(m_lock);
+	if (m_spill)
+		return;
+	m_spill.reset(new BlockSpill(_path, _capacity));
+	if (!m_spill->isOpen())
+	{
+		m_spill.reset();
+		return;
+	}
+	m_unknown.setSpill(m_spill.get());
+	m_future.setSpill(m_spill.get());
+	spill_WITH_LOCK();
+}
+
+void BlockQueue::spill_WITH_LOCK()
+{
+	if (!m_spill || unknownSize() <= c_maxUnknownMemory)
+		return;
+	// Unknown-parent blocks are the ones that pile up when far ahead or flooded with side chains; future ones go second.
+	size_t spilled = m_unknown.spill(m_future.size() < c_maxUnknownMemory ? c_maxUnknownMemory - m_future.size() : 0);
+	if (unknownSize() > c_maxUnknownMemory)
+		spilled += m_future.spill(m_unknown.size() < c_maxUnknownMemory ? c_maxUnknownMemory - m_unknown.size() : 0);
+	clog(BlockQueueTraceChannel) << "Spilled" << spilled << "blocks;" << m_spill->entries() << "blocks," << m_spill->used() << "bytes on disk.";
+}
+
 void BlockQueue::clear()
 {
 	WriteGuard l(m_lock);
@@ -79,7 +108,13 @@ void BlockQueue::clear()
 	m_readySet.clear();
 	m_drainingSet.clear();
 	m_verified.clear();
-	m_unverified.clear();
+	UnverifiedBlock dropped;
+	while (m_unverified.try_pop(dropped))
+		m_unverifiedSize -= dropped.blockData.size();
+	for (UnverifiedBlock const& b: m_unverifiedOverflow)
+		m_unverifiedSize -= b.blockData.size();
+	m_unverifiedOverflow.clear();
+	m_unverifiedOverflowCount = 0;
 	m_verifying.clear();
 	m_unknownSet.clear();
 	m_unknown.clear();
@@ -90,70 +125,107 @@ void BlockQueue::clear()
 
 void BlockQueue::verifierBody()
 {
-	while (!m_deleting)
+	std::vector<UnverifiedBlock> batch;
+	while (m_unverified.pop_batch(batch, c_verifyBatch))
 	{
-		UnverifiedBlock work;
-
+		for (UnverifiedBlock& work: batch)
 		{
-			unique_lock<Mutex> l(m_verification);
-			m_moreToVerify.wait(l, [&](){ return !m_unverified.isEmpty() || m_deleting; });
-			if (m_deleting)
-				return;
-			work = m_unverified.dequeue();
-
-			BlockHeader bi;
-			bi.setSha3Uncles(work.hash);
-			bi.setParentHash(work.parentHash);
-			m_verifying.enqueue(move(bi));
+			m_unverifiedSize -= work.blockData.size();
+			if (!m_deleting)
+				verify(work);
 		}
+		batch.clear();
+		if (m_unverifiedOverflowCount)
+			refillUnverified();
+	}
+}
 
-		VerifiedBlock res;
-		swap(work.blockData, res.blockData);
-		try
-		{
-			res.verified = m_bc->verifyBlock(&res.blockData, m_onBad, ImportRequirements::OutOfOrderChecks);
-		}
-		catch (std::exception const& _ex)
-		{
-			// bad block.
-			// has to be this order as that's how invariants() assumes.
-			WriteGuard l2(m_lock);
-			unique_lock<Mutex> l(m_verification);
-			m_readySet.erase(work.hash);
-			m_knownBad.insert(work.hash);
-			if (!m_verifying.remove(work.hash))
-				cwarn << "Unexpected exception when verifying block: " << _ex.what();
-			drainVerified_WITH_BOTH_LOCKS();
-			continue;
-		}
+void BlockQueue::verify(UnverifiedBlock& _work)
+{
+	// Blocks found bad, or descended from one, while they waited here have already been taken out of
+	// m_verifying; they need neither verifying nor mentioning.
+	DEV_GUARDED(m_verification)
+		if (!m_verifying.contains(_work.hash))
+			return;
 
-		bool ready = false;
+	VerifiedBlock res;
+	swap(_work.blockData, res.blockData);
+	try
+	{
+		res.verified = m_bc->verifyBlock(res.blockData.ref(), m_onBad, ImportRequirements::OutOfOrderChecks);
+	}
+	catch (std::exception const& _ex)
+	{
+		// bad block.
+		// has to be this order as that's how invariants() assumes.
+		WriteGuard l2(m_lock);
+		unique_lock<Mutex> l(m_verification);
+		m_readySet.erase(_work.hash);
+		m_knownBad.insert(_work.hash);
+		if (!m_verifying.remove(_work.hash))
+			// Pruned while we were verifying it.
+			clog(BlockQueueTraceChannel) << "Dropped bad block" << _work.hash << "already gone from the queue:" << _ex.what();
+		drainVerified_WITH_BOTH_LOCKS();
+		return;
+	}
+
+	BlockHeader header = res.verified.info;
+	bool ready = false;
+	{
+		WriteGuard l2(m_lock);
+		unique_lock<Mutex> l(m_verification);
+		if (!m_verifying.isEmpty() && m_verifying.nextHash() == _work.hash)
 		{
-			WriteGuard l2(m_lock);
-			unique_lock<Mutex> l(m_verification);
-			if (!m_verifying.isEmpty() && m_verifying.nextHash() == work.hash)
+			// we're next!
+			m_verifying.dequeue();
+			if (m_knownBad.count(res.verified.info.parentHash()))
 			{
-				// we're next!
-				m_verifying.dequeue();
-				if (m_knownBad.count(res.verified.info.parentHash()))
-				{
-					m_readySet.erase(res.verified.info.hash());
-					m_knownBad.insert(res.verified.info.hash());
-				}
-				else
-					m_verified.enqueue(move(res));
-
-				drainVerified_WITH_BOTH_LOCKS();
-				ready = true;
+				m_readySet.erase(res.verified.info.hash());
+				m_knownBad.insert(res.verified.info.hash());
 			}
 			else
+				m_verified.enqueue(move(res));
+
+			drainVerified_WITH_BOTH_LOCKS();
+			ready = true;
+		}
+		else
+		{
+			if (!m_verifying.replace(_work.hash, move(res)))
 			{
-				if (!m_verifying.replace(work.hash, move(res)))
-					cwarn << "BlockQueue missing our job: was there a GM?";
+				// Pruned as bad, or the queue cleared, while we were verifying it.
+				clog(BlockQueueTraceChannel) << "Dropped verified block" << _work.hash << "already gone from the queue";
+				return;
 			}
 		}
-		if (ready)
-			m_onReady();
+	}
+	if (ready)
+		m_onReady();
+	m_onVerified(header);
+}
+
+void BlockQueue::enqueueUnverified_WITH_BOTH_LOCKS(UnverifiedBlock&& _block)
+{
+	BlockHeader bi;
+	bi.setSha3Uncles(_block.hash);
+	bi.setParentHash(_block.parentHash);
+	m_verifying.enqueue(move(bi));
+
+	m_unverifiedSize += _block.blockData.size();
+	if (m_unverifiedOverflowCount || !m_unverified.push(move(_block)))
+	{
+		m_unverifiedOverflow.push_back(move(_block));
+		++m_unverifiedOverflowCount;
+	}
+}
+
+void BlockQueue::refillUnverified()
+{
+	Guard l(m_verification);
+	while (!m_unverifiedOverflow.empty() && m_unverified.push(move(m_unverifiedOverflow.front())))
+	{
+		m_unverifiedOverflow.pop_front();
+		--m_unverifiedOverflowCount;
 	}
 }
 
@@ -172,7 +244,7 @@ void BlockQueue::drainVerified_WITH_BOTH_LOCKS()
 	}
 }
 
-ImportResult BlockQueue::import(bytesConstRef _block, bool _isOurs)
+ImportResult BlockQueue::importBlock(bytesConstRef _block, SharedBytesRef const& _buffer, bool _isOurs)
 {
 	clog(BlockQueueTraceChannel) << std::this_thread::get_id();
 	// Check if we already know this block.
@@ -217,7 +289,9 @@ ImportResult BlockQueue::import(bytesConstRef _block, bool _isOurs)
 	// Check it's not in the future
 	if (bi.timestamp() > utcTime() && !_isOurs)
 	{
-		m_future.insert(static_cast<time_t>(bi.timestamp()), h, _block.toBytes());
+		if (!m_future.insert(static_cast<time_t>(bi.timestamp()), h, _block.toBytes(), bi.number()))
+			return ImportResult::AlreadyKnown;
+		spill_WITH_LOCK();
 		char buf[24];
 		time_t bit = static_cast<time_t>(bi.timestamp());
 		if (strftime(buf, 24, "%X", localtime(&bit)) == 0)
@@ -241,9 +315,10 @@ ImportResult BlockQueue::import(bytesConstRef _block, bool _isOurs)
 		{
 			// We don't know the parent (yet) - queue it up for later. It'll get resent to us if we find out about its ancestry later on.
 			clog(BlockQueueTraceChannel) << "OK - queued as unknown parent:" << bi.parentHash();
-			m_unknown.insert(bi.parentHash(), h, _block.toBytes());
+			m_unknown.insert(bi.parentHash(), h, _block.toBytes(), bi.number());
 			m_unknownSet.insert(h);
 			m_difficulty += bi.difficulty();
+			spill_WITH_LOCK();
 
 			return ImportResult::UnknownParent;
 		}
@@ -252,8 +327,7 @@ ImportResult BlockQueue::import(bytesConstRef _block, bool _isOurs)
 			// If valid, append to blocks.
 			clog(BlockQueueTraceChannel) << "OK - ready for chain insertion.";
 			DEV_GUARDED(m_verification)
-				m_unverified.enqueue(UnverifiedBlock { h, bi.parentHash(), _block.toBytes() });
-			m_moreToVerify.notify_one();
+				enqueueUnverified_WITH_BOTH_LOCKS(UnverifiedBlock { h, bi.parentHash(), _buffer.slice(_block) });
 			m_readySet.insert(h);
 			m_difficulty += bi.difficulty();
 
@@ -269,47 +343,23 @@ void BlockQueue::updateBad_WITH_LOCK(h256 const& _bad)
 	DEV_INVARIANT_CHECK;
 	DEV_GUARDED(m_verification)
 	{
-		collectUnknownBad_WITH_BOTH_LOCKS(_bad);
-		bool moreBad = true;
-		while (moreBad)
+		// Walk the descendants of _bad through the queues' parent indices.
+		list<h256> badQueue(1, _bad);
+		while (!badQueue.empty())
 		{
-			moreBad = false;
-			std::vector<VerifiedBlock> badVerified = m_verified.removeIf([this](VerifiedBlock const& _b)
-			{
-				return m_knownBad.count(_b.verified.info.parentHash()) || m_knownBad.count(_b.verified.info.hash());
-			});
-			for (auto& b: badVerified)
-			{
-				m_knownBad.insert(b.verified.info.hash());
-				m_readySet.erase(b.verified.info.hash());
-				collectUnknownBad_WITH_BOTH_LOCKS(b.verified.info.hash());
-				moreBad = true;
-			}
-
-			std::vector<UnverifiedBlock> badUnverified = m_unverified.removeIf([this](UnverifiedBlock const& _b)
-			{
-				return m_knownBad.count(_b.parentHash) || m_knownBad.count(_b.hash);
-			});
-			for (auto& b: badUnverified)
-			{
-				m_knownBad.insert(b.hash);
-				m_readySet.erase(b.hash);
-				collectUnknownBad_WITH_BOTH_LOCKS(b.hash);
-				moreBad = true;
-			}
-
-			std::vector<VerifiedBlock> badVerifying = m_verifying.removeIf([this](VerifiedBlock const& _b)
-			{
-				return m_knownBad.count(_b.verified.info.parentHash()) || m_knownBad.count(_b.verified.info.sha3Uncles());
-			});
-			for (auto& b: badVerifying)
-			{
-				h256 const& h = b.blockData.size() != 0 ? b.verified.info.hash() : b.verified.info.sha3Uncles();
-				m_knownBad.insert(h);
-				m_readySet.erase(h);
-				collectUnknownBad_WITH_BOTH_LOCKS(h);
-				moreBad = true;
-			}
+			h256 const bad = badQueue.front();
+			badQueue.pop_front();
+			collectUnknownBad_WITH_BOTH_LOCKS(bad);
+			if (m_verified.remove(bad) || m_verifying.remove(bad))
+				m_readySet.erase(bad);
+			for (SizedBlockQueue<VerifiedBlock>* q: {&m_verified, &m_verifying})
+				for (VerifiedBlock const& b: q->removeByParent(bad))
+				{
+					h256 const h = b.blockData.size() != 0 ? b.verified.info.hash() : b.verified.info.sha3Uncles();
+					m_knownBad.insert(h);
+					m_readySet.erase(h);
+					badQueue.push_back(h);
+				}
 		}
 	}
 }
@@ -372,15 +422,18 @@ void BlockQueue::tick()
 	cblockq << "Importing" << todo.size() << "past-future blocks.";
 
 	for (auto const& b: todo)
-		import(&b.second);
+		if (!b.second.empty())
+			import(&b.second);
 }
 
 BlockQueueStatus BlockQueue::status() const
 { 
 	ReadGuard l(m_lock); 
 	Guard l2(m_verification); 
-	return BlockQueueStatus{ m_drainingSet.size(), m_verified.count(), m_verifying.count(), m_unverified.count(), 
-		m_future.count(), m_unknown.count(), m_knownBad.size() };
+	size_t const unverified = min(unverifiedCount(), m_verifying.count());
+	return BlockQueueStatus{ m_drainingSet.size(), m_verified.count(), m_verifying.count() - unverified, unverified,
+		m_future.count(), m_unknown.count(), m_knownBad.size(),
+		m_future.spilledCount() + m_unknown.spilledCount(), knownSize(), unknownSize(), m_future.spilledSize() + m_unknown.spilledSize() };
 }
 
 QueueStatus BlockQueue::blockStatus(h256 const& _h) const
@@ -406,12 +459,12 @@ bool BlockQueue::knownFull() const
 
 std::size_t BlockQueue::knownSize() const
 {
-	return m_verified.size() + m_unverified.size() + m_verifying.size();
+	return m_verified.size() + m_unverifiedSize + m_verifying.size();
 }
 
 std::size_t BlockQueue::knownCount() const
 {
-	return m_verified.count() + m_unverified.count() + m_verifying.count();
+	return m_verified.count() + m_verifying.count();
 }
 
 bool BlockQueue::unknownFull() const
@@ -463,34 +516,61 @@ bool BlockQueue::invariants() const
 	if (m_readySet.size() != knownCount())
 	{
 		std::stringstream s;
-		s << "Failed BlockQueue invariant: m_readySet: " << m_readySet.size() << " m_verified: " << m_verified.count() << " m_unverified: " << m_unverified.count() << " m_verifying" << m_verifying.count();
+		s << "Failed BlockQueue invariant: m_readySet: " << m_readySet.size() << " m_verified: " << m_verified.count() << " m_unverified: " << unverifiedCount() << " m_verifying" << m_verifying.count();
 		BOOST_THROW_EXCEPTION(FailedInvariant() << errinfo_comment(s.str()));
 	}
 	return true;
 }
 
+namespace
+{
+void sortByDifficulty(vector<pair<h256, bytes>>& _blocks)
+{
+	vector<pair<u256, size_t>> order;
+	order.reserve(_blocks.size());
+	for (size_t i = 0; i < _blocks.size(); ++i)
+	{
+		u256 difficulty;
+		try
+		{
+			if (!_blocks[i].second.empty())
+				difficulty = BlockHeader(_blocks[i].second).difficulty();
+		}
+		catch (Exception const&) {}
+		order.emplace_back(difficulty, i);
+	}
+	stable_sort(order.begin(), order.end(), [](pair<u256, size_t> const& _a, pair<u256, size_t> const& _b) { return _a.first > _b.first; });
+	vector<pair<h256, bytes>> sorted;
+	sorted.reserve(_blocks.size());
+	for (auto const& o: order)
+		sorted.push_back(move(_blocks[o.second]));
+	_blocks.swap(sorted);
+}
+}
+
 void BlockQueue::noteReady_WITH_LOCK(h256 const& _good)
 {
 	DEV_INVARIANT_CHECK;
 	list<h256> goodQueue(1, _good);
-	bool notify = false;
 	while (!goodQueue.empty())
 	{
 		h256 const parent = goodQueue.front();
-		vector<pair<h256, bytes>> const removed = m_unknown.removeByKeyEqual(parent);
+		vector<pair<h256, bytes>> removed = m_unknown.removeByKeyEqual(parent);
 		goodQueue.pop_front();
+		if (removed.size() > 1)
+			// Competing children: verify (and so import) the heaviest first, as it's the likeliest to be on the best chain.
+			sortByDifficulty(removed);
 		for (auto& newReady: removed)
 		{
-			DEV_GUARDED(m_verification)
-				m_unverified.enqueue(UnverifiedBlock { newReady.first, parent, move(newReady.second) });
 			m_unknownSet.erase(newReady.first);
+			if (newReady.second.empty())
+				continue;
+			DEV_GUARDED(m_verification)
+				enqueueUnverified_WITH_BOTH_LOCKS(UnverifiedBlock { newReady.first, parent, SharedBytesRef(move(newReady.second)) });
 			m_readySet.insert(newReady.first);
 			goodQueue.push_back(newReady.first);
-			notify = true;
 		}
 	}
-	if (notify)
-		m_moreToVerify.notify_all();
 }
 
 void BlockQueue::retryAllUnknown()
@@ -503,14 +583,14 @@ void BlockQueue::retryAllUnknown()
 		vector<pair<h256, bytes>> removed = m_unknown.removeByKeyEqual(parent);
 		for (auto& newReady: removed)
 		{
-			DEV_GUARDED(m_verification)
-				m_unverified.enqueue(UnverifiedBlock{ newReady.first, parent, move(newReady.second) });
 			m_unknownSet.erase(newReady.first);
+			if (newReady.second.empty())
+				continue;
+			DEV_GUARDED(m_verification)
+				enqueueUnverified_WITH_BOTH_LOCKS(UnverifiedBlock{ newReady.first, parent, SharedBytesRef(move(newReady.second)) });
 			m_readySet.insert(newReady.first);
-			m_moreToVerify.notify_one();
 		}
 	}
-	m_moreToVerify.notify_all();
 }
 
 std::ostream& dev::eth::operator<<(std::ostream& _out, BlockQueueStatus const& _bqs)
@@ -522,6 +602,10 @@ std::ostream& dev::eth::operator<<(std::ostream& _out, BlockQueueStatus const& _
 	_out << "future: " << _bqs.future << endl;
 	_out << "unknown: " << _bqs.unknown << endl;
 	_out << "bad: " << _bqs.bad << endl;
+	_out << "spilled: " << _bqs.spilled << endl;
+	_out << "known bytes: " << _bqs.knownBytes << endl;
+	_out << "unknown bytes: " << _bqs.unknownBytes << endl;
+	_out << "spilled bytes: " << _bqs.spilledBytes << endl;
 
 	return _out;
 }
@@ -537,7 +621,7 @@ bool BlockQueue::isActive() const
 	UpgradableGuard l(m_lock);
 	if (m_readySet.empty() && m_drainingSet.empty())
 		DEV_GUARDED(m_verification)
-			if (m_verified.isEmpty() && m_verifying.isEmpty() && m_unverified.isEmpty())
+			if (m_verified.isEmpty() && m_verifying.isEmpty())
 				return false;
 	return true;
 }
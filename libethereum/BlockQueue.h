@@ -21,15 +21,20 @@
 
 #pragma once
 
-#include <condition_variable>
 #include <thread>
 #include <deque>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
 #include <boost/thread.hpp>
 #include <libdevcore/Common.h>
 #include <libdevcore/Log.h>
 #include <libethcore/Common.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/mpmc_queue.h>
 #include <libethcore/BlockHeader.h>
+#include "BlockSpill.h"
 #include "VerifiedBlock.h"
 
 namespace dev
@@ -53,6 +58,10 @@ struct BlockQueueStatus
 	size_t future;
 	size_t unknown;
 	size_t bad;
+	size_t spilled;			///< Future and unknown blocks held in the spill file rather than in memory.
+	size_t knownBytes;		///< Bytes of blocks importing, verified, verifying and unverified.
+	size_t unknownBytes;	///< Bytes of future and unknown blocks still in memory.
+	size_t spilledBytes;	///< Bytes of future and unknown blocks in the spill file.
 };
 
 enum class QueueStatus
@@ -66,6 +75,12 @@ enum class QueueStatus
 
 std::ostream& operator<< (std::ostream& os, QueueStatus const& obj);
 
+/**
+ * @brief Blocks in arrival order, indexed by their keying hash and by their parent hash.
+ * The keying hash is fixed when a block is enqueued: the block hash for a verified block, the
+ * sha3Uncles() of a placeholder (which BlockQueue sets to the hash of the block it stands for).
+ * Lookups, removals and replacements by hash are O(1).
+ */
 template<class T>
 class SizedBlockQueue
 {
@@ -76,110 +91,177 @@ public:
 	
 	bool isEmpty() const { return m_queue.empty(); }
 
-	h256 nextHash() const { return m_queue.front().verified.info.sha3Uncles(); }
+	h256 nextHash() const { return m_queue.front().hash; }
+
+	T const& next() const { return m_queue.front().item; }
 
-	T const& next() const { return m_queue.front(); }
+	bool contains(h256 const& _hash) const { return m_index.count(_hash); }
 
 	void clear()
 	{
 		m_queue.clear();
+		m_index.clear();
+		m_byParent.clear();
 		m_size = 0;
 	}
 
 	void enqueue(T&& _t)
 	{
-		m_queue.emplace_back(std::move(_t));
-		m_size += m_queue.back().blockData.size();
+		h256 const hash = _t.blockData.empty() ? _t.verified.info.sha3Uncles() : _t.verified.info.hash();
+		h256 const parent = _t.verified.info.parentHash();
+		m_size += _t.blockData.size();
+		m_queue.push_back(Entry{hash, parent, m_sequence++, std::move(_t)});
+		m_index[hash] = std::prev(m_queue.end());
+		m_byParent.insert(std::make_pair(parent, hash));
 	}
 
 	T dequeue()
 	{
-		T t;
-		std::swap(t, m_queue.front());
-		m_queue.pop_front();
-		m_size -= t.blockData.size();
-
-		return t;
+		return take(m_queue.begin());
 	}
 
 	std::vector<T> dequeueMultiple(std::size_t _n)
 	{
-		return removeRange(m_queue.begin(), m_queue.begin() + _n);
+		std::vector<T> ret;
+		ret.reserve(std::min(_n, m_queue.size()));
+		while (ret.size() < _n && !m_queue.empty())
+			ret.push_back(take(m_queue.begin()));
+		return ret;
 	}
 
 	bool remove(h256 const& _hash)
 	{
-		std::vector<T> removed = removeIf(sha3UnclesEquals(_hash));
-		return !removed.empty();
+		auto it = m_index.find(_hash);
+		if (it == m_index.end())
+			return false;
+		take(it->second);
+		return true;
+	}
+
+	/// Removes the blocks whose parent is @a _parent, in queue order.
+	std::vector<T> removeByParent(h256 const& _parent)
+	{
+		std::vector<typename Queue::iterator> children;
+		auto const range = m_byParent.equal_range(_parent);
+		for (auto i = range.first; i != range.second; ++i)
+			children.push_back(m_index.at(i->second));
+		std::sort(children.begin(), children.end(), [](typename Queue::iterator _a, typename Queue::iterator _b) { return _a->sequence < _b->sequence; });
+		std::vector<T> ret;
+		for (auto const& c: children)
+			ret.push_back(take(c));
+		return ret;
 	}
 
 	template<class Pred>
 	std::vector<T> removeIf(Pred _pred)
 	{
-		auto const removedBegin = std::remove_if(m_queue.begin(), m_queue.end(), _pred);
-
-		return removeRange(removedBegin, m_queue.end());
+		std::vector<T> ret;
+		for (auto it = m_queue.begin(); it != m_queue.end();)
+			if (_pred(it->item))
+				ret.push_back(take(it++));
+			else
+				++it;
+		return ret;
 	}
 
+	/// Replaces the block keyed by @a _hash with @a _t, which keeps the same key and place.
 	bool replace(h256 const& _hash, T&& _t)
 	{
-		auto const it = std::find_if(m_queue.begin(), m_queue.end(), sha3UnclesEquals(_hash));
-
-		if (it == m_queue.end())
+		auto const it = m_index.find(_hash);
+		if (it == m_index.end())
 			return false;
 
-		m_size -= it->blockData.size();
+		T& item = it->second->item;
+		m_size -= item.blockData.size();
 		m_size += _t.blockData.size();
-		*it = std::move(_t);
+		item = std::move(_t);
 
 		return true;
 	}
 
 private:
-	static std::function<bool(T const&)> sha3UnclesEquals(h256 const& _hash)
+	struct Entry
 	{
-		return [&_hash](T const& _t) { return _t.verified.info.sha3Uncles() == _hash; };
-	}
+		h256 hash;
+		h256 parent;
+		uint64_t sequence;
+		T item;
+	};
+	using Queue = std::list<Entry>;
 
-	std::vector<T> removeRange(typename std::deque<T>::iterator _begin, typename std::deque<T>::iterator _end)
+	T take(typename Queue::iterator _it)
 	{
-		std::vector<T> ret(std::make_move_iterator(_begin), std::make_move_iterator(_end));
-
-		for (auto it = ret.begin(); it != ret.end(); ++it)
-			m_size -= it->blockData.size();
-
-		m_queue.erase(_begin, _end);
+		T ret = std::move(_it->item);
+		m_size -= ret.blockData.size();
+		m_index.erase(_it->hash);
+		auto const range = m_byParent.equal_range(_it->parent);
+		for (auto i = range.first; i != range.second; ++i)
+			if (i->second == _it->hash)
+			{
+				m_byParent.erase(i);
+				break;
+			}
+		m_queue.erase(_it);
 		return ret;
 	}
 
-	std::deque<T> m_queue;
+	Queue m_queue;
+	std::unordered_map<h256, typename Queue::iterator> m_index;	///< Keying hash to entry
+	std::unordered_multimap<h256, h256> m_byParent;				///< Parent hash to keying hashes of its queued children
+	uint64_t m_sequence = 0;										///< Enqueue count, to keep removeByParent() in queue order
 	std::atomic<size_t> m_size = {0};	///< Tracks total size in bytes
 };
 
+/**
+ * @brief Blocks waiting on something other than verification, multi-mapped by @a KeyType.
+ * Given a BlockSpill, the furthest-ahead blocks can be moved to disk with spill(); they are read
+ * back transparently when removed. size() only counts the bytes still held in memory.
+ */
 template<class KeyType>
 class SizedBlockMap
 {
 public:
+	~SizedBlockMap() { clear(); }
+
 	std::size_t count() const { return m_map.size(); }
 
 	std::size_t size() const { return m_size; }
 
+	std::size_t spilledCount() const { return m_spilledCount; }
+
+	std::size_t spilledSize() const { return m_spilledSize; }
+
 	bool isEmpty() const { return m_map.empty(); }
 
 	KeyType firstKey() const { return m_map.begin()->first; }
 
+	void setSpill(BlockSpill* _spill) { m_spill = _spill; }
+
 	void clear()
 	{
+		if (m_spill)
+			for (auto const& i: m_map)
+				if (i.second.spilled)
+					m_spill->free(i.second.extent);
 		m_map.clear();
+		m_byHash.clear();
+		m_resident.clear();
 		m_size = 0;
+		m_spilledCount = 0;
+		m_spilledSize = 0;
 	}
 
-	void insert(KeyType const& _key, h256 const& _hash, bytes&& _blockData)
+	/// Inserts a block numbered @a _number; a block already present is left alone.
+	/// @returns false if @a _hash was already present.
+	bool insert(KeyType const& _key, h256 const& _hash, bytes&& _blockData, int64_t _number)
 	{
-		auto hashAndBlock = std::make_pair(_hash, std::move(_blockData));
-		auto keyAndValue = std::make_pair(_key, std::move(hashAndBlock));
-		m_map.insert(std::move(keyAndValue));
+		if (m_byHash.count(_hash))
+			return false;
 		m_size += _blockData.size();
+		auto it = m_map.insert(std::make_pair(_key, Entry{_hash, std::move(_blockData), _number}));
+		m_byHash[_hash] = it;
+		m_resident.insert(std::make_pair(_number, _hash));
+		return true;
 	}
 
 	std::vector<std::pair<h256, bytes>> removeByKeyEqual(KeyType const& _key)
@@ -193,27 +275,73 @@ public:
 		return removeRange(m_map.begin(), m_map.upper_bound(_key));
 	}
 
+	/// Moves blocks to the spill file, highest numbers first, until no more than @a _target bytes remain in memory.
+	/// @returns the number of blocks spilled; stops early if the spill file has no room.
+	std::size_t spill(std::size_t _target)
+	{
+		std::size_t ret = 0;
+		while (m_spill && m_size > _target && !m_resident.empty())
+		{
+			auto const last = std::prev(m_resident.end());
+			Entry& e = m_byHash.at(last->second)->second;
+			if (!m_spill->write(&e.data, e.extent))
+				break;
+			m_size -= e.data.size();
+			m_spilledSize += e.data.size();
+			++m_spilledCount;
+			bytes().swap(e.data);
+			e.spilled = true;
+			m_resident.erase(last);
+			++ret;
+		}
+		return ret;
+	}
+
 private:
-	using BlockMultimap = std::multimap<KeyType, std::pair<h256, bytes>>;
+	struct Entry
+	{
+		h256 hash;
+		bytes data;
+		int64_t number;
+		bool spilled = false;
+		BlockSpill::Extent extent;
+	};
+	using BlockMultimap = std::multimap<KeyType, Entry>;
 
 	std::vector<std::pair<h256, bytes>> removeRange(typename BlockMultimap::iterator _begin, typename BlockMultimap::iterator _end)
 	{
 		std::vector<std::pair<h256, bytes>> removed;
-		std::size_t removedSize = 0;
 		for (auto it = _begin; it != _end; ++it)
 		{
-			removed.push_back(std::move(it->second));
-			removedSize += removed.back().second.size();
+			Entry& e = it->second;
+			m_byHash.erase(e.hash);
+			if (e.spilled)
+			{
+				m_spilledSize -= e.extent.size;
+				--m_spilledCount;
+				// A block that can't be read back is returned without data.
+				m_spill->take(e.extent, e.data);
+			}
+			else
+			{
+				m_size -= e.data.size();
+				m_resident.erase(std::make_pair(e.number, e.hash));
+			}
+			removed.push_back(std::make_pair(e.hash, std::move(e.data)));
 		}
 
-		m_size -= removedSize;
 		m_map.erase(_begin, _end);
 
 		return removed;
 	}
-		
+
 	BlockMultimap m_map;
-	std::atomic<size_t> m_size = {0};	///< Tracks total size in bytes
+	std::unordered_map<h256, typename BlockMultimap::iterator> m_byHash;	///< Every entry by block hash.
+	std::set<std::pair<int64_t, h256>> m_resident;						///< Entries still in memory by block number; spilled from the back.
+	BlockSpill* m_spill = nullptr;
+	std::atomic<size_t> m_size = {0};			///< Tracks total size in bytes of the blocks in memory
+	std::atomic<size_t> m_spilledCount = {0};	///< Blocks in the spill file
+	std::atomic<size_t> m_spilledSize = {0};	///< Bytes in the spill file
 };
 
 /**
@@ -229,8 +357,15 @@ public:
 
 	void setChain(BlockChain const& _bc) { m_bc = &_bc; }
 
+	/// Lets future and unknown-parent blocks beyond a memory budget go to a ring file of @a _capacity bytes at @a _path.
+	/// Only the first call has any effect.
+	void setSpill(boost::filesystem::path const& _path, uint64_t _capacity);
+
 	/// Import a block into the queue.
-	ImportResult import(bytesConstRef _block, bool _isOurs = false);
+	ImportResult import(bytesConstRef _block, bool _isOurs = false) { return importBlock(_block, SharedBytesRef(), _isOurs); }
+
+	/// Import a block into the queue, which keeps a reference to @a _block's buffer rather than a copy of it.
+	ImportResult import(SharedBytesRef const& _block, bool _isOurs = false) { return importBlock(_block.ref(), _block, _isOurs); }
 
 	/// Notes that time has moved on and some blocks that used to be "in the future" may no be valid.
 	void tick();
@@ -269,6 +404,7 @@ public:
 
 	template <class T> Handler<> onReady(T const& _t) { return m_onReady.add(_t); }
 	template <class T> Handler<> onRoomAvailable(T const& _t) { return m_onRoomAvailable.add(_t); }
+	template <class T> Handler<BlockHeader const&> onVerified(T const& _t) { return m_onVerified.add(_t); }
 
 	template <class T> void setOnBad(T const& _t) { m_onBad = _t; }
 
@@ -282,17 +418,28 @@ private:
 	{
 		h256 hash;
 		h256 parentHash;
-		bytes blockData;
+		SharedBytesRef blockData;
 	};
 
+	/// Import _block; it is queued as a slice of _buffer when it lies within it, otherwise it is copied.
+	ImportResult importBlock(bytesConstRef _block, SharedBytesRef const& _buffer, bool _isOurs);
+
 	void noteReady_WITH_LOCK(h256 const& _b);
 
 	bool invariants() const override;
 
 	void verifierBody();
+	void verify(UnverifiedBlock& _work);
+	/// Reserves the block's place in m_verifying and hands it to the verifiers.
+	void enqueueUnverified_WITH_BOTH_LOCKS(UnverifiedBlock&& _block);
+	/// Moves blocks that did not fit into m_unverified back into it.
+	void refillUnverified();
+	std::size_t unverifiedCount() const { return m_unverified.depth() + m_unverifiedOverflowCount; }
 	void collectUnknownBad_WITH_BOTH_LOCKS(h256 const& _bad);
 	void updateBad_WITH_LOCK(h256 const& _bad);
 	void drainVerified_WITH_BOTH_LOCKS();
+	/// Spills future and unknown blocks, furthest ahead first, until their memory is back within budget.
+	void spill_WITH_LOCK();
 
 	std::size_t knownSize() const;
 	std::size_t knownCount() const;
@@ -305,17 +452,21 @@ private:
 	h256Hash m_drainingSet;												///< All blocks being imported.
 	h256Hash m_readySet;												///< All blocks ready for chain import.
 	h256Hash m_unknownSet;												///< Set of all blocks whose parents are not ready/in-chain.
+	std::unique_ptr<BlockSpill> m_spill;								///< Ring file m_unknown and m_future spill to; must outlive them.
 	SizedBlockMap<h256> m_unknown;										///< For blocks that have an unknown parent; we map their parent hash to the block stuff, and insert once the block appears.
 	h256Hash m_knownBad;												///< Set of blocks that we know will never be valid.
 	SizedBlockMap<time_t> m_future;										///< Set of blocks that are not yet valid. Ordered by timestamp
 	Signal<> m_onReady;													///< Called when a subsequent call to import blocks will return a non-empty container. Be nice and exit fast.
 	Signal<> m_onRoomAvailable;											///< Called when space for new blocks becomes availabe after a drain. Be nice and exit fast.
+	Signal<BlockHeader const&> m_onVerified;							///< Called from a verifier thread with the header of each block that passed verification, before it is imported. Be nice and exit fast.
 
-	mutable Mutex m_verification;										///< Mutex that allows writing to m_verified, m_verifying and m_unverified.
-	std::condition_variable m_moreToVerify;								///< Signaled when m_unverified has a new entry.
+	mutable Mutex m_verification;										///< Mutex that allows writing to m_verified, m_verifying and m_unverifiedOverflow.
 	SizedBlockQueue<VerifiedBlock> m_verified;								///< List of blocks, in correct order, verified and ready for chain-import.
-	SizedBlockQueue<VerifiedBlock> m_verifying;								///< List of blocks being verified; as long as the block component (bytes) is empty, it's not finished.
-	SizedBlockQueue<UnverifiedBlock> m_unverified;							///< List of <block hash, parent hash, block data> in correct order, ready for verification.
+	SizedBlockQueue<VerifiedBlock> m_verifying;								///< List of blocks queued or being verified, in correct order; as long as the block component (bytes) is empty, it's not finished.
+	mpmc_queue<UnverifiedBlock> m_unverified;							///< <block hash, parent hash, block data> waiting for a verifier; their places in m_verifying are already taken.
+	std::deque<UnverifiedBlock> m_unverifiedOverflow;					///< Blocks that did not fit into m_unverified.
+	std::atomic<size_t> m_unverifiedOverflowCount = {0};				///< Size of m_unverifiedOverflow, readable without m_verification.
+	std::atomic<size_t> m_unverifiedSize = {0};							///< Bytes in m_unverified and m_unverifiedOverflow.
 
 	std::vector<std::thread> m_verifiers;								///< Threads who only verify.
 	std::atomic<bool> m_deleting = {false};								///< Exit condition for verifiers.
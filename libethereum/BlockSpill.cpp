@@ -0,0 +1,126 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BlockSpill.cpp
+ * @date 2026
+ */
+
+#include "BlockSpill.h"
+#include <boost/filesystem.hpp>
+#include <libdevcore/Log.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+namespace fs = boost::filesystem;
+
+BlockSpill::BlockSpill(fs::path const& _path, uint64_t _capacity):
+	m_path(_path),
+	m_capacity(_capacity)
+{
+	try
+	{
+		if (m_path.has_parent_path())
+			fs::create_directories(m_path.parent_path());
+	}
+	catch (fs::filesystem_error const& _e)
+	{
+		cwarn << "Can't create directory for block queue spill file:" << _e.what();
+	}
+	m_file.open(m_path.string(), ios::in | ios::out | ios::binary | ios::trunc);
+	if (!m_file.is_open())
+		cwarn << "Can't open block queue spill file" << m_path.string() << "- queued blocks will stay in memory.";
+}
+
+BlockSpill::~BlockSpill()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+		boost::system::error_code ec;
+		fs::remove(m_path, ec);
+	}
+}
+
+bool BlockSpill::overlapsLive(uint64_t _offset, uint64_t _size) const
+{
+	auto it = m_live.lower_bound(_offset);
+	if (it != m_live.end() && it->first < _offset + _size)
+		return true;
+	if (it != m_live.begin())
+	{
+		--it;
+		if (it->first + it->second > _offset)
+			return true;
+	}
+	return false;
+}
+
+bool BlockSpill::write(bytesConstRef _data, Extent& o_extent)
+{
+	if (!m_file.is_open() || _data.empty() || _data.size() > m_capacity)
+		return false;
+
+	uint64_t offset = m_head;
+	if (offset + _data.size() > m_capacity)
+		offset = 0;
+	if (overlapsLive(offset, _data.size()))
+		return false;
+
+	m_file.clear();
+	m_file.seekp(offset);
+	m_file.write(reinterpret_cast<char const*>(_data.data()), _data.size());
+	if (!m_file)
+	{
+		m_file.clear();
+		return false;
+	}
+
+	m_live[offset] = _data.size();
+	m_used += _data.size();
+	m_head = offset + _data.size();
+	o_extent.offset = offset;
+	o_extent.size = _data.size();
+	return true;
+}
+
+bool BlockSpill::take(Extent const& _extent, bytes& o_data)
+{
+	o_data.resize(_extent.size);
+	m_file.clear();
+	m_file.seekg(_extent.offset);
+	m_file.read(reinterpret_cast<char*>(o_data.data()), _extent.size);
+	bool const ok = !!m_file;
+	if (!ok)
+	{
+		m_file.clear();
+		o_data.clear();
+		cwarn << "Lost a block spilled at" << _extent.offset << "of the block queue spill file.";
+	}
+	free(_extent);
+	return ok;
+}
+
+void BlockSpill::free(Extent const& _extent)
+{
+	auto it = m_live.find(_extent.offset);
+	if (it == m_live.end())
+		return;
+	m_used -= it->second;
+	m_live.erase(it);
+	if (m_live.empty())
+		m_head = 0;
+}
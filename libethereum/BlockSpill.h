@@ -0,0 +1,82 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BlockSpill.h
+ * @date 2026
+ */
+
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <boost/filesystem/path.hpp>
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief A fixed-size file used as a ring buffer for block data that the BlockQueue would rather not keep in memory.
+ * Writes go at the head and wrap to the start of the file; a write that would overwrite a live entry is refused,
+ * so the caller keeps that block in memory instead. The file is truncated on opening: its contents only ever
+ * mirror the queue of this process.
+ * Not thread-safe; the BlockQueue only uses it under its own lock.
+ */
+class BlockSpill
+{
+public:
+	/// Where a spilled block lives in the file.
+	struct Extent
+	{
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	BlockSpill(boost::filesystem::path const& _path, uint64_t _capacity);
+	~BlockSpill();
+
+	/// @returns false if the file couldn't be opened; every write() is then refused.
+	bool isOpen() const { return m_file.is_open(); }
+
+	/// Writes @a _data at the head of the ring.
+	/// @returns false if there's no room before reaching live data.
+	bool write(bytesConstRef _data, Extent& o_extent);
+
+	/// Reads back and frees @a _extent. @returns false on I/O failure, in which case the block is lost.
+	bool take(Extent const& _extent, bytes& o_data);
+
+	/// Frees @a _extent without reading it.
+	void free(Extent const& _extent);
+
+	uint64_t capacity() const { return m_capacity; }
+	uint64_t used() const { return m_used; }
+	size_t entries() const { return m_live.size(); }
+
+private:
+	bool overlapsLive(uint64_t _offset, uint64_t _size) const;
+
+	boost::filesystem::path m_path;
+	std::fstream m_file;
+	uint64_t m_capacity;
+	uint64_t m_head = 0;					///< Where the next write goes, unless it has to wrap.
+	uint64_t m_used = 0;					///< Bytes in live entries.
+	std::map<uint64_t, uint64_t> m_live;	///< Offset to size of every live entry.
+};
+
+}
+}
@@ -85,6 +85,7 @@ Client::Client(
 
 Client::~Client()
 {
+	m_tq.senderStates().setReader(SenderStateCache::Reader());
 	stopWorking();
 	terminate();
 }
@@ -98,11 +99,22 @@ void Client::init(p2p::Host* _extNet, fs::path const& _dbPath, WithExisting _for
 	m_postSeal = m_preSeal;
 
 	m_bq.setChain(bc());
+	fs::path const spillPath = (_dbPath.empty() ? Defaults::dbPath() : _dbPath) / fs::path(toHex(bc().genesisHash().ref().cropped(0, 4))) / fs::path("blockqueue.ring");
+	m_bq.setSpill(spillPath, c_blockQueueSpillCapacity);
 
 	m_lastGetWork = std::chrono::system_clock::now() - chrono::seconds(30);
 	m_tqReady = m_tq.onReady([=](){ this->onTransactionQueueReady(); });	// TODO: should read m_tq->onReady(thisThread, syncTransactionQueue);
 	m_tqReplaced = m_tq.onReplaced([=](h256 const&){ m_needStateReset = true; });
+	m_tqCurrent = m_tq.onCurrent([=](Transaction const& _t){ this->onTransactionCurrent(_t); });
 	m_bqReady = m_bq.onReady([=](){ this->onBlockQueueReady(); });			// TODO: should read m_bq->onReady(thisThread, syncBlockQueue);
+	m_bqVerified = m_bq.onVerified([=](BlockHeader const& _h){ this->onBlockVerified(_h); });
+	m_tq.senderStates().setReader([=](Address const& _a){
+		// Verifier threads read concurrently, so each reads through its own view rather than m_preSeal.
+		ReadGuard l(x_preSeal);
+		State const s = m_preSeal.state().committedView();
+		l.unlock();
+		return SenderState{s.getNonce(_a), s.balance(_a)};
+	});
 	m_bq.setOnBad([=](Exception& ex){ this->onBadBlock(ex); });
 	bc().setOnBad([=](Exception& ex){ this->onBadBlock(ex); });
 	bc().setOnBlockImport([=](BlockHeader const& _info){
@@ -113,11 +125,12 @@ void Client::init(p2p::Host* _extNet, fs::path const& _dbPath, WithExisting _for
 	if (_forceAction == WithExisting::Rescue)
 		bc().rescue(m_stateDB);
 
-	m_gp->update(bc());
+	gasPricer()->update(bc());
 
 	auto host = _extNet->registerCapability(make_shared<EthereumHost>(bc(), m_stateDB, m_tq, m_bq, _networkId));
 	m_host = host;
 
+	_extNet->addCapability(host, EthereumHost::staticName(), EthereumHost::c_previousProtocolVersion); //TODO: remove this once v64+ protocol is common
 	_extNet->addCapability(host, EthereumHost::staticName(), EthereumHost::c_oldProtocolVersion); //TODO: remove this once v61+ protocol is common
 
 
@@ -185,6 +198,18 @@ void Client::setNetworkId(u256 const& _n)
 		h->setNetworkId(_n);
 }
 
+void Client::setSnapshotStorage(shared_ptr<SnapshotStorageFace const> _storage)
+{
+	if (auto h = m_host.lock())
+		h->setSnapshotStorage(_storage);
+}
+
+void Client::setSnapshotDownloader(shared_ptr<SnapshotDownloader> _downloader)
+{
+	if (auto h = m_host.lock())
+		h->setSnapshotDownloader(_downloader);
+}
+
 bool Client::isSyncing() const
 {
 	if (auto h = m_host.lock())
@@ -261,6 +286,9 @@ void Client::reopenChain(ChainParams const& _p, WithExisting _we)
 		m_working = Block(chainParams().accountStartNonce);
 
 		m_stateDB = OverlayDB();
+		m_recentBlocks.clear();
+		m_callResults.clear();
+		m_stateReads.clear();
 		bc().reopen(_p, _we);
 		m_stateDB = State::openDB(Defaults::dbPath(), bc().genesisHash(), _we);
 
@@ -415,7 +443,17 @@ void Client::syncTransactionQueue()
 			return;
 		}
 
-		tie(newPendingReceipts, m_syncTransactionQueue) = m_working.sync(bc(), m_tq, *m_gp);
+		Transactions arrived;
+		bool overflow = false;
+		DEV_GUARDED(x_arrived)
+		{
+			swap(arrived, m_arrived);
+			swap(overflow, m_arrivedOverflow);
+		}
+		if (overflow)
+			tie(newPendingReceipts, m_syncTransactionQueue) = m_working.sync(bc(), m_tq, *gasPricer());
+		else
+			tie(newPendingReceipts, m_syncTransactionQueue) = m_working.syncArrived(bc(), m_tq, *gasPricer(), arrived);
 	}
 
 	if (newPendingReceipts.empty())
@@ -430,8 +468,11 @@ void Client::syncTransactionQueue()
 			m_postSeal = m_working;
 
 	DEV_READ_GUARDED(x_postSeal)
+	{
+		size_t const first = m_postSeal.pending().size() - newPendingReceipts.size();
 		for (size_t i = 0; i < newPendingReceipts.size(); i++)
-			appendFromNewPending(newPendingReceipts[i], changeds, m_postSeal.pending()[i].sha3());
+			appendFromNewPending(newPendingReceipts[i], changeds, m_postSeal.pending()[first + i].sha3());
+	}
 
 	// Tell farm about new transaction (i.e. restart mining).
 	onPostStateChanged();
@@ -477,6 +518,34 @@ void Client::onNewBlocks(h256s const& _blocks, h256Hash& io_changed)
 		appendFromBlock(h, BlockPolarity::Live, io_changed);
 }
 
+void Client::onTransactionCurrent(Transaction const& _t)
+{
+	DEV_GUARDED(x_arrived)
+		if (m_arrived.size() < c_maxArrivedTransactions)
+			m_arrived.push_back(_t);
+		else
+			m_arrivedOverflow = true;
+}
+
+void Client::onBlockVerified(BlockHeader const& _header)
+{
+	// Called on a block queue verifier thread; the chain and seal engine are only touched from ours.
+	executeInMainThread([=]()
+	{
+		// By the time this runs the block has usually been imported already, so sealing on it is what's next.
+		if (!m_wouldSeal || isMajorSyncing() || (_header.parentHash() != bc().currentHash() && _header.hash() != bc().currentHash()))
+			return;
+		try
+		{
+			sealEngine()->prepareSeal(_header, [=](Address _a, BlockNumber _block) { return balanceAt(_a, _block); });
+		}
+		catch (std::exception const& _e)
+		{
+			cwarn << "Couldn't prepare to seal on" << _header.hash() << ":" << _e.what();
+		}
+	});
+}
+
 void Client::resyncStateFromChain()
 {
 	DEV_READ_GUARDED(x_working)
@@ -497,6 +566,16 @@ void Client::resyncStateFromChain()
 	{
 		DEV_WRITE_GUARDED(x_preSeal)
 			m_preSeal = newPreMine;
+		// Sender states read from the old m_preSeal are now stale wherever the new blocks touched them.
+		DEV_GUARDED(x_touched)
+		{
+			if (m_touchedLost)
+				m_tq.senderStates().clear();
+			else
+				m_tq.senderStates().noteImported(m_touched);
+			m_touched.clear();
+			m_touchedLost = false;
+		}
 		DEV_WRITE_GUARDED(x_working)
 			m_working = newPreMine;
 		DEV_READ_GUARDED(x_postSeal)
@@ -546,6 +625,12 @@ void Client::onChainChanged(ImportRoute const& _ir)
 		m_tq.dropGood(t);
 	}
 	onNewBlocks(_ir.liveBlocks, changeds);
+	gasPricer()->noteRoute(bc(), _ir);
+	DEV_GUARDED(x_touched)
+		if (!_ir.deadBlocks.empty() || m_touched.size() + _ir.touchedAccounts.size() > SenderStateCache::c_maxSize)
+			m_touchedLost = true;
+		else
+			m_touched += _ir.touchedAccounts;
 	if (!isMajorSyncing())
 		resyncStateFromChain();
 	noteChanged(changeds);
@@ -735,10 +820,14 @@ void Client::prepareForTransaction()
 
 Block Client::block(h256 const& _block) const
 {
+	Block cached(Block::Null);
+	if (m_recentBlocks.get(_block, cached))
+		return cached;
 	try
 	{
 		Block ret(bc(), m_stateDB);
 		ret.populateFromChain(bc(), _block);
+		m_recentBlocks.put(_block, ret);
 		return ret;
 	}
 	catch (Exception& ex)
@@ -41,6 +41,7 @@
 #include "ClientBase.h"
 #include "StateImporter.h"
 #include "BlockChainImporter.h"
+#include "SnapshotExporter.h"
 
 #include <boost/filesystem/path.hpp>
 
@@ -51,6 +52,12 @@ namespace eth
 
 class Client;
 class DownloadMan;
+class SnapshotDownloader;
+class SnapshotStorageFace;
+
+static const size_t c_recentBlocksCacheSize = 16;
+static const size_t c_maxArrivedTransactions = 4096;
+static const uint64_t c_blockQueueSpillCapacity = 1024 * 1024 * 1024;	///< Size of the ring file the block queue spills to.
 
 enum ClientWorkState
 {
@@ -94,8 +101,8 @@ public:
 	ChainParams const& chainParams() const { return bc().chainParams(); }
 
 	/// Resets the gas pricer to some other object.
-	void setGasPricer(std::shared_ptr<GasPricer> _gp) { m_gp = _gp; }
-	std::shared_ptr<GasPricer> gasPricer() const { return m_gp; }
+	void setGasPricer(std::shared_ptr<GasPricer> _gp) { _gp->update(bc()); std::atomic_store(&m_gp, _gp); }
+	std::shared_ptr<GasPricer> gasPricer() const { return std::atomic_load(&m_gp); }
 
 	/// Blocks until all pending transactions have been processed.
 	virtual void flushTransactions() override;
@@ -106,7 +113,7 @@ public:
 	/// Get the remaining gas limit in this block.
 	virtual u256 gasLimitRemaining() const override { return m_postSeal.gasLimitRemaining(); }
 	/// Get the gas bid price
-	virtual u256 gasBidPrice() const override { return m_gp->bid(); }
+	virtual u256 gasBidPrice() const override { return gasPricer()->bid(); }
 
 	// [PRIVATE API - only relevant for base clients, not available in general]
 	/// Get the block.
@@ -166,6 +173,11 @@ public:
 	/// Sets the network id.
 	void setNetworkId(u256 const& _n) override;
 
+	/// Serve the snapshot in @a _storage to peers.
+	void setSnapshotStorage(std::shared_ptr<SnapshotStorageFace const> _storage);
+	/// Fetch state through @a _downloader instead of syncing blocks; null resumes block sync.
+	void setSnapshotDownloader(std::shared_ptr<SnapshotDownloader> _downloader);
+
 	/// Get the seal engine.
 	SealEngineFace* sealEngine() const override { return bc().sealEngine(); }
 
@@ -192,6 +204,7 @@ public:
 
 	std::unique_ptr<StateImporterFace> createStateImporter() { return dev::eth::createStateImporter(m_stateDB); }
 	std::unique_ptr<BlockChainImporterFace> createBlockChainImporter() { return dev::eth::createBlockChainImporter(m_bc); }
+	std::unique_ptr<SnapshotExporter> createSnapshotExporter() const { return std::unique_ptr<SnapshotExporter>(new SnapshotExporter(m_stateDB, m_bc)); }
 
 	/// Queues a function to be executed in the main thread (that owns the blockchain, etc).
 	void executeInMainThread(std::function<void()> const& _function);
@@ -268,9 +281,16 @@ protected:
 	/// Magically called when m_tq needs syncing. Be nice and don't block.
 	void onTransactionQueueReady() { m_syncTransactionQueue = true; m_signalled.notify_all(); }
 
+	/// Called by m_tq for each transaction that becomes current; notes it for the next syncTransactionQueue().
+	void onTransactionCurrent(Transaction const& _t);
+
 	/// Magically called when m_bq needs syncing. Be nice and don't block.
 	void onBlockQueueReady() { m_syncBlockQueue = true; m_signalled.notify_all(); }
 
+	/// Called by m_bq's verifiers for each verified block; if it is or would become our parent, has our thread let the seal engine prepare.
+	/// @warning Called from a verifier thread.
+	void onBlockVerified(BlockHeader const& _header);
+
 	/// Called when the post state has changed (i.e. when more transactions are in it or we're sealing on a new block).
 	/// This updates m_sealingInfo.
 	void onPostStateChanged();
@@ -289,7 +309,7 @@ protected:
 	void callQueuedFunctions();
 
 	BlockChain m_bc;						///< Maintains block database and owns the seal engine.
-    std::shared_ptr<GasPricer> m_gp;		///< The gas pricer.
+    std::shared_ptr<GasPricer> m_gp;		///< The gas pricer. Replaced by setGasPricer() from any thread, so only accessed atomically.
     OverlayDB m_stateDB;					///< Acts as the central point for the state database, so multiple States can share it.
 	BlockQueue m_bq;						///< Maintains a list of incoming blocks not yet on the blockchain (to be imported).
 
@@ -310,7 +330,13 @@ protected:
 
 	Handler<> m_tqReady;
 	Handler<h256 const&> m_tqReplaced;
+	Handler<Transaction const&> m_tqCurrent;
 	Handler<> m_bqReady;
+	Handler<BlockHeader const&> m_bqVerified;
+
+	Mutex x_touched;						///< Lock on m_touched and m_touchedLost.
+	AddressHash m_touched;					///< Accounts changed by blocks imported since m_preSeal last moved.
+	bool m_touchedLost = false;				///< True if m_touched can't describe the change (reorganisation or too many accounts).
 
 	bool m_wouldSeal = false;				///< True if we /should/ be sealing.
 	bool m_wouldButShouldnot = false;		///< True if the last time we called rejigSealing wouldSeal() was true but sealer's shouldSeal() was false.
@@ -330,9 +356,14 @@ protected:
 	std::condition_variable m_signalled;
 	Mutex x_signalled;
 	std::atomic<bool> m_syncTransactionQueue = {false};
+	Mutex x_arrived;
+	Transactions m_arrived;					///< Transactions that became current in m_tq since the last syncTransactionQueue().
+	bool m_arrivedOverflow = false;			///< Did m_arrived fill up, so that the whole queue has to be gone through again?
 	std::atomic<bool> m_syncBlockQueue = {false};
 
 	bytes m_extraData;
+
+	mutable LruCache<h256, Block> m_recentBlocks{c_recentBlocksCacheSize};	///< Blocks recently materialised by block(h256), saving a re-enactment.
 };
 
 }
@@ -38,6 +38,26 @@ const char* WorkChannel::name() { return EthOrange "⚒" EthWhite "  "; }
 
 static const int64_t c_maxGasEstimate = 50000000;
 
+static thread_local ChainSnapshot const* t_pinnedSnapshot = nullptr;
+
+ScopedChainSnapshot::ScopedChainSnapshot(shared_ptr<ChainSnapshot const> const& _s):
+	m_snapshot(_s),
+	m_previous(t_pinnedSnapshot)
+{
+	if (m_snapshot)
+		t_pinnedSnapshot = m_snapshot.get();
+}
+
+ScopedChainSnapshot::~ScopedChainSnapshot()
+{
+	t_pinnedSnapshot = m_previous;
+}
+
+ChainSnapshot const* ScopedChainSnapshot::current()
+{
+	return t_pinnedSnapshot;
+}
+
 pair<h256, Address> ClientBase::submitTransaction(TransactionSkeleton const& _t, AccountKeys::Secret const& _secret)
 {
 	prepareForTransaction();
@@ -64,14 +84,28 @@ ExecutionResult ClientBase::call(Address const& _from, u256 _value, Address _des
 	try
 	{
 		Block temp = block(_blockNumber);
-		u256 nonce = temp.transactionsFrom(_from); // use the current nonce as eth_call does not change and not mined
 		u256 gas = _gas == Invalid256 ? gasLimitRemaining() : _gas;
 		u256 gasPrice = _gasPrice == Invalid256 ? gasBidPrice() : _gasPrice;
+
+		// The pending block gains transactions without its header changing, so it is never memoised.
+		// Otherwise key on the header the call runs against: for LatestBlock that is the unsealed
+		// successor of the head, whose number and timestamp differ from the head's own.
+		h256 key;
+		if (_blockNumber != PendingBlock)
+		{
+			key = sha3(rlpList(temp.info().hash(WithoutSeal), _from, _value, _dest, _data, gas, gasPrice, (unsigned)_ff));
+			if (m_callResults.get(key, ret))
+				return ret;
+		}
+
+		u256 nonce = temp.transactionsFrom(_from); // use the current nonce as eth_call does not change and not mined
 		Transaction t(_value, gasPrice, gas, _dest, _data, nonce);
 		t.forceSender(_from);
 		if (_ff == FudgeFactor::Lenient)
 			temp.mutableState().addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
 		ret = temp.execute(bc().lastBlockHashes(), t, Permanence::Reverted);
+		if (key)
+			m_callResults.put(key, ret);
 	}
 	catch (...)
 	{
@@ -87,45 +121,93 @@ std::pair<u256, ExecutionResult> ClientBase::estimateGas(Address const& _from, u
 		int64_t upperBound = _maxGas;
 		if (upperBound == Invalid256 || upperBound > c_maxGasEstimate)
 			upperBound = c_maxGasEstimate;
-		int64_t lowerBound = Transaction::baseGasRequired(!_dest, &_data, EVMSchedule());
+		// Highest limit known to fail: anything below the intrinsic cost.
+		int64_t lowerBound = Transaction::baseGasRequired(!_dest, &_data, EVMSchedule()) - 1;
 		Block bk = block(_blockNumber);
 		u256 gasPrice = _gasPrice == Invalid256 ? gasBidPrice() : _gasPrice;
-		ExecutionResult er;
-		ExecutionResult lastGood;
-		bool good = false;
-		while (upperBound != lowerBound)
+		u256 const nonce = bk.transactionsFrom(_from);
+		SealEngineFace const& sealEngine = *bc().sealEngine();
+
+		// One overlay serves every trial: each run is rolled back to this savepoint rather than
+		// thrown away, so the accounts and storage it loaded stay cached for the next one.
+		State tempState(bk.state());
+		tempState.addBalance(_from, (u256)(upperBound * gasPrice + _value));
+		size_t const savept = tempState.savepoint();
+
+		auto trial = [&](int64_t _gas)
 		{
-			int64_t mid = (lowerBound + upperBound) / 2;
-			u256 n = bk.transactionsFrom(_from);
 			Transaction t;
 			if (_dest)
-				t = Transaction(_value, gasPrice, mid, _dest, _data, n);
+				t = Transaction(_value, gasPrice, _gas, _dest, _data, nonce);
 			else
-				t = Transaction(_value, gasPrice, mid, _data, n);
+				t = Transaction(_value, gasPrice, _gas, _data, nonce);
 			t.forceSender(_from);
-			EnvInfo const env(bk.info(), bc().lastBlockHashes(), 0, mid);
-			State tempState(bk.state());
-			tempState.addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
-			er = tempState.execute(env, *bc().sealEngine(), t, Permanence::Reverted).first;
-			if (er.excepted == TransactionException::OutOfGas ||
-				er.excepted == TransactionException::OutOfGasBase ||
-				er.excepted == TransactionException::OutOfGasIntrinsic ||
-				er.codeDeposit == CodeDeposit::Failed ||
-				er.excepted == TransactionException::BadJumpDestination)
-					lowerBound = lowerBound == mid ? upperBound : mid;
+			EnvInfo const env(bk.info(), bc().lastBlockHashes(), 0, _gas, sealEngine.chainParams().chainID);
+			ExecutionResult ret = tempState.execute(env, sealEngine, t, Permanence::Uncommitted).first;
+			tempState.rollback(savept);
+			return ret;
+		};
+		auto ranOutOfGas = [](ExecutionResult const& _er)
+		{
+			return _er.excepted == TransactionException::OutOfGas ||
+				_er.excepted == TransactionException::OutOfGasBase ||
+				_er.excepted == TransactionException::OutOfGasIntrinsic ||
+				_er.codeDeposit == CodeDeposit::Failed ||
+				_er.excepted == TransactionException::BadJumpDestination;
+		};
+		auto progress = [&]()
+		{
+			if (_callback)
+				_callback(GasEstimationProgress { lowerBound, upperBound });
+		};
+
+		// Run once with the full allowance. If that fails, no smaller limit can succeed.
+		ExecutionResult lastGood = trial(upperBound);
+		if (ranOutOfGas(lastGood))
+		{
+			lowerBound = upperBound;
+			progress();
+			return make_pair(upperBound, lastGood);
+		}
+
+		// gasUsed is net of the refund, which is capped at half the gas consumed; undo it to get
+		// the peak consumption, which no successful limit can be below.
+		int64_t const used = static_cast<int64_t>(lastGood.gasUsed);
+		int64_t const peak = min(used * 2, used + static_cast<int64_t>(min<u256>(lastGood.gasRefunded, c_maxGasEstimate)));
+		lowerBound = max(lowerBound, min(peak, upperBound) - 1);
+		progress();
+
+		// Calls only forward 63/64 of the remaining gas, so nested frames may need a little more
+		// than the peak. Try that margin first: usually it settles the estimate in one more run.
+		int64_t const optimistic = min(upperBound, peak + peak / 63 + 1);
+		if (optimistic < upperBound)
+		{
+			ExecutionResult er = trial(optimistic);
+			if (ranOutOfGas(er))
+				lowerBound = optimistic;
 			else
 			{
 				lastGood = er;
-				upperBound = upperBound == mid ? lowerBound : mid;
-				good = true;
+				upperBound = optimistic;
 			}
+			progress();
+		}
 
-			if (_callback)
-				_callback(GasEstimationProgress { lowerBound, upperBound });
+		// Bisect whatever gap remains; lowerBound always fails, upperBound always succeeds.
+		while (lowerBound + 1 < upperBound)
+		{
+			int64_t mid = lowerBound + (upperBound - lowerBound) / 2;
+			ExecutionResult er = trial(mid);
+			if (ranOutOfGas(er))
+				lowerBound = mid;
+			else
+			{
+				lastGood = er;
+				upperBound = mid;
+			}
+			progress();
 		}
-		if (_callback)
-			_callback(GasEstimationProgress { lowerBound, upperBound });
-		return make_pair(upperBound, good ? lastGood : er);
+		return make_pair(upperBound, lastGood);
 	}
 	catch (...)
 	{
@@ -139,9 +221,36 @@ ImportResult ClientBase::injectBlock(bytes const& _block)
 	return bc().attemptImport(_block, preSeal().db()).first;
 }
 
+template <class F> u256 ClientBase::cachedStateRead(BlockNumber _block, bytes const& _query, F const& _read) const
+{
+	if (_block == PendingBlock)
+		return _read(pendingBlock());
+
+	// Resolve the latest block through the block itself, as the chain head may already have moved past it.
+	Block latest(Block::Null);
+	h256 blockHash;
+	if (_block == LatestBlock)
+	{
+		latest = latestBlock();
+		blockHash = latest.previousInfo().hash();
+	}
+	else
+		blockHash = bc().numberHash(_block);
+	if (!blockHash)
+		return _read(block(blockHash));
+
+	h256 key = sha3(blockHash.asBytes() + _query);
+	u256 ret;
+	if (m_stateReads.get(key, ret))
+		return ret;
+	ret = _read(_block == LatestBlock ? latest : block(blockHash));
+	m_stateReads.put(key, ret);
+	return ret;
+}
+
 u256 ClientBase::balanceAt(Address _a, BlockNumber _block) const
 {
-	return block(_block).balance(_a);
+	return cachedStateRead(_block, rlpList("balance", _a), [&](Block const& _b) { return _b.balance(_a); });
 }
 
 u256 ClientBase::countAt(Address _a, BlockNumber _block) const
@@ -151,7 +260,7 @@ u256 ClientBase::countAt(Address _a, BlockNumber _block) const
 
 u256 ClientBase::stateAt(Address _a, u256 _l, BlockNumber _block) const
 {
-	return block(_block).storage(_a, _l);
+	return cachedStateRead(_block, rlpList("storage", _a, _l), [&](Block const& _b) { return _b.storage(_a, _l); });
 }
 
 h256 ClientBase::stateRootAt(Address _a, BlockNumber _block) const
@@ -459,27 +568,29 @@ unsigned ClientBase::uncleCount(h256 _blockHash) const
 
 unsigned ClientBase::number() const
 {
+	if (auto s = ScopedChainSnapshot::current())
+		return s->latestNumber;
 	return bc().number();
 }
 
 Transactions ClientBase::pending() const
 {
-	return postSeal().pending();
+	return pendingBlock().pending();
 }
 
 h256s ClientBase::pendingHashes() const
 {
-	return h256s() + postSeal().pendingHashes();
+	return h256s() + pendingBlock().pendingHashes();
 }
 
 BlockHeader ClientBase::pendingInfo() const
 {
-	return postSeal().info();
+	return pendingBlock().info();
 }
 
 BlockDetails ClientBase::pendingDetails() const
 {
-	auto pm = postSeal().info();
+	auto pm = pendingBlock().info();
 	auto li = Interface::blockDetails(LatestBlock);
 	return BlockDetails((unsigned)pm.number(), li.totalDifficulty + pm.difficulty(), pm.parentHash(), h256s{});
 }
@@ -507,16 +618,20 @@ h256 ClientBase::hashFromNumber(BlockNumber _number) const
 	if (_number == PendingBlock)
 		return h256();
 	if (_number == LatestBlock)
+	{
+		if (auto s = ScopedChainSnapshot::current())
+			return s->latestHash;
 		return bc().currentHash();
+	}
 	return bc().numberHash(_number);
 }
 
 BlockNumber ClientBase::numberFromHash(h256 _blockHash) const
 {
 	if (_blockHash == PendingBlockHash)
-		return bc().number() + 1;
+		return number() + 1;
 	else if (_blockHash == LatestBlockHash)
-		return bc().number();
+		return number();
 	else if (_blockHash == EarliestBlockHash)
 		return 0;
 	return bc().number(_blockHash);
@@ -562,8 +677,30 @@ bool ClientBase::isKnownTransaction(h256 const& _blockHash, unsigned _i) const
 Block ClientBase::block(BlockNumber _h) const
 {
 	if (_h == PendingBlock)
-		return postSeal();
+		return pendingBlock();
 	else if (_h == LatestBlock)
-		return preSeal();
+		return latestBlock();
 	return block(bc().numberHash(_h));
 }
+
+Block ClientBase::latestBlock() const
+{
+	if (auto s = ScopedChainSnapshot::current())
+		return s->latest;
+	return preSeal();
+}
+
+Block ClientBase::pendingBlock() const
+{
+	if (auto s = ScopedChainSnapshot::current())
+		return s->pending;
+	return postSeal();
+}
+
+shared_ptr<ChainSnapshot const> ClientBase::snapshot() const
+{
+	auto ret = make_shared<ChainSnapshot>(ChainSnapshot{preSeal(), postSeal(), h256(), 0});
+	ret->latestHash = ret->latest.previousInfo().hash();
+	ret->latestNumber = (unsigned)ret->latest.previousInfo().number();
+	return ret;
+}
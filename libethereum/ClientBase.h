@@ -23,6 +23,7 @@
 #pragma once
 
 #include <chrono>
+#include <libdevcore/LruCache.h>
 #include "Interface.h"
 #include "LogFilter.h"
 #include "TransactionQueue.h"
@@ -47,6 +48,9 @@ struct InstalledFilter
 static const h256 PendingChangedFilter = u256(0);
 static const h256 ChainChangedFilter = u256(1);
 
+static const size_t c_callResultCacheSize = 4096;
+static const size_t c_stateReadCacheSize = 65536;
+
 static const LogEntry SpecialLogEntry = LogEntry(Address(), h256s(), bytes());
 static const LocalisedLogEntry InitialChange(SpecialLogEntry);
 
@@ -73,6 +77,37 @@ struct WorkChannel: public LogChannel { static const char* name(); static const
 #define cworkin LogOutputStream<WorkInChannel, true>()
 #define cworkout LogOutputStream<WorkOutChannel, true>()
 
+/// The chain head and the pending block as they stood at one instant.
+struct ChainSnapshot
+{
+	Block latest;			///< Equivalent of ClientBase::preSeal() at capture time.
+	Block pending;			///< Equivalent of ClientBase::postSeal() at capture time.
+	h256 latestHash;		///< Hash of the chain head @a latest was built on.
+	unsigned latestNumber;	///< Number of the chain head @a latest was built on.
+};
+
+/**
+ * @brief Pins a ChainSnapshot to the calling thread for the lifetime of the object.
+ * While pinned, every LatestBlock/PendingBlock query made through ClientBase on this thread
+ * resolves against the snapshot rather than the live chain. Scopes nest; a null snapshot pins nothing.
+ */
+class ScopedChainSnapshot
+{
+public:
+	explicit ScopedChainSnapshot(std::shared_ptr<ChainSnapshot const> const& _s);
+	~ScopedChainSnapshot();
+
+	ScopedChainSnapshot(ScopedChainSnapshot const&) = delete;
+	ScopedChainSnapshot& operator=(ScopedChainSnapshot const&) = delete;
+
+	/// @returns the snapshot pinned to the calling thread, if any.
+	static ChainSnapshot const* current();
+
+private:
+	std::shared_ptr<ChainSnapshot const> m_snapshot;
+	ChainSnapshot const* m_previous;
+};
+
 class ClientBase: public Interface
 {
 public:
@@ -146,10 +181,12 @@ public:
 	virtual EVMSchedule evmSchedule() const override { return sealEngine()->evmSchedule(pendingInfo().number()); }
 
 	virtual ImportResult injectTransaction(bytes const& _rlp, IfDropped _id = IfDropped::Ignore) override { prepareForTransaction(); return m_tq.import(_rlp, _id); }
+	virtual std::vector<std::pair<ImportResult, h256>> injectTransactions(std::vector<bytes> _rlps, IfDropped _id = IfDropped::Ignore) override { prepareForTransaction(); return m_tq.importBatch(std::move(_rlps), _id); }
 	virtual ImportResult injectBlock(bytes const& _block) override;
 
 	using Interface::addresses;
 	virtual Addresses addresses(BlockNumber _block) const override;
+	virtual std::shared_ptr<ChainSnapshot const> snapshot() const override;
 	virtual u256 gasLimitRemaining() const override;
 	virtual u256 gasBidPrice() const override { return DefaultGasPrice; }
 
@@ -180,6 +217,13 @@ protected:
 	virtual void prepareForTransaction() = 0;
 	/// }
 
+	/// preSeal() and postSeal(), unless a ChainSnapshot is pinned to the calling thread.
+	Block latestBlock() const;
+	Block pendingBlock() const;
+
+	/// Answers @a _read against @a _block, memoised by block hash and @a _query unless @a _block is pending.
+	template <class F> u256 cachedStateRead(BlockNumber _block, bytes const& _query, F const& _read) const;
+
 	TransactionQueue m_tq;							///< Maintains a list of incoming transactions not yet in a block on the blockchain.
 
 	// filters
@@ -188,6 +232,10 @@ protected:
 	std::unordered_map<h256, h256s> m_specialFilters = std::unordered_map<h256, std::vector<h256>>{{PendingChangedFilter, {}}, {ChainChangedFilter, {}}};
 															///< The dictionary of special filters and their additional data
 	std::map<unsigned, ClientWatch> m_watches;				///< Each and every watch - these reference a filter.
+
+	// Results of queries against non-pending blocks. Keys include the block hash, so a new head simply stops hitting old entries.
+	mutable LruCache<h256, ExecutionResult> m_callResults{c_callResultCacheSize};	///< call() results.
+	mutable LruCache<h256, u256> m_stateReads{c_stateReadCacheSize};				///< balanceAt() and stateAt() results.
 };
 
 }}
@@ -51,6 +51,10 @@ static const unsigned c_maxPayload = 262144;	///< Maximum size of packet for us
 #endif
 static const unsigned c_maxNodes = c_maxBlocks; ///< Maximum number of nodes will ever send.
 static const unsigned c_maxReceipts = c_maxBlocks; ///< Maximum number of receipts will ever send.
+static const unsigned c_maxIncomingTransactionHashes = 4096; ///< Maximum number of hashes a NewTransactionHashes packet may carry.
+static const unsigned c_maxTransactionsAsk = 256; ///< Maximum number of transactions we ask for in, or return for, one GetPooledTransactions.
+static const unsigned c_transactionAnnouncementVersion = 64; ///< First protocol version understanding transaction hash announcements.
+static const unsigned c_snapshotSyncVersion = 64; ///< First protocol version serving snapshot manifests and chunks.
 
 class BlockChain;
 class TransactionQueue;
@@ -67,11 +71,17 @@ enum SubprotocolPacketType: byte
 	GetBlockBodiesPacket = 0x05,
 	BlockBodiesPacket = 0x06,
 	NewBlockPacket = 0x07,
+	NewTransactionHashesPacket = 0x08,	///< Hashes of transactions the sender has; ask for unknown ones with GetPooledTransactions.
+	GetPooledTransactionsPacket = 0x09,	///< Answered with a TransactionsPacket of those requested transactions still queued.
 
 	GetNodeDataPacket = 0x0d,
 	NodeDataPacket = 0x0e,
 	GetReceiptsPacket = 0x0f,
 	ReceiptsPacket = 0x10,
+	GetSnapshotManifestPacket = 0x11,	///< Answered with a SnapshotManifestPacket, empty if no snapshot is served.
+	SnapshotManifestPacket = 0x12,
+	GetSnapshotDataPacket = 0x13,		///< Asks for one compressed snapshot chunk by its hash.
+	SnapshotDataPacket = 0x14,
 
 	PacketCount
 };
@@ -83,6 +93,8 @@ enum class Asking
 	BlockBodies,
 	NodeData,
 	Receipts,
+	SnapshotManifest,
+	SnapshotData,
 	Nothing
 };
 
@@ -22,6 +22,7 @@
 #include "EthereumHost.h"
 
 #include <chrono>
+#include <cmath>
 #include <thread>
 #include <libdevcore/Common.h>
 #include <libp2p/Host.h>
@@ -32,14 +33,18 @@
 #include "BlockQueue.h"
 #include "EthereumPeer.h"
 #include "BlockChainSync.h"
+#include "SnapshotDownloader.h"
 
 using namespace std;
 using namespace dev;
 using namespace dev::eth;
 using namespace p2p;
 
+unsigned const EthereumHost::c_previousProtocolVersion = 63; //TODO: remove this once v64+ is common
 unsigned const EthereumHost::c_oldProtocolVersion = 62; //TODO: remove this once v63+ is common
 static unsigned const c_maxSendTransactions = 256;
+static unsigned const c_transactionRequestTimeout = 10;	///< Seconds before an announced transaction is asked for again, from whoever announces it next.
+static unsigned const c_maxRequestedTransactions = 16384;	///< Outstanding requests tracked before expired ones are pruned.
 
 char const* const EthereumHost::s_stateNames[static_cast<int>(SyncState::Size)] = {"NotSynced", "Idle", "Waiting", "Blocks", "State"};
 
@@ -54,7 +59,7 @@ namespace
 class EthereumPeerObserver: public EthereumPeerObserverFace
 {
 public:
-	EthereumPeerObserver(BlockChainSync& _sync, RecursiveMutex& _syncMutex, TransactionQueue& _tq): m_sync(_sync), m_syncMutex(_syncMutex), m_tq(_tq) {}
+	EthereumPeerObserver(EthereumHost& _host, BlockChainSync& _sync, RecursiveMutex& _syncMutex, TransactionQueue& _tq): m_host(_host), m_sync(_sync), m_syncMutex(_syncMutex), m_tq(_tq) {}
 
 	void onPeerStatus(std::shared_ptr<EthereumPeer> _peer) override
 	{
@@ -75,11 +80,46 @@ public:
 	{
 		unsigned itemCount = _r.itemCount();
 		clog(EthereumHostTrace) << "Transactions (" << dec << itemCount << "entries)";
-		m_tq.enqueue(_r, _peer->id());
+		m_tq.enqueue(_r, _peer->id(), _peer->packet());
+	}
+
+	void onPeerTransactionHashes(std::shared_ptr<EthereumPeer> _peer, h256s const& _hashes) override
+	{
+		clog(EthereumHostTrace) << "Transaction hashes (" << dec << _hashes.size() << "entries)";
+		DEV_GUARDED(_peer->x_knownTransactions)
+			for (auto const& h: _hashes)
+				_peer->m_knownTransactions.insert(h);
+
+		// Ask the announcing peer for what we lack, unless another peer was asked for it recently.
+		h256s wanted;
+		time_t const now = chrono::system_clock::to_time_t(chrono::system_clock::now());
+		DEV_GUARDED(x_requestedTransactions)
+		{
+			if (m_requestedTransactions.size() > c_maxRequestedTransactions)
+				for (auto it = m_requestedTransactions.begin(); it != m_requestedTransactions.end();)
+					it = now - it->second >= c_transactionRequestTimeout ? m_requestedTransactions.erase(it) : next(it);
+
+			for (auto const& h: _hashes)
+			{
+				if (m_tq.isKnown(h))
+					continue;
+				auto it = m_requestedTransactions.find(h);
+				if (it != m_requestedTransactions.end() && now - it->second < c_transactionRequestTimeout)
+					continue;
+				m_requestedTransactions[h] = now;
+				wanted.push_back(h);
+			}
+		}
+
+		for (size_t i = 0; i < wanted.size(); i += c_maxTransactionsAsk)
+			_peer->requestTransactions(h256s(wanted.begin() + i, wanted.begin() + min<size_t>(wanted.size(), i + c_maxTransactionsAsk)));
 	}
 
 	void onPeerAborting() override
 	{
+		if (auto downloader = m_host.snapshotDownloader())
+			downloader->onPeerAborting();
+
 		RecursiveGuard l(m_syncMutex);
 		try
 		{
@@ -163,16 +203,34 @@ public:
 		clog(EthereumHostTrace) << "Receipts (" << dec << itemCount << "entries)";
 	}
 
+	void onPeerSnapshotManifest(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
+	{
+		clog(EthereumHostTrace) << "Snapshot manifest (" << dec << _r.itemCount() << "entries)";
+		if (auto downloader = m_host.snapshotDownloader())
+			downloader->onPeerManifest(_peer, _r);
+	}
+
+	void onPeerSnapshotData(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
+	{
+		clog(EthereumHostTrace) << "Snapshot data (" << dec << _r.itemCount() << "entries)";
+		if (auto downloader = m_host.snapshotDownloader())
+			downloader->onPeerData(_peer, _r);
+	}
+
 private:
+	EthereumHost& m_host;
 	BlockChainSync& m_sync;
 	RecursiveMutex& m_syncMutex;
 	TransactionQueue& m_tq;
+
+	Mutex x_requestedTransactions;
+	std::unordered_map<h256, time_t> m_requestedTransactions;	///< Announced transactions we asked for, and when.
 };
 
 class EthereumHostData: public EthereumHostDataFace
 {
 public:
-	EthereumHostData(BlockChain const& _chain, OverlayDB const& _db): m_chain(_chain), m_db(_db) {}
+	EthereumHostData(BlockChain const& _chain, OverlayDB const& _db, TransactionQueue const& _tq): m_chain(_chain), m_db(_db), m_tq(_tq) {}
 
 	pair<bytes, unsigned> blockHeaders(RLP const& _blockId, unsigned _maxHeaders, u256 _skip, bool _reverse) const override
 	{
@@ -367,9 +425,71 @@ public:
 		return make_pair(rlp, n);
 	}
 
+	pair<bytes, unsigned> pooledTransactions(RLP const& _txHashes) const override
+	{
+		unsigned const count = static_cast<unsigned>(_txHashes.itemCount());
+
+		h256s hashes;
+		for (unsigned i = 0; i < min(count, c_maxTransactionsAsk); ++i)
+			hashes.push_back(_txHashes[i].toHash<h256>());
+
+		bytes rlp;
+		unsigned n = 0;
+		for (auto const& t: m_tq.transactions(hashes))
+		{
+			if (rlp.size() >= c_maxPayload)
+				break;
+			rlp += t.rlp();
+			++n;
+		}
+		clog(NetMessageSummary) << n << " transactions known and returned;" << (hashes.size() - n) << " unknown;" << (count > c_maxTransactionsAsk ? count - c_maxTransactionsAsk : 0) << " ignored";
+
+		return make_pair(rlp, n);
+	}
+
+	bytes snapshotManifest() const override
+	{
+		auto storage = snapshotStorage();
+		if (!storage)
+			return bytes();
+		try
+		{
+			return storage->readManifest();
+		}
+		catch (Exception const&)
+		{
+			clog(NetWarn) << "Can't serve snapshot manifest: " << boost::current_exception_diagnostic_information();
+		}
+		return bytes();
+	}
+
+	string snapshotData(h256 const& _chunkHash) const override
+	{
+		auto storage = snapshotStorage();
+		if (!storage)
+			return string();
+		try
+		{
+			return storage->readCompressedChunk(_chunkHash);
+		}
+		catch (Exception const&)
+		{
+			clog(NetMessageSummary) << "Snapshot chunk " << _chunkHash << " unknown";
+		}
+		return string();
+	}
+
+	void setSnapshotStorage(shared_ptr<SnapshotStorageFace const> _storage) { Guard l(x_snapshotStorage); m_snapshotStorage = _storage; }
+
 private:
+	shared_ptr<SnapshotStorageFace const> snapshotStorage() const { Guard l(x_snapshotStorage); return m_snapshotStorage; }
+
 	BlockChain const& m_chain;
 	OverlayDB const& m_db;
+	TransactionQueue const& m_tq;
+
+	mutable Mutex x_snapshotStorage;
+	shared_ptr<SnapshotStorageFace const> m_snapshotStorage;	///< Snapshot served to peers, if any
 };
 
 }
@@ -382,12 +502,12 @@ EthereumHost::EthereumHost(BlockChain const& _ch, OverlayDB const& _db, Transact
 	m_tq		(_tq),
 	m_bq		(_bq),
 	m_networkId	(_networkId),
-	m_hostData(make_shared<EthereumHostData>(m_chain, m_db))
+	m_hostData(make_shared<EthereumHostData>(m_chain, m_db, m_tq))
 {
 	// TODO: Composition would be better. Left like that to avoid initialization
 	//       issues as BlockChainSync accesses other EthereumHost members.
 	m_sync.reset(new BlockChainSync(*this));
-	m_peerObserver = make_shared<EthereumPeerObserver>(*m_sync, x_sync, m_tq);
+	m_peerObserver = make_shared<EthereumPeerObserver>(*this, *m_sync, x_sync, m_tq);
 	m_latestBlockSent = _ch.currentHash();
     m_tq.onImport([this](ImportResult _ir, h256 const& _h, p2p::NodeID const& _nodeId) { onTransactionImported(_ir, _h, _nodeId); });
 }
@@ -452,6 +572,15 @@ void EthereumHost::doWork()
 	{
 		m_lastTick = now;
 		foreachPeer([](std::shared_ptr<EthereumPeer> _p) { _p->tick(); return true; });
+
+		// Keep every idle peer busy fetching snapshot chunks, including ones that joined since.
+		if (auto downloader = snapshotDownloader())
+			foreachPeer([&](std::shared_ptr<EthereumPeer> _p)
+			{
+				if (!_p->isConversing())
+					downloader->requestNext(_p);
+				return true;
+			});
 	}
 
 //	return netChange;
@@ -459,47 +588,107 @@ void EthereumHost::doWork()
 	(void)netChange;
 }
 
+void EthereumHost::setSnapshotStorage(shared_ptr<SnapshotStorageFace const> _storage)
+{
+	static_pointer_cast<EthereumHostData>(m_hostData)->setSnapshotStorage(_storage);
+}
+
+void EthereumHost::setSnapshotDownloader(shared_ptr<SnapshotDownloader> _downloader)
+{
+	{
+		Guard l(x_snapshot);
+		m_snapshotDownloader = _downloader;
+	}
+	if (!_downloader)
+	{
+		// Carry on with blocks from wherever the snapshot left the chain.
+		RecursiveGuard l(x_sync);
+		m_sync->restartSync();
+		m_sync->continueSync();
+	}
+}
+
 void EthereumHost::maintainTransactions()
 {
 	// Send any new transactions.
-	unordered_map<std::shared_ptr<EthereumPeer>, std::vector<size_t>> peerTransactions;
 	auto ts = m_tq.topTransactions(c_maxSendTransactions);
+
+	// Hash and encode each transaction once; every peer's packet is assembled from these.
+	h256s hashes;
+	vector<bytes> encoded;
+	vector<bool> unsent;
+	hashes.reserve(ts.size());
+	encoded.reserve(ts.size());
+	unsent.reserve(ts.size());
 	{
 		Guard l(x_transactions);
-		for (size_t i = 0; i < ts.size(); ++i)
+		for (auto const& t: ts)
 		{
-			auto const& t = ts[i];
-			bool unsent = !m_transactionsSent.count(t.sha3());
-			auto peers = get<1>(randomSelection(0, [&](EthereumPeer* p) { return p->m_requireTransactions || (unsent && !p->m_knownTransactions.count(t.sha3())); }));
-			for (auto const& p: peers)
-				peerTransactions[p].push_back(i);
+			hashes.push_back(t.sha3());
+			encoded.push_back(t.rlp());
+			unsent.push_back(m_transactionsSent.insert(hashes.back()).second);
 		}
-		for (auto const& t: ts)
-			m_transactionsSent.insert(t.sha3());
 	}
-	foreachPeer([&](shared_ptr<EthereumPeer> _p)
+
+	// Take the peer set once for the whole round.
+	vector<shared_ptr<EthereumPeer>> peers;
+	foreachPeer([&](shared_ptr<EthereumPeer> _p) { peers.push_back(move(_p)); return true; });
+
+	// Full transactions still go to a random square-root sized subset of the peers that understand
+	// announcements, so they spread quickly; the others are sent hashes and fetch what they lack.
+	vector<shared_ptr<EthereumPeer>> announcing;
+	for (auto const& p: peers)
+		if (p->announcesTransactions())
+			announcing.push_back(p);
+	for (auto push = static_cast<size_t>(ceil(sqrt(announcing.size()))); push && announcing.size(); --push)
+		announcing.erase(announcing.begin() + rand() % announcing.size());
+	unordered_set<shared_ptr<EthereumPeer>> const announceOnly(announcing.begin(), announcing.end());
+
+	for (auto const& p: peers)
 	{
-		bytes b;
-		unsigned n = 0;
-		for (auto const& i: peerTransactions[_p])
+		bool const all = p->m_requireTransactions;
+		if (!all && announceOnly.count(p))
 		{
-			_p->m_knownTransactions.insert(ts[i].sha3());
-			b += ts[i].rlp();
-			++n;
+			h256s announce;
+			DEV_GUARDED(p->x_knownTransactions)
+				for (size_t i = 0; i < ts.size(); ++i)
+					if (unsent[i] && !p->m_knownTransactions.contains(hashes[i]))
+					{
+						p->m_knownTransactions.insert(hashes[i]);
+						announce.push_back(hashes[i]);
+					}
+			if (!announce.empty())
+			{
+				RLPStream s;
+				p->prep(s, NewTransactionHashesPacket, announce.size());
+				for (auto const& h: announce)
+					s << h;
+				p->sealAndSend(s);
+				clog(EthereumHostTrace) << "Announced" << announce.size() << "transactions to " << p->session()->info().clientVersion;
+			}
+			continue;
 		}
 
-		_p->clearKnownTransactions();
+		bytes b;
+		unsigned n = 0;
+		DEV_GUARDED(p->x_knownTransactions)
+			for (size_t i = 0; i < ts.size(); ++i)
+				if (all || (unsent[i] && !p->m_knownTransactions.contains(hashes[i])))
+				{
+					p->m_knownTransactions.insert(hashes[i]);
+					b += encoded[i];
+					++n;
+				}
 
-		if (n || _p->m_requireTransactions)
+		if (n || all)
 		{
-			RLPStream ts;
-			_p->prep(ts, TransactionsPacket, n).appendRaw(b, n);
-			_p->sealAndSend(ts);
-			clog(EthereumHostTrace) << "Sent" << n << "transactions to " << _p->session()->info().clientVersion;
+			RLPStream s;
+			p->prep(s, TransactionsPacket, n).appendRaw(b, n);
+			p->sealAndSend(s);
+			clog(EthereumHostTrace) << "Sent" << n << "transactions to " << p->session()->info().clientVersion;
 		}
-		_p->m_requireTransactions = false;
-		return true;
-	});
+		p->m_requireTransactions = false;
+	}
 }
 
 void EthereumHost::foreachPeer(std::function<bool(std::shared_ptr<EthereumPeer>)> const& _f) const
@@ -514,11 +703,14 @@ void EthereumHost::foreachPeer(std::function<bool(std::shared_ptr<EthereumPeer>)
 		if (!_f(capabilityFromSession<EthereumPeer>(*s.first)))
 			return;
 
-	sessions = peerSessions(c_oldProtocolVersion); //TODO: remove once v61+ is common
-	std::sort(sessions.begin(), sessions.end(), sessionLess);
-	for (auto s: sessions)
-		if (!_f(capabilityFromSession<EthereumPeer>(*s.first, c_oldProtocolVersion)))
-			return;
+	for (unsigned version: {c_previousProtocolVersion, c_oldProtocolVersion}) //TODO: remove once v64+ is common
+	{
+		sessions = peerSessions(version);
+		std::sort(sessions.begin(), sessions.end(), sessionLess);
+		for (auto s: sessions)
+			if (!_f(capabilityFromSession<EthereumPeer>(*s.first, version)))
+				return;
+	}
 }
 
 tuple<vector<shared_ptr<EthereumPeer>>, vector<shared_ptr<EthereumPeer>>, vector<shared_ptr<SessionFace>>> EthereumHost::randomSelection(unsigned _percent, std::function<bool(EthereumPeer*)> const& _allow)
@@ -617,6 +809,8 @@ void EthereumHost::onTransactionImported(ImportResult _ir, h256 const& _h, p2p::
 		return;
 
 	std::shared_ptr<EthereumPeer> peer = capabilityFromSession<EthereumPeer>(*session);
+	if (!peer)
+		peer = capabilityFromSession<EthereumPeer>(*session, c_previousProtocolVersion);
 	if (!peer)
 		peer = capabilityFromSession<EthereumPeer>(*session, c_oldProtocolVersion);
 	if (!peer)
@@ -50,6 +50,8 @@ namespace eth
 class TransactionQueue;
 class BlockQueue;
 class BlockChainSync;
+class SnapshotDownloader;
+class SnapshotStorageFace;
 
 struct EthereumHostTrace: public LogChannel { static const char* name(); static const int verbosity = 6; };
 
@@ -90,6 +92,13 @@ public:
 	h256 latestBlockSent() { return m_latestBlockSent; }
 	static char const* stateName(SyncState _s) { return s_stateNames[static_cast<int>(_s)]; }
 
+	/// Serve the snapshot in @a _storage to peers that ask for one.
+	void setSnapshotStorage(std::shared_ptr<SnapshotStorageFace const> _storage);
+	/// Fetch a snapshot through @a _downloader instead of syncing blocks; null resumes block sync.
+	void setSnapshotDownloader(std::shared_ptr<SnapshotDownloader> _downloader);
+	std::shared_ptr<SnapshotDownloader> snapshotDownloader() const { Guard l(x_snapshot); return m_snapshotDownloader; }
+
+	static unsigned const c_previousProtocolVersion;
 	static unsigned const c_oldProtocolVersion;
 	void foreachPeer(std::function<bool(std::shared_ptr<EthereumPeer>)> const& _f) const;
 
@@ -139,6 +148,9 @@ private:
 
 	std::shared_ptr<EthereumHostDataFace> m_hostData;
 	std::shared_ptr<EthereumPeerObserverFace> m_peerObserver;
+
+	mutable Mutex x_snapshot;
+	std::shared_ptr<SnapshotDownloader> m_snapshotDownloader;	///< Set while a snapshot is downloaded in place of blocks
 };
 
 }
@@ -44,6 +44,8 @@ static string toString(Asking _a)
 	case Asking::BlockBodies: return "BlockBodies";
 	case Asking::NodeData: return "NodeData";
 	case Asking::Receipts: return "Receipts";
+	case Asking::SnapshotManifest: return "SnapshotManifest";
+	case Asking::SnapshotData: return "SnapshotData";
 	case Asking::Nothing: return "Nothing";
 	case Asking::State: return "State";
 	}
@@ -129,9 +131,8 @@ void EthereumPeer::requestStatus(u256 _hostNetworkId, u256 _chainTotalDifficulty
 	setAsking(Asking::State);
 	m_requireTransactions = true;
 	RLPStream s;
-	bool latest = m_peerCapabilityVersion == m_hostProtocolVersion;
 	prep(s, StatusPacket, 5)
-					<< (latest ? m_hostProtocolVersion : EthereumHost::c_oldProtocolVersion)
+					<< m_peerCapabilityVersion
 					<< _hostNetworkId
 					<< _chainTotalDifficulty
 					<< _chainCurrentHash
@@ -183,6 +184,42 @@ void EthereumPeer::requestReceipts(h256s const& _blocks)
 	requestByHashes(_blocks, Asking::Receipts, GetReceiptsPacket);
 }
 
+void EthereumPeer::requestSnapshotManifest()
+{
+	if (m_asking != Asking::Nothing)
+	{
+		clog(NetWarn) << "Asking snapshot manifest while requesting " << ::toString(m_asking);
+	}
+	setAsking(Asking::SnapshotManifest);
+	RLPStream s;
+	prep(s, GetSnapshotManifestPacket, 0);
+	sealAndSend(s);
+}
+
+void EthereumPeer::requestSnapshotData(h256 const& _chunkHash)
+{
+	if (m_asking != Asking::Nothing)
+	{
+		clog(NetWarn) << "Asking snapshot data while requesting " << ::toString(m_asking);
+	}
+	setAsking(Asking::SnapshotData);
+	RLPStream s;
+	prep(s, GetSnapshotDataPacket, 1) << _chunkHash;
+	clog(NetMessageDetail) << "Requesting snapshot chunk " << _chunkHash;
+	sealAndSend(s);
+}
+
+void EthereumPeer::requestTransactions(h256s const& _hashes)
+{
+	if (_hashes.empty())
+		return;
+	RLPStream s;
+	prep(s, GetPooledTransactionsPacket, _hashes.size());
+	for (auto const& h: _hashes)
+		s << h;
+	sealAndSend(s);
+}
+
 void EthereumPeer::requestByHashes(h256s const& _hashes, Asking _asking, SubprotocolPacketType _packetType)
 {
 	if (m_asking != Asking::Nothing)
@@ -250,8 +287,8 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 		m_totalDifficulty = _r[2].toInt<u256>();
 		m_latestHash = _r[3].toHash<h256>();
 		m_genesisHash = _r[4].toHash<h256>();
-		if (m_peerCapabilityVersion == m_hostProtocolVersion)
-			m_protocolVersion = m_hostProtocolVersion;
+		if (m_peerCapabilityVersion == m_hostProtocolVersion || m_peerCapabilityVersion == EthereumHost::c_previousProtocolVersion)
+			m_protocolVersion = (unsigned)m_peerCapabilityVersion;
 
 		clog(NetMessageSummary) << "Status:" << m_protocolVersion << "/" << m_networkId << "/" << m_genesisHash << ", TD:" << m_totalDifficulty << "=" << m_latestHash;
 		setIdle();
@@ -263,6 +300,39 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 		m_observer->onPeerTransactions(dynamic_pointer_cast<EthereumPeer>(dynamic_pointer_cast<EthereumPeer>(shared_from_this())), _r);
 		break;
 	}
+	case NewTransactionHashesPacket:
+	{
+		unsigned itemCount = _r.itemCount();
+		clog(NetMessageSummary) << "TransactionHashes (" << dec << itemCount << "entries)";
+
+		if (itemCount > c_maxIncomingTransactionHashes)
+		{
+			disable("Too many transaction hashes");
+			break;
+		}
+
+		m_observer->onPeerTransactionHashes(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r.toVector<h256>());
+		break;
+	}
+	case GetPooledTransactionsPacket:
+	{
+		unsigned count = static_cast<unsigned>(_r.itemCount());
+		if (!count)
+		{
+			clog(NetImpolite) << "Zero-entry GetPooledTransactions: Not replying.";
+			addRating(-10);
+			break;
+		}
+		clog(NetMessageSummary) << "GetPooledTransactions (" << dec << count << " entries)";
+
+		pair<bytes, unsigned> const rlpAndItemCount = m_hostData->pooledTransactions(_r);
+
+		addRating(0);
+		RLPStream s;
+		prep(s, TransactionsPacket, rlpAndItemCount.second).appendRaw(rlpAndItemCount.first, rlpAndItemCount.second);
+		sealAndSend(s);
+		break;
+	}
 	case GetBlockHeadersPacket:
 	{
 		/// Packet layout:
@@ -416,6 +486,61 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 		}
 		break;
 	}
+	case GetSnapshotManifestPacket:
+	{
+		clog(NetMessageSummary) << "GetSnapshotManifest";
+		bytes const manifest = m_hostData->snapshotManifest();
+
+		addRating(0);
+		RLPStream s;
+		prep(s, SnapshotManifestPacket, manifest.empty() ? 0 : 1);
+		if (!manifest.empty())
+			s.appendRaw(manifest);
+		sealAndSend(s);
+		break;
+	}
+	case GetSnapshotDataPacket:
+	{
+		if (_r.itemCount() != 1)
+		{
+			clog(NetImpolite) << "Malformed GetSnapshotData: Not replying.";
+			addRating(-10);
+			break;
+		}
+		h256 const chunkHash = _r[0].toHash<h256>();
+		clog(NetMessageSummary) << "GetSnapshotData (" << chunkHash << ")";
+		std::string const data = m_hostData->snapshotData(chunkHash);
+
+		addRating(0);
+		RLPStream s;
+		prep(s, SnapshotDataPacket, data.empty() ? 0 : 1);
+		if (!data.empty())
+			s.append(data);
+		sealAndSend(s);
+		break;
+	}
+	case SnapshotManifestPacket:
+	{
+		if (m_asking != Asking::SnapshotManifest)
+			clog(NetImpolite) << "Peer giving us a snapshot manifest when we didn't ask for it.";
+		else
+		{
+			setIdle();
+			m_observer->onPeerSnapshotManifest(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
+		}
+		break;
+	}
+	case SnapshotDataPacket:
+	{
+		if (m_asking != Asking::SnapshotData)
+			clog(NetImpolite) << "Peer giving us snapshot data when we didn't ask for it.";
+		else
+		{
+			setIdle();
+			m_observer->onPeerSnapshotData(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
+		}
+		break;
+	}
 	default:
 		return false;
 	}
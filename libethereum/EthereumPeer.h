@@ -28,6 +28,7 @@
 
 #include <libdevcore/RLP.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/RollingBloom.h>
 #include <libethcore/Common.h>
 #include <libp2p/Capability.h>
 #include "CommonNet.h"
@@ -46,6 +47,8 @@ public:
 
 	virtual void onPeerTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
 
+	virtual void onPeerTransactionHashes(std::shared_ptr<EthereumPeer> _peer, h256s const& _hashes) = 0;
+
 	virtual void onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _headers) = 0;
 
 	virtual void onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
@@ -58,6 +61,10 @@ public:
 
 	virtual void onPeerReceipts(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
 
+	virtual void onPeerSnapshotManifest(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
+
+	virtual void onPeerSnapshotData(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
+
 	virtual void onPeerAborting() = 0;
 };
 
@@ -73,6 +80,14 @@ public:
 	virtual strings nodeData(RLP const& _dataHashes) const = 0;
 
 	virtual std::pair<bytes, unsigned> receipts(RLP const& _blockHashes) const = 0;
+
+	virtual std::pair<bytes, unsigned> pooledTransactions(RLP const& _txHashes) const = 0;
+
+	/// @returns the RLP manifest of the snapshot we serve, or empty if none.
+	virtual bytes snapshotManifest() const = 0;
+
+	/// @returns the compressed snapshot chunk with hash @a _chunkHash, or empty if we don't have it.
+	virtual std::string snapshotData(h256 const& _chunkHash) const = 0;
 };
 
 /**
@@ -121,6 +136,21 @@ public:
 	/// Request receipts for specified blocks from peer.
 	void requestReceipts(h256s const& _blocks);
 
+	/// Request queued transactions the peer announced. Does not affect the asking state.
+	void requestTransactions(h256s const& _hashes);
+
+	/// Request the manifest of the snapshot the peer serves.
+	void requestSnapshotManifest();
+
+	/// Request one compressed snapshot chunk.
+	void requestSnapshotData(h256 const& _chunkHash);
+
+	/// Does the peer understand snapshot requests?
+	bool servesSnapshots() const { return m_protocolVersion >= c_snapshotSyncVersion; }
+
+	/// Does the peer accept transaction hash announcements?
+	bool announcesTransactions() const { return m_protocolVersion >= c_transactionAnnouncementVersion; }
+
 	/// Check if this node is rude.
 	bool isRude() const;
 
@@ -142,9 +172,6 @@ private:
 	/// Request status. Called from constructor
 	void requestStatus(u256 _hostNetworkId, u256 _chainTotalDifficulty, h256 _chainCurrentHash, h256 _chainGenesisHash);
 
-	/// Clear all known transactions.
-	void clearKnownTransactions() { std::lock_guard<std::mutex> l(x_knownTransactions); m_knownTransactions.clear(); }
-
 	// Request of type _packetType with _hashes as input parameters
 	void requestByHashes(h256s const& _hashes, Asking _asking, SubprotocolPacketType _packetType);
 
@@ -166,7 +193,7 @@ private:
 	unsigned m_hostProtocolVersion = 0;
 
 	/// Peer's protocol version.
-	unsigned m_protocolVersion;
+	unsigned m_protocolVersion = 0;
 
 	/// Peer's network id.
 	u256 m_networkId;
@@ -188,7 +215,7 @@ private:
 	Mutex x_knownBlocks;
 	h256Hash m_knownBlocks;					///< Blocks that the peer already knows about (that don't need to be sent to them).
 	Mutex x_knownTransactions;
-	h256Hash m_knownTransactions;			///< Transactions that the peer already knows of.
+	RollingBloom m_knownTransactions;		///< Transactions that the peer recently sent us or we sent it.
 	unsigned m_unknownNewBlocks = 0;		///< Number of unknown NewBlocks received from this peer
 	unsigned m_lastAskedHeaders = 0;		///< Number of hashes asked
 
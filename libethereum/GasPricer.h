@@ -52,6 +52,8 @@ public:
 	virtual u256 bid(TransactionPriority _p = TransactionPriority::Medium) const = 0;
 
 	virtual void update(BlockChain const&) {}
+	/// Called with each change of the canonical chain, once @a _route's blocks are in @a _bc.
+	virtual void noteRoute(BlockChain const&, ImportRoute const&) {}
 };
 
 class TrivialGasPricer: public GasPricer
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <memory>
 #include <libdevcore/Common.h>
 #include <libdevcore/CommonIO.h>
 #include <libdevcore/Guards.h>
@@ -37,6 +38,7 @@ namespace eth
 {
 
 struct SyncStatus;
+struct ChainSnapshot;
 
 using TransactionHashes = h256s;
 using UncleHashes = h256s;
@@ -98,6 +100,10 @@ public:
 	/// Injects the RLP-encoded transaction given by the _rlp into the transaction queue directly.
 	virtual ImportResult injectTransaction(bytes const& _rlp, IfDropped _id = IfDropped::Ignore) = 0;
 
+	/// Injects the RLP-encoded transactions given by _rlps into the transaction queue, verifying them in parallel.
+	/// @returns the import result and hash of each transaction, in order.
+	virtual std::vector<std::pair<ImportResult, h256>> injectTransactions(std::vector<bytes> _rlps, IfDropped _id = IfDropped::Ignore) = 0;
+
 	/// Injects the RLP-encoded block given by the _rlp into the block queue directly.
 	virtual ImportResult injectBlock(bytes const& _block) = 0;
 
@@ -196,6 +202,10 @@ public:
 	virtual Addresses addresses() const { return addresses(m_default); }
 	virtual Addresses addresses(BlockNumber _block) const = 0;
 
+	/// Capture the current chain head and pending block so that a group of queries can be answered
+	/// against one consistent view. @see ScopedChainSnapshot.
+	virtual std::shared_ptr<ChainSnapshot const> snapshot() const = 0;
+
 	/// Get the remaining gas limit in this block.
 	virtual u256 gasLimitRemaining() const = 0;
 	// Get the gas bidding price
@@ -0,0 +1,216 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file PercentileGasPricer.cpp
+ * @date 2026
+ */
+
+#include "PercentileGasPricer.h"
+#include <set>
+#include "BlockChain.h"
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const unsigned PercentileGasPricer::c_defaultBlocks;
+const unsigned PercentileGasPricer::c_subBucketBits;
+const unsigned PercentileGasPricer::c_subBuckets;
+const unsigned PercentileGasPricer::c_buckets;
+
+PercentileGasPricer::PercentileGasPricer(unsigned _blocks, u256 const& _ask, u256 const& _bid):
+	TrivialGasPricer(_ask, _bid),
+	m_blocks(max(_blocks, 1u)),
+	m_gasByBucket(c_buckets, 0)
+{
+}
+
+u256 PercentileGasPricer::bid(TransactionPriority _p) const
+{
+	ReadGuard l(x_octiles);
+	return m_haveOctiles ? m_octiles[(int)_p] : TrivialGasPricer::bid(_p);
+}
+
+void PercentileGasPricer::update(BlockChain const& _bc)
+{
+	h256s hashes;
+	for (h256 h = _bc.currentHash(); h && hashes.size() < m_blocks; h = _bc.info(h).parentHash())
+		hashes.push_back(h);
+
+	Guard l(x_window);
+	for (auto const& s: m_window)
+		add_WITH_LOCK(s, true);
+	m_window.clear();
+	for (auto h = hashes.rbegin(); h != hashes.rend(); ++h)
+		noteBlock_WITH_LOCK(*h, samplesOf(_bc, *h));
+	updateOctiles_WITH_LOCK();
+}
+
+void PercentileGasPricer::noteRoute(BlockChain const& _bc, ImportRoute const& _route)
+{
+	// A route accumulated over several imports may list a block as imported and, after a later
+	// reorganisation, as dead too; only those still canonical belong in the window.
+	set<h256> const dead(_route.deadBlocks.begin(), _route.deadBlocks.end());
+	h256s live;
+	for (auto const& h: _route.liveBlocks)
+		if (!dead.count(h) || _bc.numberHash(_bc.number(h)) == h)
+			live.push_back(h);
+
+	Guard l(x_window);
+	for (auto const& h: _route.deadBlocks)
+		forgetBlock_WITH_LOCK(h);
+	// Only the newest m_blocks of a long route would survive in the window.
+	size_t const skip = live.size() > m_blocks ? live.size() - m_blocks : 0;
+	for (size_t i = skip; i < live.size(); ++i)
+		noteBlock_WITH_LOCK(live[i], samplesOf(_bc, live[i]));
+	// A reorganisation can take away more blocks than it brings; top the window up with older ones.
+	if (!dead.empty())
+		refill_WITH_LOCK(_bc);
+	updateOctiles_WITH_LOCK();
+}
+
+void PercentileGasPricer::noteBlock(h256 const& _hash, GasSamples const& _samples)
+{
+	Guard l(x_window);
+	noteBlock_WITH_LOCK(_hash, _samples);
+	updateOctiles_WITH_LOCK();
+}
+
+void PercentileGasPricer::forgetBlock(h256 const& _hash)
+{
+	Guard l(x_window);
+	forgetBlock_WITH_LOCK(_hash);
+	updateOctiles_WITH_LOCK();
+}
+
+unsigned PercentileGasPricer::bucketOf(u256 const& _price)
+{
+	if (_price < c_subBuckets)
+		return (unsigned)_price;
+	unsigned const msb = boost::multiprecision::msb(_price);
+	unsigned const sub = (unsigned)(_price >> (msb - c_subBucketBits)) & (c_subBuckets - 1);
+	return (msb - c_subBucketBits + 1) * c_subBuckets + sub;
+}
+
+u256 PercentileGasPricer::bucketCeiling(unsigned _bucket)
+{
+	if (_bucket < c_subBuckets)
+		return _bucket;
+	unsigned const msb = _bucket / c_subBuckets + c_subBucketBits - 1;
+	unsigned const sub = _bucket % c_subBuckets;
+	// Wraps to the maximum for the topmost bucket.
+	return (u256(c_subBuckets + sub + 1) << (msb - c_subBucketBits)) - 1;
+}
+
+PercentileGasPricer::GasSamples PercentileGasPricer::samplesOf(BlockChain const& _bc, h256 const& _hash)
+{
+	GasSamples ret;
+	bytes const block = _bc.block(_hash);
+	if (block.empty())
+		return ret;
+	RLP const txs = RLP(block)[1];
+	BlockReceipts const receipts = _bc.receipts(_hash);
+	if (receipts.receipts.size() != txs.itemCount())
+		return ret;
+
+	u256 cumulative = 0;
+	size_t i = 0;
+	for (auto const& tr: txs)
+	{
+		u256 const gasUsed = receipts.receipts[i++].cumulativeGasUsed();
+		ret.emplace_back(Transaction(tr.data(), CheckTransaction::None).gasPrice(), gasUsed - cumulative);
+		cumulative = gasUsed;
+	}
+	return ret;
+}
+
+PercentileGasPricer::BlockSample PercentileGasPricer::sampleOf(h256 const& _hash, GasSamples const& _samples)
+{
+	map<unsigned, uint64_t> gas;
+	for (auto const& s: _samples)
+		gas[bucketOf(s.first)] += (uint64_t)s.second;
+	return BlockSample{_hash, {gas.begin(), gas.end()}};
+}
+
+void PercentileGasPricer::noteBlock_WITH_LOCK(h256 const& _hash, GasSamples const& _samples)
+{
+	m_window.push_back(sampleOf(_hash, _samples));
+	add_WITH_LOCK(m_window.back(), false);
+	while (m_window.size() > m_blocks)
+	{
+		add_WITH_LOCK(m_window.front(), true);
+		m_window.pop_front();
+	}
+}
+
+void PercentileGasPricer::refill_WITH_LOCK(BlockChain const& _bc)
+{
+	// The window holds a run of canonical blocks, so carry on from the parent of the oldest.
+	h256 h = m_window.empty() ? _bc.currentHash() : _bc.info(m_window.front().hash).parentHash();
+	for (; h && m_window.size() < m_blocks; h = _bc.info(h).parentHash())
+	{
+		m_window.push_front(sampleOf(h, samplesOf(_bc, h)));
+		add_WITH_LOCK(m_window.front(), false);
+	}
+}
+
+void PercentileGasPricer::forgetBlock_WITH_LOCK(h256 const& _hash)
+{
+	// Dead blocks are the newest, so look from the back.
+	for (auto it = m_window.rbegin(); it != m_window.rend(); ++it)
+		if (it->hash == _hash)
+		{
+			add_WITH_LOCK(*it, true);
+			m_window.erase(next(it).base());
+			return;
+		}
+}
+
+void PercentileGasPricer::add_WITH_LOCK(BlockSample const& _sample, bool _remove)
+{
+	for (auto const& b: _sample.gasByBucket)
+		if (_remove)
+		{
+			m_gasByBucket[b.first] -= b.second;
+			m_totalGas -= b.second;
+		}
+		else
+		{
+			m_gasByBucket[b.first] += b.second;
+			m_totalGas += b.second;
+		}
+}
+
+void PercentileGasPricer::updateOctiles_WITH_LOCK()
+{
+	array<u256, 9> octiles;
+	if (m_totalGas)
+	{
+		// The lowest octile is the cheapest bucket with any gas in it, the highest the dearest.
+		uint64_t cumulative = 0;
+		size_t octile = 0;
+		for (unsigned b = 0; b < c_buckets && octile < octiles.size(); ++b)
+		{
+			cumulative += m_gasByBucket[b];
+			for (; octile < octiles.size() && cumulative >= max<uint64_t>(1, (m_totalGas * octile + 7) / 8); ++octile)
+				octiles[octile] = bucketCeiling(b);
+		}
+	}
+
+	WriteGuard l(x_octiles);
+	m_haveOctiles = m_totalGas != 0;
+	if (m_haveOctiles)
+		m_octiles = octiles;
+}
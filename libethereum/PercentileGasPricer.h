@@ -0,0 +1,101 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file PercentileGasPricer.h
+ * @date 2026
+ */
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <vector>
+#include <libdevcore/Guards.h>
+#include "GasPricer.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief Bids the gas prices paid over the last few canonical blocks.
+ * Each block is reduced to a log-bucketed histogram of gas used by gas price, and the window's
+ * histograms are summed. The octiles are recomputed whenever the window moves, so bid() is a
+ * lookup. Buckets are a thirty-second of a power of two wide and bids are taken from the top of
+ * a bucket, so they may exceed the price actually paid by up to about 3%.
+ * Until a priced transaction has been seen, the fixed ask and bid of TrivialGasPricer apply.
+ */
+class PercentileGasPricer: public TrivialGasPricer
+{
+public:
+	/// (gas price, gas used) of each transaction in a block.
+	using GasSamples = std::vector<std::pair<u256, u256>>;
+
+	static const unsigned c_defaultBlocks = 100;
+
+	explicit PercentileGasPricer(unsigned _blocks = c_defaultBlocks, u256 const& _ask = DefaultGasPrice, u256 const& _bid = DefaultGasPrice);
+
+	u256 bid(TransactionPriority _p = TransactionPriority::Medium) const override;
+
+	void update(BlockChain const& _bc) override;
+	void noteRoute(BlockChain const& _bc, ImportRoute const& _route) override;
+
+	/// Adds the block @a _hash as the newest of the window, dropping the oldest if it is full.
+	void noteBlock(h256 const& _hash, GasSamples const& _samples);
+	/// Removes the block @a _hash, no longer canonical, from the window.
+	void forgetBlock(h256 const& _hash);
+
+	/// @returns the number of blocks in the window.
+	unsigned blocks() const { Guard l(x_window); return m_window.size(); }
+
+private:
+	static const unsigned c_subBucketBits = 5;
+	static const unsigned c_subBuckets = 1 << c_subBucketBits;
+	static const unsigned c_buckets = (256 - c_subBucketBits + 1) * c_subBuckets;
+
+	struct BlockSample
+	{
+		h256 hash;
+		std::vector<std::pair<unsigned, uint64_t>> gasByBucket;
+	};
+
+	static unsigned bucketOf(u256 const& _price);
+	static u256 bucketCeiling(unsigned _bucket);
+	static GasSamples samplesOf(BlockChain const& _bc, h256 const& _hash);
+	static BlockSample sampleOf(h256 const& _hash, GasSamples const& _samples);
+
+	void noteBlock_WITH_LOCK(h256 const& _hash, GasSamples const& _samples);
+	void forgetBlock_WITH_LOCK(h256 const& _hash);
+	/// Adds canonical blocks older than the window's oldest until it is full again.
+	void refill_WITH_LOCK(BlockChain const& _bc);
+	void add_WITH_LOCK(BlockSample const& _sample, bool _remove);
+	void updateOctiles_WITH_LOCK();
+
+	unsigned const m_blocks;
+
+	mutable Mutex x_window;							///< Guards the window and the histogram.
+	std::deque<BlockSample> m_window;				///< Oldest first.
+	std::vector<uint64_t> m_gasByBucket;			///< Sum of the window's histograms.
+	uint64_t m_totalGas = 0;
+
+	mutable SharedMutex x_octiles;
+	std::array<u256, 9> m_octiles;
+	bool m_haveOctiles = false;
+};
+
+}
+}
@@ -0,0 +1,155 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SenderStateCache.h
+ * @date 2026
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/Guards.h>
+
+namespace dev
+{
+namespace eth
+{
+
+/// What the chain head says about a transaction sender, as far as queue admission is concerned.
+struct SenderState
+{
+	u256 nonce;
+	u256 balance;
+};
+
+/**
+ * @brief Thread-safe, bounded map from sender address to its nonce and balance at the chain head.
+ * Misses are filled through a reader supplied by the owner, so callers never touch State themselves.
+ * The owner keeps it current from block import: noteImported() with the accounts the new blocks
+ * touched, clear() on anything else (reorganisations, resets). A generation count keeps a reader
+ * that raced with either of those from caching what it read.
+ */
+class SenderStateCache
+{
+public:
+	using Reader = std::function<SenderState(Address const&)>;
+
+	/// Sets the reader used on misses. Waits for calls to the previous one to finish, so an owner
+	/// can unset it before going away.
+	void setReader(Reader const& _reader) { WriteGuard l(x_reader); m_reader = _reader; }
+
+	/// Looks up @a _a, asking the reader on a miss.
+	/// @returns false if there is no reader or it failed, in which case @a o_state is untouched.
+	bool state(Address const& _a, SenderState& o_state) const
+	{
+		Shard& s = shard(_a);
+		DEV_READ_GUARDED(s.x_states)
+		{
+			auto it = s.states.find(_a);
+			if (it != s.states.end())
+			{
+				++m_hits;
+				o_state = it->second;
+				return true;
+			}
+		}
+		++m_misses;
+
+		unsigned const generation = m_generation;
+		{
+			ReadGuard l(x_reader);
+			if (!m_reader)
+				return false;
+			try
+			{
+				o_state = m_reader(_a);
+			}
+			catch (...)
+			{
+				return false;
+			}
+		}
+
+		WriteGuard l(s.x_states);
+		if (generation == m_generation)
+		{
+			if (s.states.size() >= c_maxSize / c_shards)
+				s.states.erase(s.states.begin());
+			s.states[_a] = o_state;
+		}
+		return true;
+	}
+
+	/// Forgets the accounts changed by newly imported blocks.
+	void noteImported(AddressHash const& _touched)
+	{
+		++m_generation;
+		for (auto const& a: _touched)
+		{
+			Shard& s = shard(a);
+			DEV_WRITE_GUARDED(s.x_states)
+				s.states.erase(a);
+		}
+	}
+
+	void clear()
+	{
+		++m_generation;
+		for (auto& s: m_shards)
+			DEV_WRITE_GUARDED(s.x_states)
+				s.states.clear();
+	}
+
+	size_t size() const
+	{
+		size_t ret = 0;
+		for (auto const& s: m_shards)
+			DEV_READ_GUARDED(s.x_states)
+				ret += s.states.size();
+		return ret;
+	}
+
+	unsigned hits() const { return m_hits; }
+	unsigned misses() const { return m_misses; }
+
+	static const size_t c_maxSize = 65536;
+
+private:
+	static const size_t c_shards = 16;
+
+	struct Shard
+	{
+		mutable SharedMutex x_states;
+		std::unordered_map<Address, SenderState> states;
+	};
+
+	Shard& shard(Address const& _a) const { return m_shards[_a[0] % c_shards]; }
+
+	mutable std::array<Shard, c_shards> m_shards;
+	mutable SharedMutex x_reader;
+	Reader m_reader;
+	std::atomic<unsigned> m_generation = {0};
+	mutable std::atomic<unsigned> m_hits = {0};
+	mutable std::atomic<unsigned> m_misses = {0};
+};
+
+}
+}
@@ -0,0 +1,298 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Downloads a snapshot from peers and presents it to SnapshotImporter as it arrives
+ */
+
+#include "SnapshotDownloader.h"
+#include "EthereumPeer.h"
+#include "SnapshotImporter.h"
+
+#include <libdevcore/CommonIO.h>
+#include <libdevcore/SHA3.h>
+#include <libp2p/Common.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace p2p;
+
+namespace fs = boost::filesystem;
+using namespace std::chrono;
+
+namespace
+{
+
+/// @returns all chunks of @a _manifest in the order SnapshotImporter reads them; throws if it is malformed.
+h256s manifestChunks(RLP const& _manifest)
+{
+	// For Snapshot format see https://github.com/paritytech/parity/wiki/Warp-Sync-Snapshot-Format
+	if (!_manifest.isList() || _manifest.itemCount() != 6)
+		BOOST_THROW_EXCEPTION(InvalidSnapshotManifest());
+	if (_manifest[0].toInt<u256>(RLP::VeryStrict) != 2)
+		BOOST_THROW_EXCEPTION(UnsupportedSnapshotManifestVersion());
+
+	h256s chunks = _manifest[1].toVector<h256>(RLP::VeryStrict);
+	h256s const blockChunks = _manifest[2].toVector<h256>(RLP::VeryStrict);
+	// Block chunks are imported oldest first, which is the reverse of the manifest order.
+	chunks.insert(chunks.end(), blockChunks.rbegin(), blockChunks.rend());
+	return chunks;
+}
+
+h256 manifestBlockHash(RLP const& _manifest)
+{
+	return _manifest[5].toHash<h256>(RLP::VeryStrict);
+}
+
+}
+
+SnapshotDownloader::SnapshotDownloader(string const& _snapshotDirPath, h256 const& _trustedBlockHash, unsigned _agreeingPeers):
+	m_snapshotDir(_snapshotDirPath),
+	m_trustedBlockHash(_trustedBlockHash),
+	m_agreeingPeers(max(1u, _agreeingPeers)),
+	m_lastProgress(steady_clock::now())
+{
+	fs::create_directories(m_snapshotDir);
+	m_storage = createSnapshotStorage(_snapshotDirPath);
+
+	// Resume an earlier download into the same directory, unless it is for a block we were told not to trust.
+	bytes const manifest = contents((m_snapshotDir / "MANIFEST").string());
+	if (!manifest.empty())
+	{
+		Guard l(x_download);
+		if (!m_trustedBlockHash || manifestBlockHash(RLP(manifest)) == m_trustedBlockHash)
+			setManifest(manifest);
+		else
+			clog(NetNote) << "Ignoring the snapshot manifest in " << _snapshotDirPath << ": it is not for block " << m_trustedBlockHash;
+	}
+}
+
+void SnapshotDownloader::setManifest(bytes const& _manifest)
+{
+	RLP const manifest(_manifest);
+	h256s chunks = manifestChunks(manifest);
+
+	h256Hash downloaded;
+	for (auto const& chunk: chunks)
+	{
+		bytes const data = contents((m_snapshotDir / toHex(chunk)).string());
+		if (!data.empty() && sha3(data) == chunk)
+			downloaded.insert(chunk);
+	}
+
+	if (contents((m_snapshotDir / "MANIFEST").string()) != _manifest)
+		writeFile(m_snapshotDir / "MANIFEST", _manifest);
+
+	m_manifest = _manifest;
+	m_chunks = move(chunks);
+	m_downloaded = move(downloaded);
+	m_lastProgress = steady_clock::now();
+	clog(NetNote) << "Snapshot for block " << manifest[4].toInt<u256>() << ": " << m_chunks.size() << " chunks, " << m_downloaded.size() << " already downloaded";
+	m_signal.notify_all();
+}
+
+void SnapshotDownloader::requestNext(shared_ptr<EthereumPeer> const& _peer)
+{
+	if (!_peer->servesSnapshots())
+		return;
+
+	h256 chunk;
+	{
+		Guard l(x_download);
+		if (m_aborted || m_peersWithoutSnapshot.count(_peer) || m_requests.count(_peer) || m_offers.count(_peer))
+			return;
+
+		if (!m_manifest.empty())
+		{
+			h256Hash inFlight;
+			for (auto const& request: m_requests)
+				inFlight.insert(request.second);
+			for (auto const& h: m_chunks)
+				if (!m_downloaded.count(h) && !inFlight.count(h))
+				{
+					chunk = h;
+					break;
+				}
+			if (!chunk)
+				return;
+		}
+		m_requests[_peer] = chunk;
+	}
+
+	if (chunk)
+		_peer->requestSnapshotData(chunk);
+	else
+		_peer->requestSnapshotManifest();
+}
+
+void SnapshotDownloader::onPeerManifest(shared_ptr<EthereumPeer> const& _peer, RLP const& _r)
+{
+	bytes const manifest = _r.itemCount() ? _r[0].data().toBytes() : bytes();
+	bool accepted = false;
+	{
+		Guard l(x_download);
+		auto request = m_requests.find(_peer);
+		if (request == m_requests.end() || request->second)
+			return;
+		m_requests.erase(request);
+
+		if (m_manifest.empty() && !manifest.empty())
+			noteManifest_WITH_LOCK(_peer, manifest);
+		accepted = !manifest.empty() && manifest == m_manifest;
+		if (!accepted && !m_offers.count(_peer))
+			m_peersWithoutSnapshot.insert(_peer);
+	}
+
+	if (accepted)
+		requestNext(_peer);
+}
+
+void SnapshotDownloader::noteManifest_WITH_LOCK(shared_ptr<EthereumPeer> const& _peer, bytes const& _manifest)
+{
+	RLP const manifest(_manifest);
+	try
+	{
+		manifestChunks(manifest);
+		if (m_trustedBlockHash)
+		{
+			if (manifestBlockHash(manifest) == m_trustedBlockHash)
+				setManifest(_manifest);
+			else
+				clog(NetNote) << "Peer offers a snapshot of block " << manifestBlockHash(manifest) << ", not " << m_trustedBlockHash;
+			return;
+		}
+	}
+	catch (Exception const&)
+	{
+		clog(NetImpolite) << "Invalid snapshot manifest: " << boost::current_exception_diagnostic_information();
+		return;
+	}
+
+	h256 const offer = sha3(_manifest);
+	m_offers[_peer] = offer;
+	size_t agreeing = 0;
+	for (auto const& o: m_offers)
+		if (o.second == offer && !o.first.expired())
+			++agreeing;
+	clog(NetNote) << agreeing << " of " << m_agreeingPeers << " peers offer the snapshot of block " << manifestBlockHash(manifest);
+	if (agreeing < m_agreeingPeers)
+		return;
+
+	setManifest(_manifest);
+	// Peers that agreed are asked for chunks once idle; the others have a different snapshot.
+	for (auto const& o: m_offers)
+		if (o.second != offer)
+			m_peersWithoutSnapshot.insert(o.first);
+	m_offers.clear();
+}
+
+void SnapshotDownloader::onPeerData(shared_ptr<EthereumPeer> const& _peer, RLP const& _r)
+{
+	h256 chunk;
+	{
+		Guard l(x_download);
+		auto request = m_requests.find(_peer);
+		if (request == m_requests.end() || !request->second)
+			return;
+		chunk = request->second;
+		m_requests.erase(request);
+	}
+
+	bytesConstRef const data = _r.itemCount() ? _r[0].toBytesConstRef() : bytesConstRef();
+	bool const valid = !data.empty() && sha3(data) == chunk;
+	if (valid)
+		writeFile(m_snapshotDir / toHex(chunk), data);
+	else
+		clog(NetImpolite) << "Peer has no valid snapshot chunk " << chunk;
+
+	{
+		Guard l(x_download);
+		if (valid)
+		{
+			m_downloaded.insert(chunk);
+			m_lastProgress = steady_clock::now();
+			m_signal.notify_all();
+		}
+		else
+			m_peersWithoutSnapshot.insert(_peer);
+	}
+
+	if (valid)
+		requestNext(_peer);
+}
+
+void SnapshotDownloader::onPeerAborting()
+{
+	Guard l(x_download);
+	for (auto it = m_requests.begin(); it != m_requests.end();)
+		it = it->first.expired() ? m_requests.erase(it) : next(it);
+	for (auto it = m_offers.begin(); it != m_offers.end();)
+		it = it->first.expired() ? m_offers.erase(it) : next(it);
+	for (auto it = m_peersWithoutSnapshot.begin(); it != m_peersWithoutSnapshot.end();)
+		it = it->expired() ? m_peersWithoutSnapshot.erase(it) : next(it);
+}
+
+void SnapshotDownloader::abort()
+{
+	Guard l(x_download);
+	m_aborted = true;
+	m_signal.notify_all();
+}
+
+pair<size_t, size_t> SnapshotDownloader::progress() const
+{
+	Guard l(x_download);
+	return make_pair(m_downloaded.size(), m_chunks.size());
+}
+
+void SnapshotDownloader::setStallTimeout(milliseconds _stall)
+{
+	Guard l(x_download);
+	m_stallTimeout = _stall;
+	m_signal.notify_all();
+}
+
+void SnapshotDownloader::waitFor(function<bool()> const& _ready) const
+{
+	unique_lock<Mutex> l(x_download);
+	while (!m_aborted && !_ready())
+		if (m_signal.wait_until(l, m_lastProgress + m_stallTimeout) == cv_status::timeout && !m_aborted && !_ready() && steady_clock::now() >= m_lastProgress + m_stallTimeout)
+			BOOST_THROW_EXCEPTION(SnapshotDownloadStalled());
+	if (m_aborted)
+		BOOST_THROW_EXCEPTION(SnapshotDownloadAborted());
+}
+
+bytes SnapshotDownloader::readManifest() const
+{
+	waitFor([&]() { return !m_manifest.empty(); });
+	Guard l(x_download);
+	return m_manifest;
+}
+
+string SnapshotDownloader::readChunk(h256 const& _chunkHash) const
+{
+	waitFor([&]() { return m_downloaded.count(_chunkHash) != 0; });
+	return m_storage->readChunk(_chunkHash);
+}
+
+string SnapshotDownloader::readCompressedChunk(h256 const& _chunkHash) const
+{
+	waitFor([&]() { return m_downloaded.count(_chunkHash) != 0; });
+	return m_storage->readCompressedChunk(_chunkHash);
+}
@@ -0,0 +1,122 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Downloads a snapshot from peers and presents it to SnapshotImporter as it arrives
+ */
+
+#pragma once
+
+#include "SnapshotStorage.h"
+
+#include <libdevcore/Guards.h>
+#include <libdevcore/RLP.h>
+
+#include <boost/filesystem/path.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <set>
+
+namespace dev
+{
+
+namespace eth
+{
+
+class EthereumPeer;
+
+DEV_SIMPLE_EXCEPTION(SnapshotDownloadAborted);
+DEV_SIMPLE_EXCEPTION(SnapshotDownloadStalled);
+
+/**
+ * @brief Snapshot storage filled from the network.
+ *
+ * Idle peers are handed the manifest request until a manifest is trusted, then the next chunk
+ * nobody is fetching, so chunks arrive from many peers at once. A manifest is trusted if its block
+ * hash is the one we were given or, without one, once enough peers have offered the same manifest.
+ * Each chunk is checked against its hash and written to the snapshot directory, which makes an
+ * interrupted download resumable and leaves a directory that createSnapshotStorage() can read.
+ * A peer that leaves a request unanswered is disconnected by its own asking timeout, and the
+ * request goes back to the pool when it aborts.
+ * The read methods block until the requested item has arrived, so SnapshotImporter can run on its
+ * own thread while the download continues; they throw once nothing has arrived for a while.
+ */
+class SnapshotDownloader: public SnapshotStorageFace
+{
+public:
+	/// @param _trustedBlockHash if set, only a manifest for this block is accepted, from any one peer.
+	/// @param _agreeingPeers otherwise, how many peers must offer the same manifest before it is accepted.
+	explicit SnapshotDownloader(std::string const& _snapshotDirPath, h256 const& _trustedBlockHash = h256(), unsigned _agreeingPeers = c_defaultAgreeingPeers);
+
+	bytes readManifest() const override;
+	std::string readChunk(h256 const& _chunkHash) const override;
+	std::string readCompressedChunk(h256 const& _chunkHash) const override;
+
+	/// Give an idle peer its next request, if there is anything left it can help with.
+	void requestNext(std::shared_ptr<EthereumPeer> const& _peer);
+
+	/// Called by peer when it answers a manifest request.
+	void onPeerManifest(std::shared_ptr<EthereumPeer> const& _peer, RLP const& _r);
+
+	/// Called by peer when it answers a chunk request.
+	void onPeerData(std::shared_ptr<EthereumPeer> const& _peer, RLP const& _r);
+
+	/// Called when a peer disconnects; returns its outstanding chunk to the pool.
+	void onPeerAborting();
+
+	/// Wake up blocked readers, which then throw SnapshotDownloadAborted.
+	void abort();
+
+	/// @returns the number of chunks downloaded and the total in the manifest.
+	std::pair<size_t, size_t> progress() const;
+
+	/// Set how long readers wait for any progress before giving up.
+	void setStallTimeout(std::chrono::milliseconds _stall);
+
+	static unsigned const c_defaultAgreeingPeers = 3;
+
+private:
+	using PeerSet = std::set<std::weak_ptr<EthereumPeer>, std::owner_less<std::weak_ptr<EthereumPeer>>>;
+
+	/// Adopt @a _manifest and work out which of its chunks are still missing.
+	void setManifest(bytes const& _manifest);
+	/// Count @a _peer's offer of @a _manifest, adopting it once it is trusted.
+	void noteManifest_WITH_LOCK(std::shared_ptr<EthereumPeer> const& _peer, bytes const& _manifest);
+	void waitFor(std::function<bool()> const& _ready) const;
+
+	boost::filesystem::path const m_snapshotDir;
+	std::unique_ptr<SnapshotStorageFace> m_storage;		///< Reads the verified chunks back from disk
+
+	h256 const m_trustedBlockHash;
+	unsigned const m_agreeingPeers;
+
+	mutable Mutex x_download;
+	mutable std::condition_variable m_signal;
+	bytes m_manifest;
+	h256s m_chunks;										///< All chunks, in the order SnapshotImporter reads them
+	h256Hash m_downloaded;
+	std::map<std::weak_ptr<EthereumPeer>, h256, std::owner_less<std::weak_ptr<EthereumPeer>>> m_requests; ///< Outstanding requests; a null hash is the manifest
+	std::map<std::weak_ptr<EthereumPeer>, h256, std::owner_less<std::weak_ptr<EthereumPeer>>> m_offers; ///< Hash of the manifest each peer offered, until one is trusted
+	PeerSet m_peersWithoutSnapshot;						///< Peers that serve no snapshot or a different one
+	std::chrono::milliseconds m_stallTimeout = std::chrono::minutes(5);
+	std::chrono::steady_clock::time_point m_lastProgress;	///< When the manifest or the latest chunk arrived
+	bool m_aborted = false;
+};
+
+}
+}
@@ -0,0 +1,375 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Class for exporting a snapshot of the state and recent blocks to a directory on disk
+ */
+
+#include "SnapshotExporter.h"
+#include "BlockChain.h"
+
+#include <libdevcore/CommonIO.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/Log.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieDB.h>
+
+#include <boost/filesystem.hpp>
+#include <snappy.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+struct SnapshotExportLog: public LogChannel
+{
+	static char const* name() { return "SNAP"; }
+	static int const verbosity = 9;
+};
+
+unsigned const c_stateRanges = 16;	///< Key ranges the state is cut into, by leading nibble of the hashed address
+
+/// Read-only view of the state database as of construction; later commits stay invisible to it.
+class StateDBSnapshot
+{
+public:
+	explicit StateDBSnapshot(OverlayDB const& _db): m_overlay(_db), m_db(_db.db())
+	{
+		if (m_db)
+			m_readOptions.snapshot = m_db->GetSnapshot();
+	}
+
+	~StateDBSnapshot()
+	{
+		if (m_db)
+			m_db->ReleaseSnapshot(m_readOptions.snapshot);
+	}
+
+	std::string lookup(h256 const& _h) const
+	{
+		if (!m_db)
+			return m_overlay.lookup(_h);
+		std::string ret;
+		m_db->Get(m_readOptions, ldb::Slice((char const*)_h.data(), 32), &ret);
+		return ret;
+	}
+
+	bool exists(h256 const& _h) const { return !lookup(_h).empty(); }
+
+	// Only walked, never written; GenericTrieDB still needs these to instantiate.
+	void insert(h256 const&, bytesConstRef) { assert(false); }
+	bool kill(h256 const&) { assert(false); return false; }
+
+private:
+	OverlayDB const& m_overlay;
+	ldb::DB* m_db;
+	ldb::ReadOptions m_readOptions;
+};
+
+using SnapshotTrie = SpecificTrieDB<GenericTrieDB<StateDBSnapshot>, h256>;
+
+/// Writes chunks compressed under the hash of their compressed form.
+class ChunkWriter
+{
+public:
+	ChunkWriter(fs::path const& _dir, size_t _maxSize): m_dir(_dir), m_maxSize(_maxSize) {}
+
+	/// @returns how many more bytes of entries the current chunk takes.
+	size_t room() const { return m_maxSize - min(m_size, m_maxSize); }
+
+	/// Add an entry to the current chunk, starting a new chunk first if it doesn't fit.
+	void append(bytes&& _entry)
+	{
+		if (_entry.size() > room())
+			flush();
+		m_size += _entry.size();
+		m_entries.push_back(move(_entry));
+	}
+
+	/// Write out the current chunk as a list of its entries.
+	void flush()
+	{
+		if (m_entries.empty())
+			return;
+		RLPStream s(m_entries.size());
+		for (auto const& entry: m_entries)
+			s.appendRaw(entry);
+		write(s.out());
+		m_entries.clear();
+		m_size = 0;
+	}
+
+	void write(bytes const& _chunk)
+	{
+		std::string compressed;
+		snappy::Compress(reinterpret_cast<char const*>(_chunk.data()), _chunk.size(), &compressed);
+		h256 const hash = sha3(compressed);
+		writeFile(m_dir / toHex(hash), bytesConstRef(&compressed));
+		m_hashes.push_back(hash);
+	}
+
+	h256s const& hashes() const { return m_hashes; }
+
+private:
+	fs::path const m_dir;
+	size_t const m_maxSize;
+	std::vector<bytes> m_entries;
+	size_t m_size = 0;
+	h256s m_hashes;
+};
+
+/// Export one account, splitting its storage over as many chunks as it needs.
+/// Code is inlined the first time it is seen in @a _exportedCode and referenced by hash after that.
+void exportAccount(StateDBSnapshot& _db, h256 const& _addressHash, RLP const& _account, ChunkWriter& _chunks, h256Hash& _exportedCode)
+{
+	u256 const nonce = _account[0].toInt<u256>();
+	u256 const balance = _account[1].toInt<u256>();
+	h256 const storageRoot = _account[2].toHash<h256>();
+	h256 const codeHash = _account[3].toHash<h256>();
+
+	byte codeFlag = 0;
+	bytes code;
+	if (codeHash != EmptySHA3)
+	{
+		codeFlag = _exportedCode.count(codeHash) ? 2 : 1;
+		if (codeFlag == 1)
+		{
+			code = asBytes(_db.lookup(codeHash));
+			_exportedCode.insert(codeHash);
+		}
+	}
+
+	std::vector<bytes> storage;
+	size_t storageSize = 0;
+	auto piece = [&]()
+	{
+		RLPStream s(2);
+		s << _addressHash;
+		s.appendList(5) << nonce << balance << codeFlag;
+		if (codeFlag == 1)
+			s << code;
+		else if (codeFlag == 2)
+			s << codeHash;
+		else
+			s << bytes();
+		s.appendList(storage.size());
+		for (auto const& item: storage)
+			s.appendRaw(item);
+		return s.out();
+	};
+
+	if (storageRoot != EmptyTrie)
+	{
+		SnapshotTrie storageTrie(&_db, storageRoot);
+		for (auto it = storageTrie.begin(); it != storageTrie.end(); ++it)
+		{
+			auto const keyAndValue = *it;
+			RLPStream s(2);
+			s << keyAndValue.first << keyAndValue.second;
+			bytes item = s.out();
+
+			// Room for the account fields and code next to the storage collected so far.
+			size_t const fieldsSize = code.size() + 128;
+			if (fieldsSize + storageSize + item.size() > _chunks.room())
+			{
+				if (!storage.empty())
+				{
+					_chunks.append(piece());
+					storage.clear();
+					storageSize = 0;
+					// The rest of the account continues at the start of the next chunk; its code is imported by then.
+					if (codeFlag == 1)
+					{
+						codeFlag = 2;
+						code.clear();
+					}
+				}
+				_chunks.flush();
+			}
+			storageSize += item.size();
+			storage.push_back(move(item));
+		}
+	}
+	_chunks.append(piece());
+}
+
+h256s exportStateRange(StateDBSnapshot& _db, h256 const& _stateRoot, unsigned _range, fs::path const& _dir, size_t _maxChunkSize)
+{
+	ChunkWriter chunks(_dir, _maxChunkSize);
+	h256Hash exportedCode;
+	SnapshotTrie state(&_db, _stateRoot);
+	h256 start;
+	start[0] = static_cast<byte>(_range * 256 / c_stateRanges);
+	size_t accounts = 0;
+	for (auto it = state.lower_bound(start); it != state.end(); ++it)
+	{
+		auto const addressAndAccount = *it;
+		if (addressAndAccount.first[0] * c_stateRanges / 256 != _range)
+			break;
+		exportAccount(_db, addressAndAccount.first, RLP(addressAndAccount.second), chunks, exportedCode);
+		++accounts;
+	}
+	chunks.flush();
+	clog(SnapshotExportLog) << "State range " << _range << ": " << accounts << " accounts in " << chunks.hashes().size() << " chunks";
+	return chunks.hashes();
+}
+
+}
+
+unsigned const SnapshotExporter::c_defaultThreads;
+unsigned const SnapshotExporter::c_defaultBlockCount;
+size_t const SnapshotExporter::c_maxChunkSize;
+
+bytes SnapshotExporter::exportSnapshot(h256 const& _blockHash, string const& _snapshotDirPath, unsigned _threads, unsigned _blockCount) const
+{
+	if (!m_blockChain.isKnown(_blockHash))
+		BOOST_THROW_EXCEPTION(SnapshotBlockNotFound() << errinfo_hash256(_blockHash));
+
+	BlockHeader const header = m_blockChain.info(_blockHash);
+	h256 const stateRoot = header.stateRoot();
+	fs::path const dir(_snapshotDirPath);
+	fs::create_directories(dir);
+	clog(SnapshotExportLog) << "Exporting snapshot for block " << header.number() << " block hash " << _blockHash;
+
+	// Blocks don't depend on the state walk, so they are written meanwhile.
+	auto blockChunksFuture = std::async(std::launch::async, [&]() { return exportBlockChunks(_blockHash, _snapshotDirPath, _blockCount); });
+	h256s const stateChunks = exportState(stateRoot, _snapshotDirPath, _threads);
+	h256s const blockChunks = blockChunksFuture.get();
+
+	// For Snapshot format see https://github.com/paritytech/parity/wiki/Warp-Sync-Snapshot-Format
+	RLPStream manifest(6);
+	manifest << 2 << stateChunks << blockChunks << stateRoot << u256(header.number()) << _blockHash;
+	writeFile(dir / "MANIFEST", manifest.out());
+	clog(SnapshotExportLog) << "Exported " << stateChunks.size() << " state chunks and " << blockChunks.size() << " block chunks";
+	return manifest.out();
+}
+
+h256s SnapshotExporter::exportState(h256 const& _stateRoot, string const& _snapshotDirPath, unsigned _threads) const
+{
+	if (_stateRoot == EmptyTrie)
+		return h256s();
+
+	fs::path const dir(_snapshotDirPath);
+	fs::create_directories(dir);
+
+	// Taken before anything is read, so every worker sees the same state however far the chain moves meanwhile.
+	StateDBSnapshot db(m_stateDb);
+
+	std::vector<h256s> rangeChunks(c_stateRanges);
+	std::atomic<unsigned> nextRange{0};
+	Mutex x_error;
+	std::exception_ptr error;
+
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < max(1u, min(_threads, c_stateRanges)); ++i)
+		workers.emplace_back([&, i]()
+		{
+			setThreadName("snapshot" + toString(i));
+			try
+			{
+				for (unsigned range = nextRange++; range < c_stateRanges; range = nextRange++)
+					rangeChunks[range] = exportStateRange(db, _stateRoot, range, dir, m_maxChunkSize);
+			}
+			catch (...)
+			{
+				Guard l(x_error);
+				if (!error)
+					error = std::current_exception();
+				nextRange = c_stateRanges;
+			}
+		});
+	for (auto& worker: workers)
+		worker.join();
+	if (error)
+		std::rethrow_exception(error);
+
+	h256s ret;
+	for (auto const& chunks: rangeChunks)
+		ret += chunks;
+	return ret;
+}
+
+h256s SnapshotExporter::exportBlockChunks(h256 const& _blockHash, string const& _snapshotDirPath, unsigned _blockCount) const
+{
+	unsigned const head = m_blockChain.details(_blockHash).number;
+	// The importer takes the parent of the oldest block for the chain start, which must not be genesis.
+	unsigned const first = max(2u, head >= _blockCount ? head - _blockCount + 1 : 0u);
+	if (!_blockCount || head < first)
+		return h256s();
+
+	h256s hashes(head - first + 1);
+	h256 parent = _blockHash;
+	for (unsigned i = hashes.size(); i > 0; --i)
+	{
+		hashes[i - 1] = parent;
+		parent = m_blockChain.details(parent).parent;
+	}
+
+	ChunkWriter chunks(_snapshotDirPath, m_maxChunkSize);
+	std::vector<bytes> entries;
+	size_t size = 0;
+	unsigned chunkParentNumber = first - 1;
+	auto flush = [&]()
+	{
+		RLPStream s(3 + entries.size());
+		s << chunkParentNumber << parent << m_blockChain.details(parent).totalDifficulty;
+		for (auto const& entry: entries)
+			s.appendRaw(entry);
+		chunks.write(s.out());
+		entries.clear();
+		size = 0;
+	};
+
+	for (unsigned i = 0; i < hashes.size(); ++i)
+	{
+		bytes const block = m_blockChain.block(hashes[i]);
+		BlockHeader const header(block);
+		RLP const blockRlp(block);
+
+		RLPStream abridged(10);
+		abridged << header.author() << header.stateRoot() << header.logBloom() << header.difficulty()
+			<< header.gasLimit() << header.gasUsed() << u256(header.timestamp()) << header.extraData();
+		abridged.appendRaw(blockRlp[1].data()).appendRaw(blockRlp[2].data());
+
+		RLPStream entry(2);
+		entry.appendRaw(abridged.out()).appendRaw(m_blockChain.receipts(hashes[i]).rlp());
+		if (!entries.empty() && size + entry.out().size() > m_maxChunkSize)
+		{
+			flush();
+			parent = hashes[i - 1];
+			chunkParentNumber = first + i - 1;
+		}
+		size += entry.out().size();
+		entries.push_back(entry.out());
+	}
+	flush();
+
+	// The manifest lists block chunks newest first.
+	h256s ret = chunks.hashes();
+	reverse(ret.begin(), ret.end());
+	return ret;
+}
@@ -0,0 +1,76 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Class for exporting a snapshot of the state and recent blocks to a directory on disk
+ */
+
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/Exceptions.h>
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+
+class OverlayDB;
+
+namespace eth
+{
+
+class BlockChain;
+
+DEV_SIMPLE_EXCEPTION(SnapshotBlockNotFound);
+
+/**
+ * @brief Writes snapshots in the format SnapshotImporter reads.
+ *
+ * The state trie is read through a database snapshot taken when the export starts, so the node
+ * can keep importing blocks meanwhile. Its key space is cut into ranges by leading byte, which
+ * worker threads export independently; the chunk lists are joined in key order, keeping the
+ * account order the importer relies on.
+ */
+class SnapshotExporter
+{
+public:
+	SnapshotExporter(OverlayDB const& _stateDb, BlockChain const& _blockChain): m_stateDb(_stateDb), m_blockChain(_blockChain) {}
+
+	/// Export the state at block @a _blockHash and up to @a _blockCount blocks leading to it into @a _snapshotDirPath.
+	/// @returns the manifest, which is also written to the directory.
+	bytes exportSnapshot(h256 const& _blockHash, std::string const& _snapshotDirPath, unsigned _threads = c_defaultThreads, unsigned _blockCount = c_defaultBlockCount) const;
+
+	/// Export the state trie with root @a _stateRoot into @a _snapshotDirPath using @a _threads threads.
+	/// @returns the state chunk hashes in import order.
+	h256s exportState(h256 const& _stateRoot, std::string const& _snapshotDirPath, unsigned _threads = c_defaultThreads) const;
+
+	/// Limit the uncompressed size of chunks written from now on.
+	void setMaxChunkSize(size_t _size) { m_maxChunkSize = _size; }
+
+	static unsigned const c_defaultThreads = 4;
+	static unsigned const c_defaultBlockCount = 30000;
+	static size_t const c_maxChunkSize = 4 * 1024 * 1024;	///< Upper bound of an uncompressed chunk
+
+private:
+	h256s exportBlockChunks(h256 const& _blockHash, std::string const& _snapshotDirPath, unsigned _blockCount) const;
+
+	OverlayDB const& m_stateDb;
+	BlockChain const& m_blockChain;
+	size_t m_maxChunkSize = c_maxChunkSize;
+};
+
+}
+}
@@ -65,9 +65,7 @@ public:
 
 	std::string readChunk(h256 const& _chunkHash) const override
 	{
-		std::string const chunkCompressed = dev::contentsString((m_snapshotDir / toHex(_chunkHash)).string());
-		if (chunkCompressed.empty())
-			BOOST_THROW_EXCEPTION(FailedToReadChunkFile() << errinfo_hash256(_chunkHash));
+		std::string const chunkCompressed = readCompressedChunk(_chunkHash);
 
 		h256 const chunkHash = sha3(chunkCompressed);
 		if (chunkHash != _chunkHash)
@@ -79,6 +77,15 @@ public:
 		return chunkUncompressed;
 	}
 
+	std::string readCompressedChunk(h256 const& _chunkHash) const override
+	{
+		std::string chunkCompressed = dev::contentsString((m_snapshotDir / toHex(_chunkHash)).string());
+		if (chunkCompressed.empty())
+			BOOST_THROW_EXCEPTION(FailedToReadChunkFile() << errinfo_hash256(_chunkHash));
+
+		return chunkCompressed;
+	}
+
 private:
 	boost::filesystem::path const m_snapshotDir;
 };
@@ -44,6 +44,9 @@ public:
 	virtual bytes readManifest() const = 0;
 
 	virtual std::string readChunk(h256 const& _chunkHash) const = 0;
+
+	/// @returns the chunk as stored, without checking or uncompressing it; used to serve it to peers.
+	virtual std::string readCompressedChunk(h256 const& _chunkHash) const = 0;
 };
 
 
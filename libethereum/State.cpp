@@ -146,6 +146,13 @@ State& State::operator=(State const& _s)
 	return *this;
 }
 
+State State::committedView() const
+{
+	State ret(m_accountStartNonce, m_db);
+	ret.setRoot(rootHash());
+	return ret;
+}
+
 Account const* State::account(Address const& _a) const
 {
 	return const_cast<State*>(this)->account(_a);
@@ -359,7 +366,10 @@ void State::createAccount(Address const& _address, Account const&& _account)
 void State::kill(Address _addr)
 {
 	if (auto a = account(_addr))
+	{
+		m_changeLog.emplace_back(_addr, *a);
 		a->kill();
+	}
 	// If the account is not in the db, nothing to kill.
 }
 
@@ -543,6 +553,9 @@ void State::rollback(size_t _savepoint)
 			account.untouch();
 			m_unchangedCacheEntries.emplace_back(change.address);
 			break;
+		case Change::Kill:
+			account = *change.oldAccount;
+			break;
 		}
 		m_changeLog.pop_back();
 	}
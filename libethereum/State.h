@@ -120,7 +120,10 @@ struct Change
 		Code,
 
 		/// Account was touched for the first time.
-		Touch
+		Touch,
+
+		/// Account was self-destructed. Change::oldAccount holds the account as it was before.
+		Kill
 	};
 
 	Kind kind;        ///< The kind of the change.
@@ -128,12 +131,13 @@ struct Change
 	u256 value;       ///< Change value, e.g. balance, storage and nonce.
 	u256 key;         ///< Storage key. Last because used only in one case.
 	bytes oldCode;    ///< Code overwritten by CREATE, empty except in case of address collision.
+	std::shared_ptr<Account const> oldAccount;	///< Account wiped by a selfdestruct, empty except for Kill.
 
 	/// Helper constructor to make change log update more readable.
 	Change(Kind _kind, Address const& _addr, u256 const& _value = 0):
 			kind(_kind), address(_addr), value(_value)
 	{
-		assert(_kind != Code); // For this the special constructor needs to be used.
+		assert(_kind != Code && _kind != Kill); // For these the special constructors need to be used.
 	}
 
 	/// Helper constructor especially for storage change log.
@@ -150,6 +154,11 @@ struct Change
 	Change(Address const& _addr, bytes const& _oldCode):
 			kind(Code), address(_addr), oldCode(_oldCode)
 	{}
+
+	/// Helper constructor for selfdestruct change log.
+	Change(Address const& _addr, Account const& _oldAccount):
+			kind(Kill), address(_addr), oldAccount(std::make_shared<Account const>(_oldAccount))
+	{}
 };
 
 using ChangeLog = std::vector<Change>;
@@ -199,6 +208,11 @@ public:
 	/// Copy state object.
 	State& operator=(State const& _s);
 
+	/// @returns a state over the same database at rootHash(), without uncommitted changes or caches.
+	/// Reads fill a State's caches even through const methods, so threads sharing one State should
+	/// each read through their own view instead.
+	State committedView() const;
+
 	/// Open a DB - useful for passing into the constructor & keeping for other states that are necessary.
 	static OverlayDB openDB(boost::filesystem::path const& _path, h256 const& _genesisHash, WithExisting _we = WithExisting::Trust);
 	OverlayDB const& db() const { return m_db; }
@@ -325,6 +339,9 @@ public:
 	void rollback(size_t _savepoint);
 
 	ChangeLog const& changeLog() const { return m_changeLog; }
+
+	/// @returns every address whose account has been changed by a commit() so far.
+	AddressHash const& touched() const { return m_touched; }
 	
 	/// Set the balance of @p _addr to @p _value.
 	/// Will instantiate the address if it has never been used.
@@ -24,6 +24,10 @@
 #include <libdevcore/Log.h>
 #include <libethcore/Exceptions.h>
 #include "Transaction.h"
+
+#include <condition_variable>
+#include <queue>
+
 using namespace std;
 using namespace dev;
 using namespace dev::eth;
@@ -32,11 +36,12 @@ const char* TransactionQueueChannel::name() { return EthCyan "┉┅▶"; }
 const char* TransactionQueueTraceChannel::name() { return EthCyan " ┅▶"; }
 
 const size_t c_maxVerificationQueueSize = 8192;
+const size_t c_verifyBatch = 16;
 
 TransactionQueue::TransactionQueue(unsigned _limit, unsigned _futureLimit):
-	m_current(PriorityCompare { *this }),
 	m_limit(_limit),
-	m_futureLimit(_futureLimit)
+	m_futureLimit(_futureLimit),
+	m_unverified(c_maxVerificationQueueSize)
 {
 	unsigned verifierThreads = std::max(thread::hardware_concurrency(), 3U) - 2U;
 	for (unsigned i = 0; i < verifierThreads; ++i)
@@ -48,11 +53,17 @@ TransactionQueue::TransactionQueue(unsigned _limit, unsigned _futureLimit):
 
 TransactionQueue::~TransactionQueue()
 {
-	DEV_GUARDED(x_queue)
-		m_aborting = true;
-	m_queueReady.notify_all();
+	m_unverified.close();
+	// Wait out any importBatch() still pushing; later ones see the queue closed.
+	DEV_WRITE_GUARDED(x_unverifiedClosing) {}
 	for (auto& i: m_verifiers)
 		i.join();
+
+	// The verifiers have stopped; fail the batch entries they left behind so their callers return.
+	UnverifiedTransaction w;
+	while (m_unverified.try_pop(w))
+		if (w.done)
+			w.done(ImportResult::Aborted, h256());
 }
 
 ImportResult TransactionQueue::import(bytesConstRef _transactionRLP, IfDropped _ik)
@@ -68,6 +79,64 @@ ImportResult TransactionQueue::import(bytesConstRef _transactionRLP, IfDropped _
 	}
 }
 
+pair<ImportResult, h256> TransactionQueue::importWithHash(bytesConstRef _transactionRLP, IfDropped _ik)
+{
+	try
+	{
+		Transaction t = Transaction(_transactionRLP, CheckTransaction::Everything);
+		return make_pair(import(t, _ik), t.sha3());
+	}
+	catch (Exception const&)
+	{
+		return make_pair(ImportResult::Malformed, h256());
+	}
+}
+
+vector<pair<ImportResult, h256>> TransactionQueue::importBatch(vector<bytes> _txs, IfDropped _ik)
+{
+	// Shared with the queued entries' callbacks, which may run on a verifier or in the destructor.
+	struct Batch
+	{
+		Mutex x_pending;
+		condition_variable pendingDone;
+		size_t pending;
+		vector<pair<ImportResult, h256>> results;
+	};
+	auto batch = make_shared<Batch>();
+	batch->pending = _txs.size();
+	batch->results.resize(_txs.size());
+	auto done = [batch](size_t _i, ImportResult _ir, h256 const& _h)
+	{
+		Guard l(batch->x_pending);
+		batch->results[_i] = make_pair(_ir, _h);
+		if (!--batch->pending)
+			batch->pendingDone.notify_all();
+	};
+
+	DEV_READ_GUARDED(x_unverifiedClosing)
+		for (size_t i = 0; i < _txs.size(); ++i)
+		{
+			if (m_unverified.closed())
+			{
+				done(i, ImportResult::Aborted, h256());
+				continue;
+			}
+			UnverifiedTransaction w(SharedBytesRef(move(_txs[i])), NodeID());
+			w.ifDropped = _ik;
+			w.done = [done, i](ImportResult _ir, h256 const& _h) { done(i, _ir, _h); };
+			// Rather than wait for room, verify the overflow here while the verifiers work through the rest.
+			if (!m_unverified.push(move(w)))
+			{
+				auto r = importWithHash(w.transaction.ref(), _ik);
+				done(i, r.first, r.second);
+			}
+		}
+
+	unique_lock<Mutex> l(batch->x_pending);
+	batch->pendingDone.wait(l, [&](){ return !batch->pending; });
+	return batch->results;
+}
+
 ImportResult TransactionQueue::check_WITH_LOCK(h256 const& _h, IfDropped _ik)
 {
 	if (m_known.count(_h))
@@ -83,6 +152,36 @@ ImportResult TransactionQueue::import(Transaction const& _transaction, IfDropped
 {
 	if (_transaction.hasZeroSignature())
 		return ImportResult::ZeroSignature;
+
+	// The pool refuses bad signatures whatever the fork; a block verifying later finds the result in SignatureCache.
+	try
+	{
+		if (_transaction.hasSignature())
+			_transaction.checkSignature();
+	}
+	catch (Exception const&)
+	{
+		return ImportResult::Malformed;
+	}
+
+	// Admission against the chain head; verifier threads do this in parallel as it needs neither m_lock nor State.
+	try
+	{
+		SenderState sender;
+		if (m_senderStates.state(_transaction.from(), sender))
+		{
+			if (_transaction.nonce() < sender.nonce)
+				return ImportResult::NonceTooLow;
+			if (sender.balance < bigint(_transaction.gas()) * _transaction.gasPrice() + _transaction.value())
+				return ImportResult::InsufficientBalance;
+		}
+	}
+	catch (Exception const& _e)
+	{
+		ctxq << "Ignoring invalid transaction: " << diagnostic_information(_e);
+		return ImportResult::Malformed;
+	}
+
 	// Check if we already know this transaction.
 	h256 h = _transaction.sha3(WithSignature);
 
@@ -105,9 +204,48 @@ Transactions TransactionQueue::topTransactions(unsigned _limit, h256Hash const&
 {
 	ReadGuard l(m_lock);
 	Transactions ret;
-	for (auto t = m_current.begin(); ret.size() < _limit && t != m_current.end(); ++t)
-		if (!_avoid.count(t->transaction.sha3()))
-			ret.push_back(t->transaction);
+
+	// Merge the lanes by the key of their next transaction. Every head outranks every other
+	// transaction, so heads are taken from m_currentHeads one at a time as the previous one
+	// is used, keeping the heap as small as the output.
+	struct Candidate
+	{
+		LaneKey key;
+		Lane const* lane;
+		Lane::const_iterator next;
+	};
+	auto worse = [](Candidate const& _a, Candidate const& _b) { return _b.key < _a.key; };
+	priority_queue<Candidate, vector<Candidate>, decltype(worse)> merge(worse);
+
+	auto head = m_currentHeads.begin();
+	auto pushHead = [&]()
+	{
+		if (head == m_currentHeads.end())
+			return;
+		Lane const& lane = m_current.at(head->sender);
+		merge.push(Candidate{*head, &lane, lane.begin()});
+		++head;
+	};
+
+	pushHead();
+	while (ret.size() < _limit && !merge.empty())
+	{
+		Candidate c = merge.top();
+		merge.pop();
+		if (c.next == c.lane->begin())
+			pushHead();
+
+		Transaction const& t = c.next->second.transaction;
+		if (!_avoid.count(t.sha3()))
+			ret.push_back(t);
+
+		if (++c.next != c.lane->end())
+		{
+			c.key.height = c.next->first - c.lane->begin()->first;
+			c.key.gasPrice = c.next->second.transaction.gasPrice();
+			merge.push(c);
+		}
+	}
 	return ret;
 }
 
@@ -117,6 +255,25 @@ h256Hash TransactionQueue::knownTransactions() const
 	return m_known;
 }
 
+bool TransactionQueue::isKnown(h256 const& _txHash) const
+{
+	ReadGuard l(m_lock);
+	return m_known.count(_txHash) || m_dropped.count(_txHash);
+}
+
+Transactions TransactionQueue::transactions(h256s const& _txHashes) const
+{
+	ReadGuard l(m_lock);
+	Transactions ret;
+	for (auto const& h: _txHashes)
+	{
+		auto it = m_currentByHash.find(h);
+		if (it != m_currentByHash.end())
+			ret.push_back(it->second->second.transaction);
+	}
+	return ret;
+}
+
 ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transaction const& _transaction)
 {
 	try
@@ -124,17 +281,17 @@ ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transactio
 		assert(_h == _transaction.sha3());
 		// Remove any prior transaction with the same nonce but a lower gas price.
 		// Bomb out if there's a prior transaction with higher gas price.
-		auto cs = m_currentByAddressAndNonce.find(_transaction.from());
-		if (cs != m_currentByAddressAndNonce.end())
+		auto cs = m_current.find(_transaction.from());
+		if (cs != m_current.end())
 		{
 			auto t = cs->second.find(_transaction.nonce());
 			if (t != cs->second.end())
 			{
-				if (_transaction.gasPrice() < (*t->second).transaction.gasPrice())
+				if (_transaction.gasPrice() < t->second.transaction.gasPrice())
 					return ImportResult::OverbidGasPrice;
 				else
 				{
-					h256 dropped = (*t->second).transaction.sha3();
+					h256 dropped = t->second.transaction.sha3();
 					remove_WITH_LOCK(dropped);
 					m_onReplaced(dropped);
 				}
@@ -161,10 +318,10 @@ ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transactio
 		insertCurrent_WITH_LOCK(make_pair(_h, _transaction));
 		clog(TransactionQueueTraceChannel) << "Queued vaguely legit-looking transaction" << _h;
 
-		while (m_current.size() > m_limit)
+		while (m_currentByHash.size() > m_limit)
 		{
 			clog(TransactionQueueTraceChannel) << "Dropping out of bounds transaction" << _h;
-			remove_WITH_LOCK(m_current.rbegin()->transaction.sha3());
+			remove_WITH_LOCK(m_current.at(m_currentTails.rbegin()->sender).rbegin()->second.transaction.sha3());
 		}
 
 		m_onReady();
@@ -192,8 +349,8 @@ u256 TransactionQueue::maxNonce(Address const& _a) const
 u256 TransactionQueue::maxNonce_WITH_LOCK(Address const& _a) const
 {
 	u256 ret = 0;
-	auto cs = m_currentByAddressAndNonce.find(_a);
-	if (cs != m_currentByAddressAndNonce.end() && !cs->second.empty())
+	auto cs = m_current.find(_a);
+	if (cs != m_current.end() && !cs->second.empty())
 		ret = cs->second.rbegin()->first + 1;
 	auto fs = m_future.find(_a);
 	if (fs != m_future.end() && !fs->second.empty())
@@ -211,30 +368,58 @@ void TransactionQueue::insertCurrent_WITH_LOCK(std::pair<h256, Transaction> cons
 
 	Transaction const& t = _p.second;
 	// Insert into current
-	auto inserted = m_currentByAddressAndNonce[t.from()].insert(std::make_pair(t.nonce(), PriorityQueue::iterator()));
-	PriorityQueue::iterator handle = m_current.emplace(VerifiedTransaction(t));
-	inserted.first->second = handle;
-	m_currentByHash[_p.first] = handle;
+	Lane& lane = m_current[t.from()];
+	unindexLane_WITH_LOCK(t.from(), lane);
+	auto inserted = lane.emplace(t.nonce(), VerifiedTransaction(t));
+	if (inserted.second)
+		m_currentByHash[_p.first] = inserted.first;
+	indexLane_WITH_LOCK(t.from());
+	if (!inserted.second)
+	{
+		cwarn << "Transaction nonce" << t.nonce() << "of" << t.from() << "already in current?!";
+		return;
+	}
+	m_onCurrent(t);
 
 	// Move following transactions from future to current
 	makeCurrent_WITH_LOCK(t);
 	m_known.insert(_p.first);
 }
 
+void TransactionQueue::unindexLane_WITH_LOCK(Address const& _sender, Lane const& _lane)
+{
+	if (_lane.empty())
+		return;
+	m_currentHeads.erase(headKey(_sender, _lane));
+	m_currentTails.erase(tailKey(_sender, _lane));
+}
+
+void TransactionQueue::indexLane_WITH_LOCK(Address const& _sender)
+{
+	auto it = m_current.find(_sender);
+	if (it == m_current.end())
+		return;
+	if (it->second.empty())
+	{
+		m_current.erase(it);
+		return;
+	}
+	m_currentHeads.insert(headKey(_sender, it->second));
+	m_currentTails.insert(tailKey(_sender, it->second));
+}
+
 bool TransactionQueue::remove_WITH_LOCK(h256 const& _txHash)
 {
 	auto t = m_currentByHash.find(_txHash);
 	if (t == m_currentByHash.end())
 		return false;
 
-	Address from = (*t->second).transaction.from();
-	auto it = m_currentByAddressAndNonce.find(from);
-	assert (it != m_currentByAddressAndNonce.end());
-	it->second.erase((*t->second).transaction.nonce());
-	m_current.erase(t->second);
+	Address const from = t->second->second.transaction.from();
+	Lane& lane = m_current.at(from);
+	unindexLane_WITH_LOCK(from, lane);
+	lane.erase(t->second);
 	m_currentByHash.erase(t);
-	if (it->second.empty())
-		m_currentByAddressAndNonce.erase(it);
+	indexLane_WITH_LOCK(from);
 	m_known.erase(_txHash);
 	return true;
 }
@@ -243,8 +428,8 @@ unsigned TransactionQueue::waiting(Address const& _a) const
 {
 	ReadGuard l(m_lock);
 	unsigned ret = 0;
-	auto cs = m_currentByAddressAndNonce.find(_a);
-	if (cs != m_currentByAddressAndNonce.end())
+	auto cs = m_current.find(_a);
+	if (cs != m_current.end())
 		ret = cs->second.size();
 	auto fs = m_future.find(_a);
 	if (fs != m_future.end())
@@ -259,23 +444,19 @@ void TransactionQueue::setFuture(h256 const& _txHash)
 	if (it == m_currentByHash.end())
 		return;
 
-	VerifiedTransaction const& st = *(it->second);
-
-	Address from = st.transaction.from();
-	auto& queue = m_currentByAddressAndNonce[from];
+	auto cutoff = it->second;
+	Address const from = cutoff->second.transaction.from();
+	Lane& lane = m_current.at(from);
 	auto& target = m_future[from];
-	auto cutoff = queue.lower_bound(st.transaction.nonce());
-	for (auto m = cutoff; m != queue.end(); ++m)
+	unindexLane_WITH_LOCK(from, lane);
+	for (auto m = cutoff; m != lane.end(); ++m)
 	{
-		VerifiedTransaction& t = const_cast<VerifiedTransaction&>(*(m->second)); // set has only const iterators. Since we are moving out of container that's fine
-		m_currentByHash.erase(t.transaction.sha3());
-		target.emplace(t.transaction.nonce(), move(t));
-		m_current.erase(m->second);
+		m_currentByHash.erase(m->second.transaction.sha3());
+		target.emplace(m->first, move(m->second));
 		++m_futureSize;
 	}
-	queue.erase(cutoff, queue.end());
-	if (queue.empty())
-		m_currentByAddressAndNonce.erase(from);
+	lane.erase(cutoff, lane.end());
+	indexLane_WITH_LOCK(from);
 }
 
 void TransactionQueue::makeCurrent_WITH_LOCK(Transaction const& _t)
@@ -288,18 +469,23 @@ void TransactionQueue::makeCurrent_WITH_LOCK(Transaction const& _t)
 		auto fb = fs->second.find(nonce);
 		if (fb != fs->second.end())
 		{
+			Lane& lane = m_current[_t.from()];
+			unindexLane_WITH_LOCK(_t.from(), lane);
 			auto ft = fb;
 			while (ft != fs->second.end() && ft->second.transaction.nonce() == nonce)
 			{
-				auto inserted = m_currentByAddressAndNonce[_t.from()].insert(std::make_pair(ft->second.transaction.nonce(), PriorityQueue::iterator()));
-				PriorityQueue::iterator handle = m_current.emplace(move(ft->second));
-				inserted.first->second = handle;
-				m_currentByHash[(*handle).transaction.sha3()] = handle;
+				if (!lane.count(nonce))
+				{
+					auto handle = lane.emplace(nonce, move(ft->second)).first;
+					m_currentByHash[handle->second.transaction.sha3()] = handle;
+					m_onCurrent(handle->second.transaction);
+					newCurrent = true;
+				}
 				--m_futureSize;
 				++ft;
 				++nonce;
-				newCurrent = true;
 			}
+			indexLane_WITH_LOCK(_t.from());
 			fs->second.erase(fb, ft);
 			if (fs->second.empty())
 				m_future.erase(_t.from());
@@ -347,58 +533,50 @@ void TransactionQueue::clear()
 	WriteGuard l(m_lock);
 	m_known.clear();
 	m_current.clear();
-	m_currentByAddressAndNonce.clear();
 	m_currentByHash.clear();
+	m_currentHeads.clear();
+	m_currentTails.clear();
 	m_future.clear();
 	m_futureSize = 0;
+	m_senderStates.clear();
 }
 
-void TransactionQueue::enqueue(RLP const& _data, ECDSA::Public const& _nodeId)
+void TransactionQueue::enqueue(RLP const& _data, ECDSA::Public const& _nodeId, SharedBytesRef const& _packet)
 {
-	bool queued = false;
-	{
-		Guard l(x_queue);
-		unsigned itemCount = _data.itemCount();
-		for (unsigned i = 0; i < itemCount; ++i)
+	unsigned itemCount = _data.itemCount();
+	for (unsigned i = 0; i < itemCount; ++i)
+		if (!m_unverified.push(UnverifiedTransaction(_packet.slice(_data[i].data()), _nodeId)))
 		{
-			if (m_unverified.size() >= c_maxVerificationQueueSize)
-			{
-				clog(TransactionQueueChannel) << "Transaction verification queue is full. Dropping" << itemCount - i << "transactions";
-				break;
-			}
-			m_unverified.emplace_back(UnverifiedTransaction(_data[i].data(), _nodeId));
-			queued = true;
+			clog(TransactionQueueChannel) << "Transaction verification queue is full. Dropping" << itemCount - i << "transactions";
+			break;
 		}
-	}
-	if (queued)
-		m_queueReady.notify_all();
 }
 
 void TransactionQueue::verifierBody()
 {
-	while (!m_aborting)
+	std::vector<UnverifiedTransaction> work;
+	while (m_unverified.pop_batch(work, c_verifyBatch))
 	{
-		UnverifiedTransaction work;
-
-		{
-			unique_lock<Mutex> l(x_queue);
-			m_queueReady.wait(l, [&](){ return !m_unverified.empty() || m_aborting; });
-			if (m_aborting)
-				return;
-			work = move(m_unverified.front());
-			m_unverified.pop_front();
-		}
-
-		try
-		{
-			Transaction t(work.transaction, CheckTransaction::Cheap); //Signature will be checked later
-			ImportResult ir = import(t);
-			m_onImport(ir, t.sha3(), work.nodeId);
-		}
-		catch (...)
+		for (UnverifiedTransaction& w: work)
 		{
-			// should not happen as exceptions are handled in import.
-			cwarn << "Bad transaction:" << boost::current_exception_diagnostic_information();
+			if (w.done)
+			{
+				auto r = importWithHash(w.transaction.ref(), w.ifDropped);
+				w.done(r.first, r.second);
+				continue;
+			}
+			try
+			{
+				Transaction t(w.transaction.ref(), CheckTransaction::Cheap); //Signature will be checked later
+				ImportResult ir = import(t);
+				m_onImport(ir, t.sha3(), w.nodeId);
+			}
+			catch (...)
+			{
+				// should not happen as exceptions are handled in import.
+				cwarn << "Bad transaction:" << boost::current_exception_diagnostic_information();
+			}
 		}
+		work.clear();
 	}
 }
@@ -22,13 +22,17 @@
 #pragma once
 
 #include <functional>
-#include <condition_variable>
 #include <thread>
-#include <deque>
+#include <map>
+#include <set>
+#include <tuple>
 #include <libdevcore/Common.h>
 #include <libdevcore/Guards.h>
 #include <libdevcore/Log.h>
+#include <libdevcore/SharedBytes.h>
+#include <libdevcore/mpmc_queue.h>
 #include <libethcore/Common.h>
+#include "SenderStateCache.h"
 #include "Transaction.h"
 
 namespace dev
@@ -43,6 +47,9 @@ struct TransactionQueueTraceChannel: public LogChannel { static const char* name
 /**
  * @brief A queue of Transactions, each stored as RLP.
  * Maintains a transaction queue sorted by nonce diff and gas price.
+ * Current transactions are kept in per-sender lanes ordered by nonce; the heads and tails of
+ * all lanes are indexed globally, so the best transactions are a merge across lanes and the
+ * worst one is always at hand when the queue is over its limit.
  * @threadsafe
  */
 class TransactionQueue
@@ -59,7 +66,8 @@ public:
 	/// Add transaction to the queue to be verified and imported.
 	/// @param _data RLP encoded transaction data.
 	/// @param _nodeId Optional network identified of a node transaction comes from.
-    void enqueue(RLP const& _data, ECDSA::Public const& _nodeId);
+	/// @param _packet Buffer that @a _data points into, if any; queued transactions share it instead of being copied.
+    void enqueue(RLP const& _data, ECDSA::Public const& _nodeId, SharedBytesRef const& _packet = SharedBytesRef());
 
 	/// Verify and add transaction to the queue synchronously.
 	/// @param _tx RLP encoded transaction data.
@@ -73,6 +81,14 @@ public:
 	/// @returns Import result code.
 	ImportResult import(Transaction const& _tx, IfDropped _ik = IfDropped::Ignore);
 
+	/// Verify and add several transactions on the verifier threads, waiting until all are done.
+	/// Transactions that do not fit in the verification queue are imported on the calling thread;
+	/// those still waiting for a verifier when the queue is destroyed are reported as Aborted.
+	/// @param _txs RLP encoded transactions.
+	/// @param _ik Set to Retry to force re-adding transactions that were previously dropped.
+	/// @returns the import result and hash of each of @a _txs, in order; the hash of a malformed transaction is zero.
+	std::vector<std::pair<ImportResult, h256>> importBatch(std::vector<bytes> _txs, IfDropped _ik = IfDropped::Ignore);
+
 	/// Remove transaction from the queue
 	/// @param _txHash Trasnaction hash
 	void drop(h256 const& _txHash);
@@ -91,6 +107,16 @@ public:
 	/// @returns A hash set of all transactions in the queue
 	h256Hash knownTransactions() const;
 
+	/// Check whether a transaction is queued or was previously dropped from the queue
+	/// @param _txHash Transaction hash
+	/// @returns true if there is no point fetching the transaction again
+	bool isKnown(h256 const& _txHash) const;
+
+	/// Look up current transactions by hash
+	/// @param _txHashes Transaction hashes
+	/// @returns the current transactions among @a _txHashes, in the same order; unknown hashes are skipped
+	Transactions transactions(h256s const& _txHashes) const;
+
 	/// Get max nonce for an account
 	/// @returns Max transaction nonce for account in the queue
 	u256 maxNonce(Address const& _a) const;
@@ -109,9 +135,10 @@ public:
 		size_t future;
 		size_t unverified;
 		size_t dropped;
+		size_t unverifiedDropped;	///< Network transactions refused because the verification queue was full.
 	};
 	/// @returns the status of the transaction queue.
-	Status status() const { Status ret; DEV_GUARDED(x_queue) { ret.unverified = m_unverified.size(); } ReadGuard l(m_lock); ret.dropped = m_dropped.size(); ret.current = m_currentByHash.size(); ret.future = m_future.size(); return ret; }
+	Status status() const { Status ret; ret.unverified = m_unverified.depth(); ret.unverifiedDropped = m_unverified.dropped(); ReadGuard l(m_lock); ret.dropped = m_dropped.size(); ret.current = m_currentByHash.size(); ret.future = m_future.size(); return ret; }
 
 	/// @returns the transacrtion limits on current/future.
 	Limits limits() const { return Limits{m_limit, m_futureLimit}; }
@@ -119,6 +146,10 @@ public:
 	/// Clear the queue
 	void clear();
 
+	/// Nonces and balances at the chain head that import() admits transactions against.
+	/// Empty and without a reader unless the owner sets one up and keeps it current.
+	SenderStateCache& senderStates() { return m_senderStates; }
+
 	/// Register a handler that will be called once there is a new transaction imported
 	template <class T> Handler<> onReady(T const& _t) { return m_onReady.add(_t); }
 
@@ -128,6 +159,10 @@ public:
 	/// Register a handler that will be called once asynchronous verification is comeplte an transaction has been imported
 	template <class T> Handler<h256 const&> onReplaced(T const& _t) { return m_onReplaced.add(_t); }
 
+	/// Register a handler that will be called for each transaction that becomes current, in nonce order for each sender.
+	/// Called with the queue locked; be nice and exit fast.
+	template <class T> Handler<Transaction const&> onCurrent(T const& _t) { return m_onCurrent.add(_t); }
+
 private:
 
 	/// Verified and imported transaction
@@ -147,44 +182,56 @@ private:
 	{
         typedef ECDSA::Public NodeID;
 		UnverifiedTransaction() {}
-        UnverifiedTransaction(bytesConstRef const& _t, NodeID const& _nodeId): transaction(_t.toBytes()), nodeId(_nodeId) {}
-		UnverifiedTransaction(UnverifiedTransaction&& _t): transaction(std::move(_t.transaction)), nodeId(std::move(_t.nodeId)) {}
+        UnverifiedTransaction(SharedBytesRef const& _t, NodeID const& _nodeId): transaction(_t), nodeId(_nodeId) {}
+		UnverifiedTransaction(UnverifiedTransaction&& _t): transaction(std::move(_t.transaction)), nodeId(std::move(_t.nodeId)), ifDropped(_t.ifDropped), done(std::move(_t.done)) {}
 		UnverifiedTransaction& operator=(UnverifiedTransaction&& _other)
 		{
 			assert(&_other != this);
 
 			transaction = std::move(_other.transaction);
 			nodeId = std::move(_other.nodeId);
+			ifDropped = _other.ifDropped;
+			done = std::move(_other.done);
 			return *this;
 		}
 
 		UnverifiedTransaction(UnverifiedTransaction const&) = delete;
 		UnverifiedTransaction& operator=(UnverifiedTransaction const&) = delete;
 
-		bytes transaction;	///< RLP encoded transaction data
+		SharedBytesRef transaction;	///< RLP encoded transaction data
         NodeID nodeId;		///< Network Id of the peer transaction comes from
+		IfDropped ifDropped = IfDropped::Ignore;
+		std::function<void(ImportResult, h256 const&)> done;	///< Set for importBatch(), which is told the result instead of m_onImport
 	};
 
-	struct PriorityCompare
+	/// Current transactions of one sender by nonce.
+	using Lane = std::map<u256, VerifiedTransaction>;
+
+	/// Priority of a transaction in its lane.
+	struct LaneKey
 	{
-		TransactionQueue& queue;
-		/// Compare transaction by nonce height and gas price.
-		bool operator()(VerifiedTransaction const& _first, VerifiedTransaction const& _second) const
-		{
-			u256 const& height1 = _first.transaction.nonce() - queue.m_currentByAddressAndNonce[_first.transaction.sender()].begin()->first;
-			u256 const& height2 = _second.transaction.nonce() - queue.m_currentByAddressAndNonce[_second.transaction.sender()].begin()->first;
-			return height1 < height2 || (height1 == height2 && _first.transaction.gasPrice() > _second.transaction.gasPrice());
-		}
+		u256 height;		///< Nonce distance from the head of the lane.
+		u256 gasPrice;
+		Address sender;
+
+		/// Lower height first, then higher gas price.
+		bool operator<(LaneKey const& _other) const { return std::tie(height, _other.gasPrice, sender) < std::tie(_other.height, gasPrice, _other.sender); }
 	};
 
-	// Use a set with dynamic comparator for minmax priority queue. The comparator takes into account min account nonce. Updating it does not affect the order.
-	using PriorityQueue = std::multiset<VerifiedTransaction, PriorityCompare>;
+	static LaneKey headKey(Address const& _sender, Lane const& _lane) { return LaneKey{0, _lane.begin()->second.transaction.gasPrice(), _sender}; }
+	static LaneKey tailKey(Address const& _sender, Lane const& _lane) { return LaneKey{_lane.rbegin()->first - _lane.begin()->first, _lane.rbegin()->second.transaction.gasPrice(), _sender}; }
 
 	ImportResult import(bytesConstRef _tx, IfDropped _ik = IfDropped::Ignore);
+	/// As import(bytesConstRef, IfDropped), also returning the hash of the transaction.
+	std::pair<ImportResult, h256> importWithHash(bytesConstRef _tx, IfDropped _ik);
 	ImportResult check_WITH_LOCK(h256 const& _h, IfDropped _ik);
 	ImportResult manageImport_WITH_LOCK(h256 const& _h, Transaction const& _transaction);
 
 	void insertCurrent_WITH_LOCK(std::pair<h256, Transaction> const& _p);
+	/// Take a lane out of m_currentHeads and m_currentTails before changing it.
+	void unindexLane_WITH_LOCK(Address const& _sender, Lane const& _lane);
+	/// Put a changed lane back into m_currentHeads and m_currentTails, or drop it if it is empty.
+	void indexLane_WITH_LOCK(Address const& _sender);
 	void makeCurrent_WITH_LOCK(Transaction const& _t);
 	bool remove_WITH_LOCK(h256 const& _txHash);
 	u256 maxNonce_WITH_LOCK(Address const& _a) const;
@@ -196,24 +243,25 @@ private:
 	std::unordered_map<h256, std::function<void(ImportResult)>> m_callbacks;	///< Called once.
 	h256Hash m_dropped;															///< Transactions that have previously been dropped
 
-	PriorityQueue m_current;
-	std::unordered_map<h256, PriorityQueue::iterator> m_currentByHash;			///< Transaction hash to set ref
-	std::unordered_map<Address, std::map<u256, PriorityQueue::iterator>> m_currentByAddressAndNonce; ///< Transactions grouped by account and nonce
+	std::unordered_map<Address, Lane> m_current;								///< Current transactions grouped by account and nonce
+	std::unordered_map<h256, Lane::iterator> m_currentByHash;					///< Transaction hash to lane entry
+	std::set<LaneKey> m_currentHeads;											///< Key of the first transaction of every lane, best first
+	std::set<LaneKey> m_currentTails;											///< Key of the last transaction of every lane; the last one is dropped first
 	std::unordered_map<Address, std::map<u256, VerifiedTransaction>> m_future;	/// Future transactions
 
     typedef ECDSA::Public NodeID;
 	Signal<> m_onReady;															///< Called when a subsequent call to import transactions will return a non-empty container. Be nice and exit fast.
     Signal<ImportResult, h256 const&, NodeID const&> m_onImport;					///< Called for each import attempt. Arguments are result, transaction id an node id. Be nice and exit fast.
 	Signal<h256 const&> m_onReplaced;											///< Called whan transction is dropped during a call to import() to make room for another transaction.
+	Signal<Transaction const&> m_onCurrent;										///< Called for each transaction moved into m_current.
 	unsigned m_limit;															///< Max number of pending transactions
 	unsigned m_futureLimit;														///< Max number of future transactions
 	unsigned m_futureSize = 0;													///< Current number of future transactions
 
-	std::condition_variable m_queueReady;										///< Signaled when m_unverified has a new entry.
 	std::vector<std::thread> m_verifiers;
-	std::deque<UnverifiedTransaction> m_unverified;								///< Pending verification queue
-	mutable Mutex x_queue;														///< Verification queue mutex
-	std::atomic<bool> m_aborting = {false};										///< Exit condition for verifier.
+	mpmc_queue<UnverifiedTransaction> m_unverified;								///< Pending verification queue; closed to stop the verifiers.
+	mutable SharedMutex x_unverifiedClosing;									///< Held shared by importBatch() while pushing, so the destructor's drain sees all it pushed.
+	SenderStateCache m_senderStates;											///< Sender nonces and balances at the chain head; consulted without m_lock.
 };
 
 }
@@ -21,6 +21,7 @@
 
 
 #include <libdevcore/Common.h>
+#include <libdevcore/SharedBytes.h>
 #include <libethcore/BlockHeader.h>
 
 #pragma once
@@ -66,7 +67,7 @@ struct VerifiedBlock
 	}
 
 	VerifiedBlockRef verified;				///< Verified block structures
-	bytes blockData;						///< Block data
+	SharedBytesRef blockData;				///< Block data
 
 private:
 	VerifiedBlock(VerifiedBlock const&) = delete;
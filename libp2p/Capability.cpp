@@ -40,6 +40,13 @@ void Capability::disable(std::string const& _problem)
 	m_enabled = false;
 }
 
+bool Capability::interpretPacket(unsigned _id, RLP const& _r, SharedBytesRef const& _packet)
+{
+	m_packet = _packet;
+	ScopeGuard release([this]() { m_packet = SharedBytesRef(); });
+	return interpret(_id, _r);
+}
+
 RLPStream& Capability::prep(RLPStream& _s, unsigned _id, unsigned _args)
 {
 	return _s.appendRaw(bytes(1, _id + m_idOffset)).appendList(_args);
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <libdevcore/SharedBytes.h>
 #include "Common.h"
 #include "HostCapability.h"
 
@@ -44,6 +45,11 @@ public:
 	static u256 version() { return 0; }
 	static unsigned messageCount() { return 0; }
 */
+
+	/// Buffer holding the packet being interpreted. Keep a slice of it instead of copying data out
+	/// of the RLP passed to interpret(). Empty outside interpret().
+	SharedBytesRef const& packet() const { return m_packet; }
+
 protected:
 	std::shared_ptr<SessionFace> session() const { return m_session.lock(); }
 	HostCapabilityFace* hostCapability() const { return m_hostCap; }
@@ -59,10 +65,14 @@ protected:
 	uint16_t const c_protocolID;
 
 private:
+	/// Called by Session: interpret() with @a _packet exposed through packet().
+	bool interpretPacket(unsigned _id, RLP const& _r, SharedBytesRef const& _packet);
+
 	std::weak_ptr<SessionFace> m_session;
 	HostCapabilityFace* m_hostCap;
 	bool m_enabled = true;
 	unsigned m_idOffset;
+	SharedBytesRef m_packet;
 };
 
 }
@@ -102,7 +102,8 @@ Host::Host(string const& _clientVersion, KeyPair<ECDSA> const& _alias, NetworkPr
 	m_clientVersion(_clientVersion),
 	m_netPrefs(_n),
 	m_ifAddresses(Network::getInterfaceAddresses()),
-	m_ioService(2),
+	m_ioService(max(2u, _n.ioThreads)),
+	m_strand(m_ioService),
 	m_tcp4Acceptor(m_ioService),
 	m_alias(_alias),
 	m_lastPing(chrono::steady_clock::time_point::min())
@@ -165,6 +166,16 @@ void Host::stop()
 
 void Host::doneWorking()
 {
+	// run() has stopped the io_service, so the other network threads are finishing too
+	for (auto& t: m_ioThreads)
+		t.join();
+	m_ioThreads.clear();
+
+	// normally done by run() already; the node table is gone, so its pending handlers are dropped unrun
+	stopDiscovery();
+	m_nodeTable.reset();
+	m_discoveryIo.reset();
+
 	// reset ioservice (cancels all timers and allows manually polling network, below)
 	m_ioService.reset();
 
@@ -436,7 +447,7 @@ void Host::runAcceptor()
 		m_accepting = true;
 
 		auto socket = make_shared<RLPXSocket>(m_ioService);
-		m_tcp4Acceptor.async_accept(socket->ref(), [=](boost::system::error_code ec)
+		m_tcp4Acceptor.async_accept(socket->ref(), m_strand.wrap([=](boost::system::error_code ec)
 		{
 			m_accepting = false;
 			if (ec || !m_run)
@@ -474,7 +485,7 @@ void Host::runAcceptor()
 			if (!success)
 				socket->ref().close();
 			runAcceptor();
-		});
+		}));
 	}
 }
 
@@ -548,13 +559,13 @@ void Host::requirePeer(NodeID const& _n, NodeIPEndpoint const& _endpoint)
 		m_nodeTable->addNode(node);
 		auto t = make_shared<boost::asio::deadline_timer>(m_ioService);
 		t->expires_from_now(boost::posix_time::milliseconds(600));
-		t->async_wait([this, _n](boost::system::error_code const& _ec)
+		t->async_wait(m_strand.wrap([this, _n](boost::system::error_code const& _ec)
 		{
 			if (!_ec)
 				if (m_nodeTable)
 					if (auto n = m_nodeTable->node(_n))
 						requirePeer(n.id, n.endpoint);
-		});
+		}));
 		DEV_GUARDED(x_timers)
 			m_timers.push_back(t);
 	}
@@ -595,7 +606,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 	bi::tcp::endpoint ep(_p->endpoint);
 	clog(NetConnect) << "Attempting connection to node" << _p->id << "@" << ep << "from" << id();
 	auto socket = make_shared<RLPXSocket>(m_ioService);
-	socket->ref().async_connect(ep, [=](boost::system::error_code const& ec)
+	socket->ref().async_connect(ep, m_strand.wrap([=](boost::system::error_code const& ec)
 	{
 		_p->m_lastAttempted = std::chrono::system_clock::now();
 		_p->m_failedAttempts++;
@@ -620,7 +631,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 		
 		Guard l(x_pendingNodeConns);
 		m_pendingPeerConns.erase(nptr);
-	});
+	}));
 }
 
 PeerSessionInfos Host::peerSessionInfo() const
@@ -652,7 +663,8 @@ void Host::run(boost::system::error_code const&)
 {
 	if (!m_run)
 	{
-		// reset NodeTable
+		// stop discovery before resetting NodeTable, so none of its handlers are running
+		stopDiscovery();
 		m_nodeTable.reset();
 
 		// stopping io service allows running manual network operations for shutdown
@@ -715,7 +727,7 @@ void Host::run(boost::system::error_code const&)
 					connect(p);
 	}
 
-	auto runcb = [this](boost::system::error_code const& error) { run(error); };
+	auto runcb = m_strand.wrap([this](boost::system::error_code const& error) { run(error); });
 	m_timer->expires_from_now(boost::posix_time::milliseconds(c_timerInterval));
 	m_timer->async_wait(runcb);
 }
@@ -749,8 +761,23 @@ void Host::startedWorking()
 	else
 		clog(NetP2PNote) << "p2p.start.notice id:" << id() << "TCP Listen port is invalid or unavailable.";
 
+	m_discoveryIo.reset(new ba::io_service(1));
+	m_discoveryWork.reset(new ba::io_service::work(*m_discoveryIo));
+	m_discoveryThread = std::thread([this]()
+	{
+		setThreadName("p2pdisc");
+		try
+		{
+			m_discoveryIo->run();
+		}
+		catch (std::exception const& _e)
+		{
+			clog(NetP2PWarn) << "Exception in Discovery Thread:" << _e.what();
+		}
+	});
+
 	auto nodeTable = make_shared<NodeTable>(
-		m_ioService,
+		*m_discoveryIo,
 		m_alias,
 		NodeIPEndpoint(bi::address::from_string(listenAddress()), listenPort(), listenPort()),
 		m_netPrefs.discovery
@@ -762,6 +789,23 @@ void Host::startedWorking()
 	clog(NetP2PNote) << "p2p.started id:" << id();
 
 	run(boost::system::error_code());
+
+	for (unsigned i = 1; i < m_netPrefs.ioThreads; ++i)
+		m_ioThreads.emplace_back([this, i]()
+		{
+			setThreadName("p2p" + toString(i));
+			while (m_run)
+				doWork();
+		});
+}
+
+void Host::stopDiscovery()
+{
+	m_discoveryWork.reset();
+	if (m_discoveryIo)
+		m_discoveryIo->stop();
+	if (m_discoveryThread.joinable())
+		m_discoveryThread.join();
 }
 
 void Host::doWork()
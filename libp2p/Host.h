@@ -275,6 +275,9 @@ private:
 	/// Called by startedWorking. Not thread-safe; to be called only be Worker.
 	void run(boost::system::error_code const& error);			///< Run network. Called serially via ASIO deadline timer. Manages connection state transitions.
 
+	/// Stop m_discoveryIo and wait for its thread. Called by run() on shutdown and by doneWorking().
+	void stopDiscovery();
+
 	/// Run network. Not thread-safe; to be called only by worker.
 	virtual void doWork();
 
@@ -299,8 +302,14 @@ private:
 	int m_listenPort = -1;												///< What port are we listening on. -1 means binding failed or acceptor hasn't been initialized.
 
 	ba::io_service m_ioService;											///< IOService for network stuff.
+	ba::io_service::strand m_strand;									///< Serialises the host's own handlers (scheduler, acceptor, connects) when m_ioService has several threads.
+	std::vector<std::thread> m_ioThreads;								///< Threads running m_ioService besides the worker; NetworkPreferences::ioThreads - 1 of them.
 	bi::tcp::acceptor m_tcp4Acceptor;										///< Listening acceptor.
 
+	std::unique_ptr<ba::io_service> m_discoveryIo;						///< IOService of the node table, so discovery isn't queued behind peer traffic. Recreated on every start.
+	std::unique_ptr<ba::io_service::work> m_discoveryWork;				///< Keeps m_discoveryIo running while the network is up.
+	std::thread m_discoveryThread;										///< Runs m_discoveryIo.
+
 	std::unique_ptr<boost::asio::deadline_timer> m_timer;					///< Timer which, when network is running, calls scheduler() every c_timerInterval ms.
 	static const unsigned c_timerInterval = 100;							///< Interval which m_timer is run when network is connected.
 
@@ -52,7 +52,14 @@ NodeTable::NodeTable(ba::io_service& _io, KeyPair<ECDSA> const& _alias, NodeIPEn
 	
 	if (!_enabled)
 		return;
-	
+
+	for (unsigned i = 0; i < s_verifierThreads; ++i)
+		m_verifiers.emplace_back([this, i]()
+		{
+			setThreadName("disc" + toString(i));
+			verifyReceived();
+		});
+
 	try
 	{
 		m_socketPointer->connect();
@@ -68,6 +75,11 @@ NodeTable::NodeTable(ba::io_service& _io, KeyPair<ECDSA> const& _alias, NodeIPEn
 NodeTable::~NodeTable()
 {
 	m_socketPointer->disconnect();
+	DEV_GUARDED(x_received)
+		m_verifying = false;
+	m_receivedChanged.notify_all();
+	for (auto& verifier: m_verifiers)
+		verifier.join();
 	m_timers.stop();
 }
 
@@ -83,8 +95,9 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 	{
 		auto ret = make_shared<NodeEntry>(m_node.id, _node.id, _node.endpoint);
 		ret->pending = false;
-		DEV_GUARDED(x_nodes)
-			m_nodes[_node.id] = ret;
+		NodeShard& shard = nodeShard(_node.id);
+		DEV_GUARDED(shard.x_nodes)
+			shard.nodes[_node.id] = ret;
 		noteActiveNode(_node.id, _node.endpoint);
 		return ret;
 	}
@@ -95,7 +108,7 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 	// ping address to recover nodeid if nodeid is empty
 	if (!_node.id)
 	{
-		DEV_GUARDED(x_nodes)
+		DEV_GUARDED(x_node)
 			clog(NodeTableConnect) << "Sending public key discovery Ping to" << (bi::udp::endpoint)_node.endpoint << "(Advertising:" << (bi::udp::endpoint)m_node.endpoint << ")";
 		DEV_GUARDED(x_pubkDiscoverPings)
 			m_pubkDiscoverPings[_node.endpoint.address] = std::chrono::steady_clock::now();
@@ -103,13 +116,14 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 		return shared_ptr<NodeEntry>();
 	}
 	
-	DEV_GUARDED(x_nodes)
-		if (m_nodes.count(_node.id))
-			return m_nodes[_node.id];
-	
 	auto ret = make_shared<NodeEntry>(m_node.id, _node.id, _node.endpoint);
-	DEV_GUARDED(x_nodes)
-		m_nodes[_node.id] = ret;
+	NodeShard& shard = nodeShard(_node.id);
+	DEV_GUARDED(shard.x_nodes)
+	{
+		auto inserted = shard.nodes.emplace(_node.id, ret);
+		if (!inserted.second)
+			return inserted.first->second;
+	}
 	clog(NodeTableConnect) << "addNode pending for" << _node.endpoint;
 	ping(_node.endpoint);
 	return ret;
@@ -118,17 +132,27 @@ shared_ptr<NodeEntry> NodeTable::addNode(Node const& _node, NodeRelation _relati
 list<NodeID> NodeTable::nodes() const
 {
 	list<NodeID> nodes;
-	DEV_GUARDED(x_nodes)
-		for (auto& i: m_nodes)
-			nodes.push_back(i.second->id);
+	for (auto const& shard: m_nodes)
+		DEV_GUARDED(shard.x_nodes)
+			for (auto& i: shard.nodes)
+				nodes.push_back(i.second->id);
 	return nodes;
 }
 
+unsigned NodeTable::count() const
+{
+	unsigned ret = 0;
+	for (auto const& shard: m_nodes)
+		DEV_GUARDED(shard.x_nodes)
+			ret += shard.nodes.size();
+	return ret;
+}
+
 list<NodeEntry> NodeTable::snapshot() const
 {
 	list<NodeEntry> ret;
-	DEV_GUARDED(x_state)
-		for (auto const& s: m_state)
+	for (auto const& s: m_state)
+		DEV_GUARDED(s.x_nodes)
 			for (auto const& np: s.nodes)
 				if (auto n = np.lock())
 					ret.push_back(*n);
@@ -137,19 +161,17 @@ list<NodeEntry> NodeTable::snapshot() const
 
 Node NodeTable::node(NodeID const& _id)
 {
-	Guard l(x_nodes);
-	if (m_nodes.count(_id))
-	{
-		auto entry = m_nodes[_id];
+	if (auto entry = nodeEntry(_id))
 		return Node(_id, entry->endpoint, entry->peerType);
-	}
 	return UnspecifiedNode;
 }
 
 shared_ptr<NodeEntry> NodeTable::nodeEntry(NodeID _id)
 {
-	Guard l(x_nodes);
-	return m_nodes.count(_id) ? m_nodes[_id] : shared_ptr<NodeEntry>();
+	NodeShard const& shard = nodeShard(_id);
+	Guard l(shard.x_nodes);
+	auto it = shard.nodes.find(_id);
+	return it != shard.nodes.end() ? it->second : shared_ptr<NodeEntry>();
 }
 
 void NodeTable::doDiscover(NodeID _node, unsigned _round, shared_ptr<set<shared_ptr<NodeEntry>>> _tried)
@@ -228,18 +250,8 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 	if (head > 1 && tail != lastBin)
 		while (head != tail && head < s_bins && count < s_bucketSize)
 		{
-			Guard l(x_state);
-			for (auto const& n: m_state[head].nodes)
-				if (auto p = n.lock())
-				{
-					if (count < s_bucketSize)
-						found[distance(_target, p->id)].push_back(p);
-					else
-						break;
-				}
-			
-			if (count < s_bucketSize && tail)
-				for (auto const& n: m_state[tail].nodes)
+			DEV_GUARDED(m_state[head].x_nodes)
+				for (auto const& n: m_state[head].nodes)
 					if (auto p = n.lock())
 					{
 						if (count < s_bucketSize)
@@ -247,6 +259,17 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 						else
 							break;
 					}
+			
+			if (count < s_bucketSize && tail)
+				DEV_GUARDED(m_state[tail].x_nodes)
+					for (auto const& n: m_state[tail].nodes)
+						if (auto p = n.lock())
+						{
+							if (count < s_bucketSize)
+								found[distance(_target, p->id)].push_back(p);
+							else
+								break;
+						}
 
 			head++;
 			if (tail)
@@ -255,7 +278,7 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 	else if (head < 2)
 		while (head < s_bins && count < s_bucketSize)
 		{
-			Guard l(x_state);
+			Guard l(m_state[head].x_nodes);
 			for (auto const& n: m_state[head].nodes)
 				if (auto p = n.lock())
 				{
@@ -269,7 +292,7 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 	else
 		while (tail > 0 && count < s_bucketSize)
 		{
-			Guard l(x_state);
+			Guard l(m_state[tail].x_nodes);
 			for (auto const& n: m_state[tail].nodes)
 				if (auto p = n.lock())
 				{
@@ -292,7 +315,7 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 void NodeTable::ping(NodeIPEndpoint _to) const
 {
 	NodeIPEndpoint src;
-	DEV_GUARDED(x_nodes)
+	DEV_GUARDED(x_node)
 		src = m_node.endpoint;
 	PingNode p(src, _to);
 	p.sign(m_secret);
@@ -337,8 +360,8 @@ void NodeTable::noteActiveNode(ECDSA::Public const& _pubk, bi::udp::endpoint con
 		
 		shared_ptr<NodeEntry> contested;
 		{
-			Guard l(x_state);
 			NodeBucket& s = bucket_UNSAFE(node.get());
+			Guard l(s.x_nodes);
 			bool removed = false;
 			s.nodes.remove_if([&node, &removed](weak_ptr<NodeEntry> const& n)
 			{
@@ -379,8 +402,8 @@ void NodeTable::dropNode(shared_ptr<NodeEntry> _n)
 {
 	// remove from nodetable
 	{
-		Guard l(x_state);
 		NodeBucket& s = bucket_UNSAFE(_n.get());
+		Guard l(s.x_nodes);
 		s.nodes.remove_if([&_n](weak_ptr<NodeEntry> n) { return n.lock() == _n; });
 	}
 	
@@ -396,6 +419,42 @@ NodeTable::NodeBucket& NodeTable::bucket_UNSAFE(NodeEntry const* _n)
 }
 
 void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packet)
+{
+	{
+		Guard l(x_received);
+		if (m_received.size() >= s_maxReceived)
+		{
+			clog(NodeTableWarn) << "Dropping packet from " << _from.address().to_string() << ":" << _from.port() << " (verification queue full)";
+			return;
+		}
+		m_received.push_back(ReceivedPacket{_from, _packet.toBytes()});
+	}
+	m_receivedChanged.notify_one();
+}
+
+void NodeTable::verifyReceived()
+{
+	vector<ReceivedPacket> batch;
+	while (true)
+	{
+		{
+			unique_lock<Mutex> l(x_received);
+			m_receivedChanged.wait(l, [this]() { return !m_verifying || !m_received.empty(); });
+			if (!m_verifying)
+				return;
+			while (!m_received.empty() && batch.size() < s_verifyBatch)
+			{
+				batch.push_back(move(m_received.front()));
+				m_received.pop_front();
+			}
+		}
+		for (auto const& packet: batch)
+			handleReceived(packet.from, &packet.data);
+		batch.clear();
+	}
+}
+
+void NodeTable::handleReceived(bi::udp::endpoint const& _from, bytesConstRef _packet)
 {
 	try {
 		unique_ptr<DiscoveryDatagram> packet = DiscoveryDatagram::interpretUDP(_from, _packet);
@@ -457,7 +516,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				}
 				
 				// update our endpoint address and UDP port
-				DEV_GUARDED(x_nodes)
+				DEV_GUARDED(x_node)
 				{
 					if ((!m_node.endpoint || !m_node.endpoint.isAllowed()) && isPublicAddress(in.destination.address))
 						m_node.endpoint.address = in.destination.address;
@@ -550,11 +609,10 @@ void NodeTable::doCheckEvictions()
 		list<shared_ptr<NodeEntry>> drop;
 		{
 			Guard le(x_evictions);
-			Guard ln(x_nodes);
 			for (auto& e: m_evictions)
 				if (chrono::steady_clock::now() - e.second.evictedTimePoint > c_reqTimeout)
-					if (m_nodes.count(e.second.newNodeID))
-						drop.push_back(m_nodes[e.second.newNodeID]);
+					if (auto n = nodeEntry(e.second.newNodeID))
+						drop.push_back(n);
 			evictionsRemain = (m_evictions.size() - drop.size() > 0);
 		}
 		
@@ -22,6 +22,9 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 
 #include <boost/integer/static_log2.hpp>
 
@@ -99,7 +102,13 @@ inline std::ostream& operator<<(std::ostream& _out, NodeTable const& _nodeTable)
  * Host whenever a node is added or removed to/from the table.
  *
  * Thread-safety is ensured by modifying NodeEntry details via
- * shared_ptr replacement instead of mutating values.
+ * shared_ptr replacement instead of mutating values. Known nodes are
+ * striped over s_nodeShards maps and every bucket has its own lock, so
+ * packets from unrelated nodes are handled concurrently.
+ *
+ * Received packets are queued and their signatures recovered by a small
+ * pool of verifier threads, which take them in batches; the socket's
+ * io_service thread only moves datagrams off the wire.
  *
  * NodeTable accepts a port for UDP and will listen to the port on all available
  * interfaces.
@@ -161,13 +170,13 @@ public:
 	std::list<NodeID> nodes() const;
 
 	/// Returns node count.
-	unsigned count() const { return m_nodes.size(); }
+	unsigned count() const;
 
 	/// Returns snapshot of table.
 	std::list<NodeEntry> snapshot() const;
 
 	/// Returns true if node id is in node table.
-	bool haveNode(NodeID const& _id) { Guard l(x_nodes); return m_nodes.count(_id) > 0; }
+	bool haveNode(NodeID const& _id) { NodeShard const& s = nodeShard(_id); Guard l(s.x_nodes); return s.nodes.count(_id) > 0; }
 
 	/// Returns the Node to the corresponding node id or the empty Node if that id is not found.
 	Node node(NodeID const& _id);
@@ -189,6 +198,10 @@ private:
 
 	static unsigned const s_bucketSize = 16;			///< Denoted by k in [Kademlia]. Number of nodes stored in each bucket.
 	static unsigned const s_alpha = 3;				///< Denoted by \alpha in [Kademlia]. Number of concurrent FindNode requests.
+	static unsigned const s_nodeShards = 16;		///< Number of independently locked stripes of m_nodes.
+	static unsigned const s_verifierThreads = 2;	///< Threads recovering packet signatures.
+	static unsigned const s_verifyBatch = 64;		///< Most packets a verifier takes from the queue at once.
+	static unsigned const s_maxReceived = 4096;		///< Packets queued for verification beyond this are dropped.
 
 	/// Intervals
 
@@ -201,6 +214,20 @@ private:
 	{
 		unsigned distance;
 		std::list<std::weak_ptr<NodeEntry>> nodes;
+		mutable Mutex x_nodes;		///< Guards nodes. Never held while taking another bucket's or a shard's lock.
+	};
+
+	struct NodeShard
+	{
+		mutable Mutex x_nodes;		///< LOCK x_evictions first if both are required.
+		std::unordered_map<NodeID, std::shared_ptr<NodeEntry>> nodes;
+	};
+
+	/// A datagram waiting for its signature to be recovered.
+	struct ReceivedPacket
+	{
+		bi::udp::endpoint from;
+		bytes data;
 	};
 
 	/// Used to ping endpoint.
@@ -215,6 +242,10 @@ private:
 	/// Used by asynchronous operations to return NodeEntry which is active and managed by node table.
 	std::shared_ptr<NodeEntry> nodeEntry(NodeID _id);
 
+	/// Returns the stripe of m_nodes which holds @a _id.
+	NodeShard& nodeShard(NodeID const& _id) { return m_nodes[_id[0] % s_nodeShards]; }
+	NodeShard const& nodeShard(NodeID const& _id) const { return m_nodes[_id[0] % s_nodeShards]; }
+
 	/// Used to discovery nodes on network which are close to the given target.
 	/// Sends s_alpha concurrent requests to nodes nearest to target, for nodes nearest to target, up to s_maxSteps rounds.
 	void doDiscover(NodeID _target, unsigned _round = 0, std::shared_ptr<std::set<std::shared_ptr<NodeEntry>>> _tried = std::shared_ptr<std::set<std::shared_ptr<NodeEntry>>>());
@@ -232,15 +263,18 @@ private:
 	void dropNode(std::shared_ptr<NodeEntry> _n);
 
 	/// Returns references to bucket which corresponds to distance of node id.
-	/// @warning Only use the return reference locked x_state mutex.
+	/// @warning Only use the return reference with its x_nodes mutex locked.
 	// TODO p2p: Remove this method after removing offset-by-one functionality.
 	NodeBucket& bucket_UNSAFE(NodeEntry const* _n);
 
 	/// General Network Events
 
-	/// Called by m_socket when packet is received.
+	/// Called by m_socket when packet is received. Queues it for the verifiers.
 	void onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packet);
 
+	/// Verifies and handles a received packet. Called by the verifier threads.
+	void handleReceived(bi::udp::endpoint const& _from, bytesConstRef _packet);
+
 	/// Called by m_socket when socket is disconnected.
 	void onDisconnected(UDPSocketFace*) {}
 
@@ -252,26 +286,35 @@ private:
 	/// Looks up a random node at @c_bucketRefresh interval.
 	void doDiscovery();
 
+	/// Body of the verifier threads; handles queued packets in batches until m_verifying is cleared.
+	void verifyReceived();
+
 	std::unique_ptr<NodeTableEventHandler> m_nodeEventHandler;		///< Event handler for node events.
 
-	Node m_node;													///< This node. LOCK x_state if endpoint access or mutation is required. Do not modify id.
+	Node m_node;													///< This node. LOCK x_node if endpoint access or mutation is required. Do not modify id.
 	CommKeys::Secret m_secret;												///< This nodes secret key.
 
-	mutable Mutex x_nodes;											///< LOCK x_state first if both locks are required. Mutable for thread-safe copy in nodes() const.
-	std::unordered_map<NodeID, std::shared_ptr<NodeEntry>> m_nodes;	///< Known Node Endpoints
+	mutable Mutex x_node;											///< Guards m_node's endpoint.
+
+	std::array<NodeShard, s_nodeShards> m_nodes;					///< Known Node Endpoints, striped by node id.
 
-	mutable Mutex x_state;											///< LOCK x_state first if both x_nodes and x_state locks are required.
-	std::array<NodeBucket, s_bins> m_state;							///< State of p2p node network.
+	std::array<NodeBucket, s_bins> m_state;							///< State of p2p node network. Each bucket is locked on its own.
 
-	Mutex x_evictions;												///< LOCK x_evictions first if both x_nodes and x_evictions locks are required.
+	Mutex x_evictions;												///< LOCK x_evictions first if both a shard's x_nodes and x_evictions locks are required.
 	std::unordered_map<NodeID, EvictionTimeout> m_evictions;		///< Eviction timeouts.
 	
-	Mutex x_pubkDiscoverPings;										///< LOCK x_nodes first if both x_nodes and x_pubkDiscoverPings locks are required.
+	Mutex x_pubkDiscoverPings;
 	std::unordered_map<bi::address, TimePoint> m_pubkDiscoverPings;	///< List of pending pings where node entry wasn't created due to unkown pubk.
 
 	Mutex x_findNodeTimeout;
 	std::list<NodeIdTimePoint> m_findNodeTimeout;					///< Timeouts for FindNode requests.
 
+	Mutex x_received;
+	std::condition_variable m_receivedChanged;						///< Signalled when packets are queued or verification stops.
+	std::deque<ReceivedPacket> m_received;							///< Packets waiting for the verifiers.
+	bool m_verifying = true;										///< Cleared to stop the verifiers. LOCK x_received.
+	std::vector<std::thread> m_verifiers;
+
 	std::shared_ptr<NodeSocket> m_socket;							///< Shared pointer for our UDPSocket; ASIO requires shared_ptr.
 	NodeSocket* m_socketPointer;									///< Set to m_socket.get(). Socket is created in constructor and disconnected in destructor to ensure access to pointer is safe.
 
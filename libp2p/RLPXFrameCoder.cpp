@@ -49,11 +49,29 @@ namespace dev
 {
 namespace p2p
 {
+/// Running MAC of one direction of the connection.
+struct RLPXMacState
+{
+	CryptoPP::Keccak_256 keccak;	///< State used by RLPXCoderBackend::CryptoPP.
+	SHA3Sponge sponge;				///< State used by RLPXCoderBackend::Fused.
+	CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption macEnc;	///< Fused backend's own MAC cipher, so that the directions need not share a lock.
+};
+
 class RLPXFrameCoderImpl
 {
 public:
+	RLPXFrameCoderImpl(RLPXCoderBackend _backend): backend(_backend) {}
+
 	/// Update state of _mac.
-	void updateMAC(CryptoPP::Keccak_256& _mac, bytesConstRef _seed = {});
+	void updateMAC(RLPXMacState& _mac, bytesConstRef _seed = {});
+
+	/// Absorb _cipher into _mac.
+	void absorb(RLPXMacState& _mac, bytesConstRef _cipher);
+
+	/// @returns first 16 bytes of the current digest of _mac.
+	h128 digest(RLPXMacState& _mac);
+
+	RLPXCoderBackend const backend;
 
 	CryptoPP::SecByteBlock frameEncKey;						///< Key for m_frameEnc
 	CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption frameEnc;	///< Encoder for egress plaintext.
@@ -64,8 +82,8 @@ public:
 	CryptoPP::SecByteBlock macEncKey;						/// Key for m_macEnd
 	CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption macEnc;	/// One-way coder used by updateMAC for ingress and egress MAC updates.
 
-	CryptoPP::Keccak_256 egressMac;		///< State of MAC for egress ciphertext.
-	CryptoPP::Keccak_256 ingressMac;	///< State of MAC for ingress ciphertext.
+	RLPXMacState egressMac;		///< State of MAC for egress ciphertext.
+	RLPXMacState ingressMac;	///< State of MAC for ingress ciphertext.
 
 private:
 	Mutex x_macEnc;  ///< Mutex.
@@ -73,17 +91,19 @@ private:
 }
 }
 
+std::atomic<RLPXCoderBackend> RLPXFrameCoder::s_defaultBackend{RLPXCoderBackend::Fused};
+
 RLPXFrameCoder::~RLPXFrameCoder()
 {}
 
 RLPXFrameCoder::RLPXFrameCoder(RLPXHandshake const& _init):
-	m_impl(new RLPXFrameCoderImpl)
+	m_impl(new RLPXFrameCoderImpl(defaultBackend()))
 {
 	setup(_init.m_originated, _init.m_ecdheRemote, _init.m_remoteNonce, _init.m_ecdheLocal, _init.m_nonce, &_init.m_ackCipher, &_init.m_authCipher);
 }
 
-RLPXFrameCoder::RLPXFrameCoder(bool _originated, h512 const& _remoteEphemeral, h256 const& _remoteNonce, KeyPair<ECDSA> const& _ecdheLocal, h256 const& _nonce, bytesConstRef _ackCipher, bytesConstRef _authCipher):
-	m_impl(new RLPXFrameCoderImpl)
+RLPXFrameCoder::RLPXFrameCoder(bool _originated, h512 const& _remoteEphemeral, h256 const& _remoteNonce, KeyPair<ECDSA> const& _ecdheLocal, h256 const& _nonce, bytesConstRef _ackCipher, bytesConstRef _authCipher, RLPXCoderBackend _backend):
+	m_impl(new RLPXFrameCoderImpl(_backend))
 {
 	setup(_originated, _remoteEphemeral, _remoteNonce, _ecdheLocal, _nonce, _ackCipher, _authCipher);
 }
@@ -129,6 +149,8 @@ void RLPXFrameCoder::setup(bool _originated, h512 const& _remoteEphemeral, h256
 	m_impl->macEncKey.resize(h256::size);
 	memcpy(m_impl->macEncKey.data(), outRef.data(), h256::size);
 	m_impl->macEnc.SetKey(m_impl->macEncKey, h256::size);
+	m_impl->egressMac.macEnc.SetKey(m_impl->macEncKey, h256::size);
+	m_impl->ingressMac.macEnc.SetKey(m_impl->macEncKey, h256::size);
 
 	// Initiator egress-mac: sha3(mac-secret^recipient-nonce || auth-sent-init)
 	//           ingress-mac: sha3(mac-secret^initiator-nonce || auth-recvd-ack)
@@ -140,7 +162,7 @@ void RLPXFrameCoder::setup(bool _originated, h512 const& _remoteEphemeral, h256
 	keyMaterialBytes.resize(h256::size + egressCipher.size());
 	keyMaterial.retarget(keyMaterialBytes.data(), keyMaterialBytes.size());
 	egressCipher.copyTo(keyMaterial.cropped(h256::size, egressCipher.size()));
-	m_impl->egressMac.Update(keyMaterial.data(), keyMaterial.size());
+	m_impl->absorb(m_impl->egressMac, keyMaterial);
 
 	// recover mac-secret by re-xoring remoteNonce
 	(*(h256*)keyMaterial.data() ^ _remoteNonce ^ _nonce).ref().copyTo(keyMaterial);
@@ -148,7 +170,7 @@ void RLPXFrameCoder::setup(bool _originated, h512 const& _remoteEphemeral, h256
 	keyMaterialBytes.resize(h256::size + ingressCipher.size());
 	keyMaterial.retarget(keyMaterialBytes.data(), keyMaterialBytes.size());
 	ingressCipher.copyTo(keyMaterial.cropped(h256::size, ingressCipher.size()));
-	m_impl->ingressMac.Update(keyMaterial.data(), keyMaterial.size());
+	m_impl->absorb(m_impl->ingressMac, keyMaterial);
 }
 
 void RLPXFrameCoder::writeFrame(uint16_t _protocolType, bytesConstRef _payload, bytes& o_bytes)
@@ -210,6 +232,33 @@ void RLPXFrameCoder::writeSingleFramePacket(bytesConstRef _packet, bytes& o_byte
 	writeFrame(header, _packet, o_bytes);
 }
 
+void RLPXFrameCoder::appendSingleFramePacket(bytesConstRef _packet, bytes& io_bytes)
+{
+	uint32_t len = (uint32_t)_packet.size();
+	size_t padding = (16 - (len % 16)) % 16;
+	size_t start = io_bytes.size();
+	io_bytes.resize(start + h256::size + len + padding + h128::size);
+
+	// Same header as writeSingleFramePacket: 24-bit length and an empty protocol/sequence list, zero padded.
+	bytesRef header(io_bytes.data() + start, h128::size);
+	header[0] = byte((len >> 16) & 0xff);
+	header[1] = byte((len >> 8) & 0xff);
+	header[2] = byte(len & 0xff);
+	header[3] = 0xc2;
+	header[4] = 0x80;
+	header[5] = 0x80;
+	m_impl->frameEnc.ProcessData(header.data(), header.data(), h128::size);
+	updateEgressMACWithHeader(header);
+	egressDigest().ref().copyTo(bytesRef(io_bytes.data() + start + h128::size, h128::size));
+
+	bytesRef frame(io_bytes.data() + start + h256::size, len + padding);
+	m_impl->frameEnc.ProcessData(frame.data(), _packet.data(), len);
+	if (padding)
+		m_impl->frameEnc.ProcessData(frame.data() + len, frame.data() + len, padding);
+	updateEgressMACWithFrame(frame);
+	egressDigest().ref().copyTo(bytesRef(frame.data() + frame.size(), h128::size));
+}
+
 bool RLPXFrameCoder::authAndDecryptHeader(bytesRef io)
 {
 	asserts(io.size() == h256::size);
@@ -235,18 +284,12 @@ bool RLPXFrameCoder::authAndDecryptFrame(bytesRef io)
 
 h128 RLPXFrameCoder::egressDigest()
 {
-	CryptoPP::Keccak_256 h(m_impl->egressMac);
-	h128 digest;
-	h.TruncatedFinal(digest.data(), h128::size);
-	return digest;
+	return m_impl->digest(m_impl->egressMac);
 }
 
 h128 RLPXFrameCoder::ingressDigest()
 {
-	CryptoPP::Keccak_256 h(m_impl->ingressMac);
-	h128 digest;
-	h.TruncatedFinal(digest.data(), h128::size);
-	return digest;
+	return m_impl->digest(m_impl->ingressMac);
 }
 
 void RLPXFrameCoder::updateEgressMACWithHeader(bytesConstRef _headerCipher)
@@ -256,7 +299,7 @@ void RLPXFrameCoder::updateEgressMACWithHeader(bytesConstRef _headerCipher)
 
 void RLPXFrameCoder::updateEgressMACWithFrame(bytesConstRef _cipher)
 {
-	m_impl->egressMac.Update(_cipher.data(), _cipher.size());
+	m_impl->absorb(m_impl->egressMac, _cipher);
 	m_impl->updateMAC(m_impl->egressMac);
 }
 
@@ -267,29 +310,51 @@ void RLPXFrameCoder::updateIngressMACWithHeader(bytesConstRef _headerCipher)
 
 void RLPXFrameCoder::updateIngressMACWithFrame(bytesConstRef _cipher)
 {
-	m_impl->ingressMac.Update(_cipher.data(), _cipher.size());
+	m_impl->absorb(m_impl->ingressMac, _cipher);
 	m_impl->updateMAC(m_impl->ingressMac);
 }
 
-void RLPXFrameCoderImpl::updateMAC(CryptoPP::Keccak_256& _mac, bytesConstRef _seed)
+void RLPXFrameCoderImpl::absorb(RLPXMacState& _mac, bytesConstRef _cipher)
+{
+	if (backend == RLPXCoderBackend::Fused)
+		_mac.sponge.update(_cipher);
+	else
+		_mac.keccak.Update(_cipher.data(), _cipher.size());
+}
+
+h128 RLPXFrameCoderImpl::digest(RLPXMacState& _mac)
+{
+	h128 ret;
+	if (backend == RLPXCoderBackend::Fused)
+		_mac.sponge.peek(ret.ref());
+	else
+	{
+		CryptoPP::Keccak_256 h(_mac.keccak);
+		h.TruncatedFinal(ret.data(), h128::size);
+	}
+	return ret;
+}
+
+void RLPXFrameCoderImpl::updateMAC(RLPXMacState& _mac, bytesConstRef _seed)
 {
 	if (_seed.size() && _seed.size() != h128::size)
 		asserts(false);
 
-	CryptoPP::Keccak_256 prevDigest(_mac);
-	h128 encDigest(h128::size);
-	prevDigest.TruncatedFinal(encDigest.data(), h128::size);
-	h128 prevDigestOut = encDigest;
+	h128 prevDigestOut = digest(_mac);
+	h128 encDigest = prevDigestOut;
 
+	if (backend == RLPXCoderBackend::Fused)
+		_mac.macEnc.ProcessData(encDigest.data(), encDigest.data(), h128::size);
+	else
 	{
 		Guard l(x_macEnc);
-		macEnc.ProcessData(encDigest.data(), encDigest.data(), 16);
+		macEnc.ProcessData(encDigest.data(), encDigest.data(), h128::size);
 	}
 	if (_seed.size())
 		encDigest ^= *(h128*)_seed.data();
 	else
-		encDigest ^= *(h128*)prevDigestOut.data();
+		encDigest ^= prevDigestOut;
 
 	// update mac for final digest
-	_mac.Update(encDigest.data(), h128::size);
+	absorb(_mac, encDigest.ref());
 }
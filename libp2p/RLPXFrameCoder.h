@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <libdevcore/Guards.h>
 #include <libdevcrypto/CryptoPP.h>
@@ -58,6 +59,13 @@ struct RLPXFrameInfo
 
 class RLPXHandshake;
 
+/// Implementation used by RLPXFrameCoder for frame encryption and MAC updates. Both produce identical output.
+enum class RLPXCoderBackend
+{
+	CryptoPP,	///< Crypto++ Keccak_256 MACs, copied for every digest, sharing one locked MAC cipher.
+	Fused		///< In-place SHA3Sponge MACs with a MAC cipher per direction; no state copies or locking.
+};
+
 /**
  * @brief Encoder/decoder transport for RLPx connection established by RLPXHandshake.
  *
@@ -77,7 +85,11 @@ public:
 	RLPXFrameCoder(RLPXHandshake const& _init);
 	
 	/// Construct with external key material.
-    RLPXFrameCoder(bool _originated, h512 const& _remoteEphemeral, h256 const& _remoteNonce, KeyPair<ECDSA> const& _ecdheLocal, h256 const& _nonce, bytesConstRef _ackCipher, bytesConstRef _authCipher);
+    RLPXFrameCoder(bool _originated, h512 const& _remoteEphemeral, h256 const& _remoteNonce, KeyPair<ECDSA> const& _ecdheLocal, h256 const& _nonce, bytesConstRef _ackCipher, bytesConstRef _authCipher, RLPXCoderBackend _backend = defaultBackend());
+
+	/// Backend used by coders constructed from a handshake.
+	static RLPXCoderBackend defaultBackend() { return s_defaultBackend; }
+	static void setDefaultBackend(RLPXCoderBackend _backend) { s_defaultBackend = _backend; }
 	
 	~RLPXFrameCoder();
 	
@@ -96,6 +108,21 @@ public:
 	/// Legacy. Encrypt _packet as ill-defined legacy RLPx frame.
 	void writeSingleFramePacket(bytesConstRef _packet, bytes& o_bytes);
 
+	/// Legacy. As writeSingleFramePacket, but append the frame to io_bytes so that many packets share one buffer.
+	/// _packet must not point into io_bytes.
+	void appendSingleFramePacket(bytesConstRef _packet, bytes& io_bytes);
+
+	/// Legacy. Append the frames of all _packets to io_bytes, growing the buffer once for the whole batch.
+	template <class Packets> void appendSingleFramePackets(Packets const& _packets, bytes& io_bytes)
+	{
+		size_t size = io_bytes.size();
+		for (auto const& packet: _packets)
+			size += h256::size + packet.size() + (16 - packet.size() % 16) % 16 + h128::size;
+		io_bytes.reserve(size);
+		for (auto const& packet: _packets)
+			appendSingleFramePacket(&packet, io_bytes);
+	}
+
 	/// Authenticate and decrypt header in-place.
 	bool authAndDecryptHeader(bytesRef io_cipherWithMac);
 	
@@ -125,6 +152,8 @@ protected:
 
 private:
 	std::unique_ptr<class RLPXFrameCoderImpl> m_impl;
+
+	static std::atomic<RLPXCoderBackend> s_defaultBackend;
 };
 
 }
@@ -31,6 +31,10 @@ namespace p2p
 /**
  * @brief Shared pointer wrapper for ASIO TCP socket.
  *
+ * Completion handlers of the handshake and the session using the socket are
+ * wrapped in strand(), so that connections run in parallel when the io_service
+ * has several threads while each one's handlers stay serialised and in order.
+ *
  * Thread Safety
  * Distinct Objects: Safe.
  * Shared objects: Unsafe.
@@ -39,16 +43,18 @@ namespace p2p
 class RLPXSocket: public std::enable_shared_from_this<RLPXSocket>
 {
 public:
-	RLPXSocket(ba::io_service& _ioService): m_socket(_ioService) {}
+	RLPXSocket(ba::io_service& _ioService): m_socket(_ioService), m_strand(_ioService) {}
 	~RLPXSocket() { close(); }
 	
 	bool isConnected() const { return m_socket.is_open(); }
 	void close() { try { boost::system::error_code ec; m_socket.shutdown(bi::tcp::socket::shutdown_both, ec); if (m_socket.is_open()) m_socket.close(); } catch (...){} }
 	bi::tcp::endpoint remoteEndpoint() { boost::system::error_code ec; return m_socket.remote_endpoint(ec); }
 	bi::tcp::socket& ref() { return m_socket; }
+	ba::io_service::strand& strand() { return m_strand; }
 	
 protected:
 	bi::tcp::socket m_socket;
+	ba::io_service::strand m_strand;
 };
 
 }
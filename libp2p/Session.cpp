@@ -111,7 +111,7 @@ template <class T> vector<T> randomSelection(vector<T> const& _t, unsigned _n)
 	return ret;
 }
 
-bool Session::readPacket(uint16_t _capId, PacketType _t, RLP const& _r)
+bool Session::readPacket(uint16_t _capId, PacketType _t, RLP const& _r, SharedBytesRef const& _packet)
 {
 	m_lastReceived = chrono::steady_clock::now();
 	clog(NetRight) << _t << _r;
@@ -126,13 +126,13 @@ bool Session::readPacket(uint16_t _capId, PacketType _t, RLP const& _r)
 		{
 			for (auto const& i: m_capabilities)
 				if (i.second->c_protocolID == _capId)
-					return i.second->m_enabled ? i.second->interpret(_t, _r) : true;
+					return i.second->m_enabled ? i.second->interpretPacket(_t, _r, _packet) : true;
 		}
 		else
 		{
 			for (auto const& i: m_capabilities)
 				if (_t >= (int)i.second->m_idOffset && _t - i.second->m_idOffset < i.second->hostCapability()->messageCount())
-					return i.second->m_enabled ? i.second->interpret(_t - i.second->m_idOffset, _r) : true;
+					return i.second->m_enabled ? i.second->interpretPacket(_t - i.second->m_idOffset, _r, _packet) : true;
 		}
 
 		return false;
@@ -230,41 +230,52 @@ void Session::send(bytes&& _msg, uint16_t _protocolID)
 	{
 		DEV_GUARDED(x_framing)
 		{
-			doWrite = m_encFrames.empty();
 			auto f = getFraming(_protocolID);
 			if (!f)
 				return;
 
 			f->writer.enque(RLPXPacket(_protocolID, msg));
 			multiplexAll();
+			doWrite = !m_writing;
+			m_writing = true;
 		}
 
 		if (doWrite)
-			writeFrames();
+		{
+			// Start the write on the session's strand; runs inline when sending from one of its own handlers.
+			auto self(shared_from_this());
+			m_socket->strand().dispatch([this, self]() { writeFrames(); });
+		}
 	}
 	else
 	{
 		DEV_GUARDED(x_framing)
 		{
 			m_writeQueue.push_back(std::move(_msg));
-			doWrite = (m_writeQueue.size() == 1);
+			doWrite = !m_writing;
+			m_writing = true;
 		}
 
 		if (doWrite)
-			write();
+		{
+			auto self(shared_from_this());
+			m_socket->strand().dispatch([this, self]() { write(); });
+		}
 	}
 }
 
 void Session::write()
 {
-	bytes const* out = nullptr;
+	// Encrypt everything queued so far into one buffer and hand it to the socket in one go.
+	// Only the write chain touches m_writeBuffer, so it is safe to use outside the lock.
 	DEV_GUARDED(x_framing)
 	{
-		m_io->writeSingleFramePacket(&m_writeQueue[0], m_writeQueue[0]);
-		out = &m_writeQueue[0];
+		m_writeBuffer.clear();
+		m_io->appendSingleFramePackets(m_writeQueue, m_writeBuffer);
+		m_writeQueue.clear();
 	}
 	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(*out), [this, self](boost::system::error_code ec, std::size_t /*length*/)
+	ba::async_write(m_socket->ref(), ba::buffer(m_writeBuffer), m_socket->strand().wrap([this, self](boost::system::error_code ec, std::size_t /*length*/)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -277,28 +288,38 @@ void Session::write()
 		}
 
 		DEV_GUARDED(x_framing)
-		{
-			m_writeQueue.pop_front();
 			if (m_writeQueue.empty())
+			{
+				m_writing = false;
 				return;
-		}
+			}
 		write();
-	});
+	}));
 }
 
 void Session::writeFrames()
 {
-	bytes const* out = nullptr;
+	// Send every frame multiplexed so far with a single scatter-gather write.
 	DEV_GUARDED(x_framing)
 	{
 		if (m_encFrames.empty())
+		{
+			m_writing = false;
 			return;
-		else
-			out = &m_encFrames[0];
+		}
+		m_framesWriting.clear();
+		m_framesWriting.reserve(m_encFrames.size());
+		m_writeBuffers.clear();
+		for (auto& frame: m_encFrames)
+		{
+			m_framesWriting.push_back(move(frame));
+			m_writeBuffers.push_back(ba::buffer(m_framesWriting.back()));
+		}
+		m_encFrames.clear();
 	}
 
 	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(*out), [this, self](boost::system::error_code ec, std::size_t /*length*/)
+	ba::async_write(m_socket->ref(), m_writeBuffers, m_socket->strand().wrap([this, self](boost::system::error_code ec, std::size_t /*length*/)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -311,17 +332,9 @@ void Session::writeFrames()
 		}
 
 		DEV_GUARDED(x_framing)
-		{
-			if (!m_encFrames.empty())
-				m_encFrames.pop_front();
-
 			multiplexAll();
-			if (m_encFrames.empty())
-				return;
-		}
-
 		writeFrames();
-	});
+	}));
 }
 
 void Session::drop(DisconnectReason _reason)
@@ -379,7 +392,7 @@ void Session::doRead()
 
 	auto self(shared_from_this());
 	m_data.resize(h256::size);
-	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), [this,self](boost::system::error_code ec, std::size_t length)
+	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), m_socket->strand().wrap([this,self](boost::system::error_code ec, std::size_t length)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -412,7 +425,7 @@ void Session::doRead()
 		/// read padded frame and mac
 		auto tlen = hLength + hPadding + h128::size;
 		m_data.resize(tlen);
-		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), [this, self, hLength, hProtocolId, tlen](boost::system::error_code ec, std::size_t length)
+		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), m_socket->strand().wrap([this, self, hLength, hProtocolId, tlen](boost::system::error_code ec, std::size_t length)
 		{
 			ThreadContext tc(info().id.abridged());
 			ThreadContext tc2(info().clientVersion);
@@ -425,7 +438,9 @@ void Session::doRead()
 				return;
 			}
 
-			bytesConstRef frame(m_data.data(), hLength);
+			// Hand the decrypted buffer itself to the capabilities, so whatever they queue can share it.
+			SharedBytesRef packet(move(m_data));
+			bytesConstRef frame = packet.ref().cropped(0, hLength);
 			if (!checkPacket(frame))
 			{
 				cerr << "Received " << frame.size() << ": " << toHex(frame) << endl;
@@ -437,7 +452,7 @@ void Session::doRead()
 			{
 				auto packetType = (PacketType)RLP(frame.cropped(0, 1)).toInt<unsigned>();
 				RLP r(frame.cropped(1));
-				bool ok = readPacket(hProtocolId, packetType, r);
+				bool ok = readPacket(hProtocolId, packetType, r, packet);
 				(void)ok;
 #if ETH_DEBUG
 				if (!ok)
@@ -445,8 +460,8 @@ void Session::doRead()
 #endif
 			}
 			doRead();
-		});
-	});
+		}));
+	}));
 }
 
 bool Session::checkRead(std::size_t _expected, boost::system::error_code _ec, std::size_t _length)
@@ -483,7 +498,7 @@ void Session::doReadFrames()
 
 	auto self(shared_from_this());
 	m_data.resize(h256::size);
-	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), [this, self](boost::system::error_code ec, std::size_t length)
+	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), m_socket->strand().wrap([this, self](boost::system::error_code ec, std::size_t length)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -515,7 +530,7 @@ void Session::doReadFrames()
 		RLPXFrameInfo header(rawHeader);
 		auto tlen = header.length + header.padding + h128::size; // padded frame and mac
 		m_data.resize(tlen);
-		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), [this, self, tlen, header](boost::system::error_code ec, std::size_t length)
+		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), m_socket->strand().wrap([this, self, tlen, header](boost::system::error_code ec, std::size_t length)
 		{
 			ThreadContext tc(info().id.abridged());
 			ThreadContext tc2(info().clientVersion);
@@ -550,8 +565,8 @@ void Session::doReadFrames()
 				(void)ok;
 			}
 			doReadFrames();
-		});
-	});
+		}));
+	}));
 }
 
 std::shared_ptr<Session::Framing> Session::getFraming(uint16_t _protocolID)
@@ -32,6 +32,7 @@
 #include <libdevcore/Common.h>
 #include <libdevcore/RLP.h>
 #include <libdevcore/Guards.h>
+#include <libdevcore/SharedBytes.h>
 #include "RLPXFrameCoder.h"
 #include "RLPXSocket.h"
 #include "Common.h"
@@ -144,8 +145,8 @@ private:
 	void write();
 	void writeFrames();
 
-	/// Deliver RLPX packet to Session or Capability for interpretation.
-	bool readPacket(uint16_t _capId, PacketType _t, RLP const& _r);
+	/// Deliver RLPX packet to Session or Capability for interpretation. _r points into _packet when it is not empty.
+	bool readPacket(uint16_t _capId, PacketType _t, RLP const& _r, SharedBytesRef const& _packet = SharedBytesRef());
 
 	/// Interpret an incoming Session packet.
 	bool interpret(PacketType _t, RLP const& _r);
@@ -159,6 +160,10 @@ private:
 	std::shared_ptr<RLPXSocket> m_socket;		///< Socket of peer's connection.
 	Mutex x_framing;						///< Mutex for the write queue.
 	std::deque<bytes> m_writeQueue;			///< The write queue.
+	bool m_writing = false;					///< Whether a write is in flight; the next one starts from its completion handler.
+	bytes m_writeBuffer;					///< Encrypted packets of the write in flight. Reused, so steady-state writes do not allocate.
+	std::vector<bytes> m_framesWriting;		///< Encrypted frames of the write in flight.
+	std::vector<boost::asio::const_buffer> m_writeBuffers;	///< Buffer sequence over m_framesWriting.
 	std::vector<byte> m_data;			    ///< Buffer for ingress packet data.
 	bytes m_incoming;						///< Read buffer for ingress bytes.
 
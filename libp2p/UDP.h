@@ -33,6 +33,14 @@
 #include <libdevcore/Log.h>
 #include <libdevcore/RLP.h>
 #include "Common.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#define DEV_UDP_BATCH 1		///< recvmmsg/sendmmsg move several datagrams per system call.
+#endif
+
 namespace ba = boost::asio;
 namespace bi = ba::ip;
 
@@ -101,6 +109,9 @@ struct UDPSocketEvents
  * @brief UDP Interface
  * Handler must implement UDPSocketEvents.
  *
+ * On Linux, readiness is awaited through asio and then up to c_batchSize
+ * datagrams are moved with a single recvmmsg/sendmmsg call.
+ *
  * @todo multiple endpoints (we cannot advertise 0.0.0.0)
  * @todo decouple deque from UDPDatagram and add ref() to datagram for fire&forget
  */
@@ -111,6 +122,12 @@ public:
 	enum { maxDatagramSize = MaxDatagramSize };
 	static_assert((unsigned)maxDatagramSize < 65507u, "UDP datagrams cannot be larger than 65507 bytes");
 
+#if DEV_UDP_BATCH
+	static unsigned const c_batchSize = 32;		///< Most datagrams received or sent per system call.
+#else
+	static unsigned const c_batchSize = 1;
+#endif
+
 	/// Create socket for specific endpoint.
 	UDPSocket(ba::io_service& _io, UDPSocketEvents& _host, bi::udp::endpoint _endpoint): m_host(_host), m_endpoint(_endpoint), m_socket(_io) { m_started.store(false); m_closed.store(true); };
 
@@ -135,6 +152,14 @@ protected:
 
 	void doWrite();
 
+#if DEV_UDP_BATCH
+	/// Deliver the datagrams which can be read without blocking.
+	void receiveBatch();
+
+	/// Send as many datagrams from the front of m_sendQ as can be sent without blocking. LOCK x_sendQ.
+	void sendBatch();
+#endif
+
 	void disconnectWithError(boost::system::error_code _ec);
 
 	std::atomic<bool> m_started;					///< Atomically ensure connection is started once. Start cannot occur unless m_started is false. Managed by start and disconnectWithError.
@@ -145,8 +170,8 @@ protected:
 
 	Mutex x_sendQ;
 	std::deque<UDPDatagram> m_sendQ;				///< Queue for egress data.
-	std::array<byte, maxDatagramSize> m_recvData;	///< Buffer for ingress data.
-	bi::udp::endpoint m_recvEndpoint;				///< Endpoint data was received from.
+	std::array<std::array<byte, maxDatagramSize>, c_batchSize> m_recvData;	///< Buffers for ingress data.
+	std::array<bi::udp::endpoint, c_batchSize> m_recvEndpoints;			///< Endpoints data was received from.
 	bi::udp::socket m_socket;						///< Boost asio udp socket.
 
 	Mutex x_socketError;							///< Mutex for error which can be set from host or IO thread.
@@ -199,7 +224,20 @@ void UDPSocket<Handler, MaxDatagramSize>::doRead()
 		return;
 
 	auto self(UDPSocket<Handler, MaxDatagramSize>::shared_from_this());
-	m_socket.async_receive_from(boost::asio::buffer(m_recvData), m_recvEndpoint, [this, self](boost::system::error_code _ec, size_t _len)
+#if DEV_UDP_BATCH
+	m_socket.async_receive(boost::asio::null_buffers(), [this, self](boost::system::error_code _ec, size_t)
+	{
+		if (m_closed)
+			return disconnectWithError(_ec);
+
+		if (_ec != boost::system::errc::success)
+			clog(NetWarn) << "Receiving UDP message failed. " << _ec.value() << ":" << _ec.message();
+		else
+			receiveBatch();
+		doRead();
+	});
+#else
+	m_socket.async_receive_from(boost::asio::buffer(m_recvData[0]), m_recvEndpoints[0], [this, self](boost::system::error_code _ec, size_t _len)
 	{
 		if (m_closed)
 			return disconnectWithError(_ec);
@@ -208,10 +246,75 @@ void UDPSocket<Handler, MaxDatagramSize>::doRead()
 			clog(NetWarn) << "Receiving UDP message failed. " << _ec.value() << ":" << _ec.message();
 
 		if (_len)
-			m_host.onReceived(this, m_recvEndpoint, bytesConstRef(m_recvData.data(), _len));
+			m_host.onReceived(this, m_recvEndpoints[0], bytesConstRef(m_recvData[0].data(), _len));
 		doRead();
 	});
+#endif
+}
+
+#if DEV_UDP_BATCH
+template <typename Handler, unsigned MaxDatagramSize>
+void UDPSocket<Handler, MaxDatagramSize>::receiveBatch()
+{
+	std::array<mmsghdr, c_batchSize> messages;
+	std::array<iovec, c_batchSize> buffers;
+	for (unsigned i = 0; i < c_batchSize; ++i)
+	{
+		buffers[i].iov_base = m_recvData[i].data();
+		buffers[i].iov_len = maxDatagramSize;
+		messages[i] = mmsghdr();
+		messages[i].msg_hdr.msg_name = m_recvEndpoints[i].data();
+		messages[i].msg_hdr.msg_namelen = m_recvEndpoints[i].capacity();
+		messages[i].msg_hdr.msg_iov = &buffers[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int const received = ::recvmmsg(m_socket.native_handle(), messages.data(), c_batchSize, MSG_DONTWAIT, nullptr);
+	if (received < 0)
+	{
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			clog(NetWarn) << "Receiving UDP message failed. " << errno << ":" << strerror(errno);
+		return;
+	}
+
+	for (int i = 0; i < received; ++i)
+		if (messages[i].msg_len)
+		{
+			m_recvEndpoints[i].resize(messages[i].msg_hdr.msg_namelen);
+			m_host.onReceived(this, m_recvEndpoints[i], bytesConstRef(m_recvData[i].data(), messages[i].msg_len));
+		}
+}
+
+template <typename Handler, unsigned MaxDatagramSize>
+void UDPSocket<Handler, MaxDatagramSize>::sendBatch()
+{
+	unsigned const count = std::min<size_t>(m_sendQ.size(), c_batchSize);
+	std::array<mmsghdr, c_batchSize> messages;
+	std::array<iovec, c_batchSize> buffers;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		UDPDatagram const& datagram = m_sendQ[i];
+		buffers[i].iov_base = const_cast<byte*>(datagram.data.data());
+		buffers[i].iov_len = datagram.data.size();
+		messages[i] = mmsghdr();
+		messages[i].msg_hdr.msg_name = const_cast<sockaddr*>(datagram.endpoint().data());
+		messages[i].msg_hdr.msg_namelen = datagram.endpoint().size();
+		messages[i].msg_hdr.msg_iov = &buffers[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int sent = ::sendmmsg(m_socket.native_handle(), messages.data(), count, MSG_DONTWAIT);
+	if (sent < 0)
+	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
+		// Drop the datagram which failed, as the single-datagram path does.
+		clog(NetWarn) << "Failed delivering UDP message. " << errno << ":" << strerror(errno);
+		sent = 1;
+	}
+	m_sendQ.erase(m_sendQ.begin(), m_sendQ.begin() + sent);
 }
+#endif
 
 template <typename Handler, unsigned MaxDatagramSize>
 void UDPSocket<Handler, MaxDatagramSize>::doWrite()
@@ -219,8 +322,27 @@ void UDPSocket<Handler, MaxDatagramSize>::doWrite()
 	if (m_closed)
 		return;
 
-	const UDPDatagram& datagram = m_sendQ[0];
 	auto self(UDPSocket<Handler, MaxDatagramSize>::shared_from_this());
+#if DEV_UDP_BATCH
+	m_socket.async_send(boost::asio::null_buffers(), [this, self](boost::system::error_code _ec, std::size_t)
+	{
+		if (m_closed)
+			return disconnectWithError(_ec);
+
+		Guard l(x_sendQ);
+		if (_ec != boost::system::errc::success)
+		{
+			clog(NetWarn) << "Failed delivering UDP message. " << _ec.value() << ":" << _ec.message();
+			m_sendQ.pop_front();
+		}
+		else
+			sendBatch();
+		if (m_sendQ.empty())
+			return;
+		doWrite();
+	});
+#else
+	const UDPDatagram& datagram = m_sendQ[0];
 	bi::udp::endpoint endpoint(datagram.endpoint());
 	m_socket.async_send_to(boost::asio::buffer(datagram.data), endpoint, [this, self, endpoint](boost::system::error_code _ec, std::size_t)
 	{
@@ -236,6 +358,7 @@ void UDPSocket<Handler, MaxDatagramSize>::doWrite()
 			return;
 		doWrite();
 	});
+#endif
 }
 
 template <typename Handler, unsigned MaxDatagramSize>
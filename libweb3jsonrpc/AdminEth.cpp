@@ -41,6 +41,10 @@ Json::Value AdminEth::admin_eth_blockQueueStatus(string const& _session)
 	ret["future"] = (int)bqs.future;
 	ret["unknown"] = (int)bqs.unknown;
 	ret["bad"] = (int)bqs.bad;
+	ret["spilled"] = (int)bqs.spilled;
+	ret["knownBytes"] = (Json::UInt64)bqs.knownBytes;
+	ret["unknownBytes"] = (Json::UInt64)bqs.unknownBytes;
+	ret["spilledBytes"] = (Json::UInt64)bqs.spilledBytes;
 	return ret;
 }
 
@@ -0,0 +1,72 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Bounded admission of RPC requests into a fixed number of execution slots.
+ */
+
+#include "AdmissionGate.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::rpc;
+
+void AdmissionGate::configure(unsigned _slots, unsigned _queue, chrono::milliseconds _maxWait)
+{
+	{
+		Guard l(x_gate);
+		m_slots = _slots;
+		m_queue = _queue;
+		m_maxWait = _maxWait;
+	}
+	m_freed.notify_all();
+}
+
+bool AdmissionGate::enter(unsigned _weight)
+{
+	UniqueGuard l(x_gate);
+	if (!m_slots || m_running + clamp(_weight) <= m_slots)
+	{
+		m_running += clamp(_weight);
+		return true;
+	}
+	if (m_waiting >= m_queue)
+	{
+		++m_refused;
+		return false;
+	}
+
+	++m_waiting;
+	bool const freed = m_freed.wait_for(l, m_maxWait, [&]() { return !m_slots || m_running + clamp(_weight) <= m_slots; });
+	--m_waiting;
+	if (!freed)
+	{
+		++m_refused;
+		return false;
+	}
+	m_running += clamp(_weight);
+	return true;
+}
+
+void AdmissionGate::leave(unsigned _weight)
+{
+	{
+		Guard l(x_gate);
+		m_running -= clamp(_weight);
+	}
+	// A heavier waiter may need more than one slot back, so let every waiter look.
+	m_freed.notify_all();
+}
@@ -0,0 +1,89 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Bounded admission of RPC requests into a fixed number of execution slots.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <libdevcore/Guards.h>
+
+namespace dev
+{
+namespace rpc
+{
+
+/**
+ * @brief Lets at most a fixed number of requests run at once. Further requests wait in a bounded
+ * queue for at most a fixed time; anything beyond the queue, or waiting longer, is refused so the
+ * caller can answer immediately rather than tie up a connector thread.
+ * With no slots configured every request is admitted.
+ */
+class AdmissionGate
+{
+public:
+	/// @param _slots Requests allowed to run concurrently; zero means unlimited.
+	/// @param _queue Requests allowed to wait for a slot.
+	/// @param _maxWait Longest a request waits for a slot before it is refused.
+	void configure(unsigned _slots, unsigned _queue, std::chrono::milliseconds _maxWait);
+
+	/// Blocks until @a _weight slots are free, taking them all. A weight beyond the slot count takes every slot.
+	/// @returns false if the request is refused, in which case leave() must not be called.
+	bool enter(unsigned _weight = 1);
+	/// Frees the slots taken by a successful enter() of the same weight.
+	void leave(unsigned _weight = 1);
+
+	unsigned running() const { Guard l(x_gate); return m_running; }
+	unsigned waiting() const { Guard l(x_gate); return m_waiting; }
+	uint64_t refused() const { return m_refused; }
+
+private:
+	unsigned clamp(unsigned _weight) const { return m_slots ? std::min(_weight, m_slots) : _weight; }
+
+	mutable Mutex x_gate;
+	std::condition_variable m_freed;
+	unsigned m_slots = 0;
+	unsigned m_queue = 0;
+	std::chrono::milliseconds m_maxWait{0};
+	unsigned m_running = 0;
+	unsigned m_waiting = 0;
+	std::atomic<uint64_t> m_refused{0};
+};
+
+/// Holds AdmissionGate slots for its lifetime.
+class AdmissionTicket
+{
+public:
+	explicit AdmissionTicket(AdmissionGate& _gate, unsigned _weight = 1): m_gate(_gate), m_weight(_weight), m_admitted(_gate.enter(_weight)) {}
+	~AdmissionTicket() { if (m_admitted) m_gate.leave(m_weight); }
+	AdmissionTicket(AdmissionTicket const&) = delete;
+	AdmissionTicket& operator=(AdmissionTicket const&) = delete;
+
+	bool admitted() const { return m_admitted; }
+
+private:
+	AdmissionGate& m_gate;
+	unsigned m_weight;
+	bool m_admitted;
+};
+
+}
+}
@@ -0,0 +1,207 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  JSON-RPC 2.0 protocol handler executing the entries of a batch request concurrently.
+ */
+
+#include "BatchRequestHandler.h"
+#include "JsonWriter.h"
+#include <condition_variable>
+#include <set>
+#include <jsonrpccpp/common/errors.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/Log.h>
+#include <libethereum/ClientBase.h>
+
+using namespace std;
+using namespace jsonrpc;
+using namespace dev;
+using namespace dev::rpc;
+
+BatchRequestHandler::BatchRequestHandler(IProcedureInvokationHandler& _handler):
+	RpcProtocolServerV2(_handler)
+{
+}
+
+BatchRequestHandler::~BatchRequestHandler()
+{
+	stopWorkers();
+}
+
+void BatchRequestHandler::setBatchExecution(unsigned _threads, eth::Interface* _client)
+{
+	stopWorkers();
+	m_client = _client;
+	startWorkers(_threads);
+}
+
+void BatchRequestHandler::startWorkers(unsigned _threads)
+{
+	if (!_threads)
+		return;
+	m_ioService.reset();
+	m_work.reset(new boost::asio::io_service::work(m_ioService));
+	for (unsigned i = 0; i < _threads; ++i)
+		m_workers.emplace_back([this]()
+		{
+			setThreadName("rpcbatch");
+			m_ioService.run();
+		});
+}
+
+void BatchRequestHandler::stopWorkers()
+{
+	m_work.reset();
+	m_ioService.stop();
+	for (auto& w: m_workers)
+		w.join();
+	m_workers.clear();
+}
+
+namespace
+{
+
+thread_local bool t_refused = false;
+
+bool isExpensive(string const& _method)
+{
+	static set<string> const c_expensive = {
+		"eth_call", "eth_estimateGas", "eth_sendRawTransactions",
+		"eth_getLogs", "eth_getLogsEx", "eth_getFilterLogs", "eth_getFilterLogsEx"
+	};
+	return _method.compare(0, 6, "debug_") == 0 || c_expensive.count(_method);
+}
+
+}
+
+void BatchRequestHandler::setAdmission(RequestClass _class, unsigned _slots, unsigned _queue, chrono::milliseconds _maxWait)
+{
+	m_gates[unsigned(_class)].configure(_slots, _queue, _maxWait);
+}
+
+bool BatchRequestHandler::refusedOnThisThread()
+{
+	return t_refused;
+}
+
+RequestClass BatchRequestHandler::classify(Json::Value const& _request)
+{
+	if (_request.isArray())
+	{
+		for (auto const& entry: _request)
+			if (classify(entry) == RequestClass::Expensive)
+				return RequestClass::Expensive;
+		return RequestClass::Cheap;
+	}
+	if (_request.isObject() && _request["method"].isString() && isExpensive(_request["method"].asString()))
+		return RequestClass::Expensive;
+	return RequestClass::Cheap;
+}
+
+unsigned BatchRequestHandler::expensiveCount(Json::Value const& _request)
+{
+	if (!_request.isArray())
+		return classify(_request) == RequestClass::Expensive ? 1 : 0;
+	unsigned ret = 0;
+	for (auto const& entry: _request)
+		ret += expensiveCount(entry);
+	return ret;
+}
+
+void BatchRequestHandler::HandleRequest(string const& _request, string& _retValue)
+{
+	t_refused = false;
+	Json::Reader reader;
+	Json::Value request;
+	Json::Value response;
+	if (reader.parse(_request, request, false))
+	{
+		unsigned const expensive = expensiveCount(request);
+		AdmissionTicket ticket(m_gates[unsigned(expensive ? RequestClass::Expensive : RequestClass::Cheap)], max(expensive, 1u));
+		if (ticket.admitted())
+			HandleJsonRequest(request, response);
+		else
+		{
+			t_refused = true;
+			WrapError(request.isObject() ? request : Json::nullValue, c_errorServerBusy, "Server busy", response);
+		}
+	}
+	else
+		WrapError(Json::nullValue, Errors::ERROR_RPC_JSON_PARSE_ERROR, Errors::GetErrorMessage(Errors::ERROR_RPC_JSON_PARSE_ERROR), response);
+
+	if (response != Json::nullValue)
+	{
+		// Connector threads are long-lived, so each keeps one writer whose buffer grows to fit its responses,
+		// up to a limit.
+		thread_local JsonWriter t_writer;
+		_retValue = t_writer.write(response);
+		t_writer.trim();
+	}
+}
+
+void BatchRequestHandler::HandleJsonRequest(Json::Value const& _request, Json::Value& _response)
+{
+	if (!_request.isArray() || _request.empty())
+	{
+		RpcProtocolServerV2::HandleJsonRequest(_request, _response);
+		return;
+	}
+
+	shared_ptr<eth::ChainSnapshot const> snapshot = m_client ? m_client->snapshot() : nullptr;
+	vector<Json::Value> results(_request.size());
+	auto handleEntry = [&](unsigned _i)
+	{
+		try
+		{
+			eth::ScopedChainSnapshot pinned(snapshot);
+			if (_request[_i].isArray())
+				// Nested batches are not valid JSON-RPC 2.0.
+				WrapError(Json::nullValue, Errors::ERROR_RPC_INVALID_REQUEST, Errors::GetErrorMessage(Errors::ERROR_RPC_INVALID_REQUEST), results[_i]);
+			else
+				RpcProtocolServerV2::HandleJsonRequest(_request[_i], results[_i]);
+		}
+		catch (...)
+		{
+			results[_i] = Json::nullValue;
+			WrapError(_request[_i], Errors::ERROR_RPC_INTERNAL_ERROR, Errors::GetErrorMessage(Errors::ERROR_RPC_INTERNAL_ERROR), results[_i]);
+		}
+	};
+
+	if (m_workers.empty() || _request.size() == 1)
+		for (unsigned i = 0; i < _request.size(); ++i)
+			handleEntry(i);
+	else
+	{
+		Mutex x_remaining;
+		condition_variable done;
+		unsigned remaining = _request.size();
+		for (unsigned i = 0; i < _request.size(); ++i)
+			m_ioService.post([&, i]()
+			{
+				handleEntry(i);
+				Guard l(x_remaining);
+				if (!--remaining)
+					done.notify_all();
+			});
+		unique_lock<Mutex> l(x_remaining);
+		done.wait(l, [&]() { return !remaining; });
+	}
+
+	for (auto& r: results)
+		if (r != Json::nullValue)
+			_response.append(r);
+}
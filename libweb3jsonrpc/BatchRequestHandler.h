@@ -0,0 +1,101 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  JSON-RPC 2.0 protocol handler executing the entries of a batch request concurrently.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/asio/io_service.hpp>
+#include <jsonrpccpp/server/rpcprotocolserverv2.h>
+#include "AdmissionGate.h"
+
+namespace dev
+{
+namespace eth
+{
+class Interface;
+}
+
+namespace rpc
+{
+
+/// Requests are admitted separately per class so that heavy calls cannot crowd out cheap ones.
+enum class RequestClass
+{
+	Cheap,
+	Expensive
+};
+
+/// JSON-RPC error code sent when a request is refused for lack of capacity.
+int const c_errorServerBusy = -32005;
+
+/**
+ * @brief Drop-in replacement for the libjson-rpc-cpp V2 protocol handler.
+ * Single requests are handled exactly as before. The entries of a batch request are dispatched
+ * to a pool of worker threads and their responses reassembled in request order. If a client is
+ * attached, the chain head is pinned once per batch so that every entry sees the same block.
+ * Requests pass through one AdmissionGate per RequestClass before running, a batch taking one
+ * expensive slot for each expensive entry; refused requests are answered with c_errorServerBusy
+ * straight away.
+ */
+class BatchRequestHandler: public jsonrpc::RpcProtocolServerV2
+{
+public:
+	explicit BatchRequestHandler(jsonrpc::IProcedureInvokationHandler& _handler);
+	~BatchRequestHandler();
+
+	/// Run batch entries on @a _threads workers; zero runs them sequentially on the connector thread.
+	/// @param _client If given, every entry of a batch is answered against one snapshot of its chain.
+	/// @note Must not be called while requests are being handled.
+	void setBatchExecution(unsigned _threads, eth::Interface* _client);
+
+	/// Limit how many requests of class @a _class run at once; see AdmissionGate::configure.
+	/// A request waiting for a slot holds its connector thread, so with a fixed pool of those keep
+	/// the expensive slots and queue below its size.
+	/// @note Must not be called while requests are being handled.
+	void setAdmission(RequestClass _class, unsigned _slots, unsigned _queue, std::chrono::milliseconds _maxWait = std::chrono::seconds(2));
+
+	/// @returns true if the last request handled on the calling thread was refused for lack of capacity.
+	static bool refusedOnThisThread();
+	/// A batch is as expensive as its most expensive entry.
+	static RequestClass classify(Json::Value const& _request);
+	/// @returns the number of expensive requests in @a _request, counting each entry of a batch.
+	/// An expensive request takes that many slots, since a batch's entries run concurrently.
+	static unsigned expensiveCount(Json::Value const& _request);
+
+	/// Parses and dispatches as the base class does, but serialises the response with JsonWriter.
+	void HandleRequest(std::string const& _request, std::string& _retValue) override;
+	void HandleJsonRequest(Json::Value const& _request, Json::Value& _response) override;
+
+private:
+	void startWorkers(unsigned _threads);
+	void stopWorkers();
+
+	eth::Interface* m_client = nullptr;
+	AdmissionGate m_gates[2];
+	boost::asio::io_service m_ioService;
+	std::unique_ptr<boost::asio::io_service::work> m_work;
+	std::vector<std::thread> m_workers;
+};
+
+}
+}
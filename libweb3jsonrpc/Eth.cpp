@@ -45,6 +45,37 @@ const unsigned dev::SensibleHttpThreads = 1;
 const unsigned dev::SensibleHttpThreads = 4;
 #endif
 const unsigned dev::SensibleHttpPort = 8545;
+const unsigned dev::SensibleBatchThreads = 8;
+// Leave connector threads over for cheap calls while the expensive ones are busy.
+const unsigned dev::SensibleExpensiveRpcSlots = SensibleHttpThreads > 1 ? SensibleHttpThreads / 2 : 1;
+const unsigned dev::SensibleCheapRpcSlots = 64;
+const unsigned dev::SensibleRpcQueue = 64;
+
+namespace
+{
+
+char const* importResultName(ImportResult _r)
+{
+	switch (_r)
+	{
+	case ImportResult::Success: return "Success";
+	case ImportResult::UnknownParent: return "UnknownParent";
+	case ImportResult::FutureTimeKnown: return "FutureTimeKnown";
+	case ImportResult::FutureTimeUnknown: return "FutureTimeUnknown";
+	case ImportResult::AlreadyInChain: return "AlreadyInChain";
+	case ImportResult::AlreadyKnown: return "AlreadyKnown";
+	case ImportResult::Malformed: return "Malformed";
+	case ImportResult::OverbidGasPrice: return "OverbidGasPrice";
+	case ImportResult::BadChain: return "BadChain";
+	case ImportResult::ZeroSignature: return "ZeroSignature";
+	case ImportResult::NonceTooLow: return "NonceTooLow";
+	case ImportResult::InsufficientBalance: return "InsufficientBalance";
+	case ImportResult::Aborted: return "Aborted";
+	}
+	return "Unknown";
+}
+
+}
 
 Eth::Eth(eth::Interface& _eth, eth::AccountHolder& _ethAccounts):
 	m_eth(_eth),
@@ -340,6 +371,47 @@ string Eth::eth_sendRawTransaction(std::string const& _rlp)
 	}
 }
 
+Json::Value Eth::eth_sendRawTransactions(Json::Value const& _rlps)
+{
+	if (!_rlps.isArray())
+		BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
+
+	// Entries that are not even hex are answered as malformed without troubling the queue.
+	vector<bytes> txs;
+	vector<unsigned> index(_rlps.size(), unsigned(-1));
+	txs.reserve(_rlps.size());
+	for (unsigned i = 0; i < _rlps.size(); ++i)
+		if (_rlps[i].isString())
+		{
+			bytes tx = jsToBytes(_rlps[i].asString());
+			if (!tx.empty())
+			{
+				index[i] = txs.size();
+				txs.push_back(move(tx));
+			}
+		}
+
+	auto const results = client()->injectTransactions(move(txs));
+	Json::Value ret(Json::arrayValue);
+	for (unsigned i = 0; i < _rlps.size(); ++i)
+	{
+		Json::Value r;
+		if (index[i] == unsigned(-1))
+		{
+			r["hash"] = Json::nullValue;
+			r["result"] = importResultName(ImportResult::Malformed);
+		}
+		else
+		{
+			auto const& result = results[index[i]];
+			r["hash"] = result.second ? Json::Value(toJS(result.second)) : Json::nullValue;
+			r["result"] = importResultName(result.first);
+		}
+		ret.append(r);
+	}
+	return ret;
+}
+
 string Eth::eth_call(Json::Value const& _json, string const& _blockNumber)
 {
 	try
@@ -45,6 +45,10 @@ class Interface;
 }
 
 extern const unsigned SensibleHttpThreads;
+extern const unsigned SensibleBatchThreads;
+extern const unsigned SensibleExpensiveRpcSlots;
+extern const unsigned SensibleCheapRpcSlots;
+extern const unsigned SensibleRpcQueue;
 extern const unsigned SensibleHttpPort;
 
 }
@@ -119,6 +123,7 @@ public:
 	virtual std::string eth_signTransaction(Json::Value const& _transaction) override;
 	virtual Json::Value eth_inspectTransaction(std::string const& _rlp) override;
 	virtual std::string eth_sendRawTransaction(std::string const& _rlp) override;
+	virtual Json::Value eth_sendRawTransactions(Json::Value const& _rlps) override;
 	virtual bool eth_notePassword(std::string const&) override { return false; }
 	virtual Json::Value eth_syncing() override;
 	
@@ -62,6 +62,7 @@ namespace dev {
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_signTransaction", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_STRING, "param1",jsonrpc::JSON_OBJECT, NULL), &dev::rpc::EthFace::eth_signTransactionI);
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_inspectTransaction", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT, "param1",jsonrpc::JSON_STRING, NULL), &dev::rpc::EthFace::eth_inspectTransactionI);
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_sendRawTransaction", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_STRING, "param1",jsonrpc::JSON_STRING, NULL), &dev::rpc::EthFace::eth_sendRawTransactionI);
+                    this->bindAndAddMethod(jsonrpc::Procedure("eth_sendRawTransactions", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_ARRAY, "param1",jsonrpc::JSON_ARRAY, NULL), &dev::rpc::EthFace::eth_sendRawTransactionsI);
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_notePassword", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_BOOLEAN, "param1",jsonrpc::JSON_STRING, NULL), &dev::rpc::EthFace::eth_notePasswordI);
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_syncing", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT,  NULL), &dev::rpc::EthFace::eth_syncingI);
                     this->bindAndAddMethod(jsonrpc::Procedure("eth_estimateGas", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_STRING, "param1",jsonrpc::JSON_OBJECT, NULL), &dev::rpc::EthFace::eth_estimateGasI);
@@ -271,6 +272,10 @@ namespace dev {
                 {
                     response = this->eth_sendRawTransaction(request[0u].asString());
                 }
+                inline virtual void eth_sendRawTransactionsI(const Json::Value &request, Json::Value &response)
+                {
+                    response = this->eth_sendRawTransactions(request[0u]);
+                }
                 inline virtual void eth_notePasswordI(const Json::Value &request, Json::Value &response)
                 {
                     response = this->eth_notePassword(request[0u].asString());
@@ -332,6 +337,7 @@ namespace dev {
                 virtual std::string eth_signTransaction(const Json::Value& param1) = 0;
                 virtual Json::Value eth_inspectTransaction(const std::string& param1) = 0;
                 virtual std::string eth_sendRawTransaction(const std::string& param1) = 0;
+                virtual Json::Value eth_sendRawTransactions(const Json::Value& param1) = 0;
                 virtual bool eth_notePassword(const std::string& param1) = 0;
                 virtual Json::Value eth_syncing() = 0;
                 virtual std::string eth_estimateGas(const Json::Value& param1) = 0;
@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <string>
+#include <vector>
 #include <libdevcore/Guards.h>
 #include <libdevcore/Log.h>
 
@@ -31,7 +32,8 @@ using namespace std;
 using namespace jsonrpc;
 using namespace dev;
 
-int const c_bufferSize = 1024;
+/// Large enough that a bulk submission of thousands of transactions arrives in few reads.
+size_t const c_bufferSize = 64 * 1024;
 
 struct IpcSendChannel: public LogChannel { static const char* name() { return "I>"; } static const int verbosity = 10; };
 struct IpcReceiveChannel: public LogChannel { static const char* name() { return "I<"; } static const int verbosity = 10; };
@@ -73,30 +75,23 @@ template <class S> bool IpcServerBase<S>::StopListening()
 
 template <class S> bool IpcServerBase<S>::SendResponse(string const& _response, void* _addInfo)
 {
-	bool fullyWritten = false;
-	bool errorOccured = false;
 	S socket = (S)(reinterpret_cast<intptr_t>(_addInfo));
-	string toSend = _response;
-	do
+	// Large responses take several writes; carry on from where the last one stopped rather than copying the rest.
+	size_t sent = 0;
+	while (sent < _response.size())
 	{
-		size_t bytesWritten = Write(socket, toSend);
+		size_t bytesWritten = Write(socket, _response.data() + sent, _response.size() - sent);
 		if (bytesWritten == 0)
-			errorOccured = true;
-		else if (bytesWritten < toSend.size())
-		{
-			int len = toSend.size() - bytesWritten;
-			toSend = toSend.substr(bytesWritten + sizeof(char), len);
-		}
-		else
-			fullyWritten = true;
-	} while (!fullyWritten && !errorOccured);
+			break;
+		sent += bytesWritten;
+	}
 	cipcs << _response;
-	return fullyWritten && !errorOccured;
+	return sent == _response.size();
 }
 
 template <class S> void IpcServerBase<S>::GenerateResponse(S _connection)
 {
-	char buffer[c_bufferSize];
+	vector<char> buffer(c_bufferSize);
 	string request;
 	bool escape = false;
 	bool inString = false;
@@ -105,10 +100,10 @@ template <class S> void IpcServerBase<S>::GenerateResponse(S _connection)
 	size_t nbytes = 0;
 	do
 	{
-		nbytes = Read(_connection, buffer, c_bufferSize);
+		nbytes = Read(_connection, buffer.data(), buffer.size());
 		if (nbytes <= 0)
 			break;
-		request.append(buffer, nbytes);
+		request.append(buffer.data(), nbytes);
 		while (i < request.size())
 		{
 			char c = request[i];
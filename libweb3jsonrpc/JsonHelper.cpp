@@ -136,18 +136,32 @@ Json::Value toJson(dev::eth::Transaction const& _t, std::pair<h256, unsigned> _l
 	return res;
 }
 
+namespace
+{
+Json::Value hashesToJson(h256s const& _hashes)
+{
+	Json::Value res(Json::arrayValue);
+	res.resize(_hashes.size());
+	for (unsigned i = 0; i < _hashes.size(); i++)
+		res[i] = toJS(_hashes[i]);
+	return res;
+}
+}
+
 Json::Value toJson(dev::eth::BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, Transactions const& _ts, SealEngineFace* _face)
 {
 	Json::Value res = toJson(_bi, _face);
 	if (_bi)
 	{
 		res["totalDifficulty"] = toJS(_bd.totalDifficulty);
-		res["uncles"] = Json::Value(Json::arrayValue);
-		for (h256 h: _us)
-			res["uncles"].append(toJS(h));
-		res["transactions"] = Json::Value(Json::arrayValue);
+		res["uncles"] = hashesToJson(_us);
+		// Build each entry in place; append() would deep-copy every transaction object.
+		Json::Value& transactions = res["transactions"] = Json::Value(Json::arrayValue);
+		transactions.resize(_ts.size());
+		h256 const blockHash = _bi.hash();
+		BlockNumber const blockNumber = (BlockNumber)_bi.number();
 		for (unsigned i = 0; i < _ts.size(); i++)
-			res["transactions"].append(toJson(_ts[i], std::make_pair(_bi.hash(), i), (BlockNumber)_bi.number()));
+			toJson(_ts[i], std::make_pair(blockHash, i), blockNumber).swap(transactions[i]);
 	}
 	return res;
 }
@@ -158,12 +172,8 @@ Json::Value toJson(dev::eth::BlockHeader const& _bi, BlockDetails const& _bd, Un
 	if (_bi)
 	{
 		res["totalDifficulty"] = toJS(_bd.totalDifficulty);
-		res["uncles"] = Json::Value(Json::arrayValue);
-		for (h256 h: _us)
-			res["uncles"].append(toJS(h));
-		res["transactions"] = Json::Value(Json::arrayValue);
-		for (h256 const& t: _ts)
-			res["transactions"].append(toJS(t));
+		res["uncles"] = hashesToJson(_us);
+		res["transactions"] = hashesToJson(_ts);
 	}
 	return res;
 }
@@ -98,8 +98,9 @@ template <class T>
 Json::Value toJson(std::vector<T> const& _es)
 {
 	Json::Value res(Json::arrayValue);
-	for (auto const& e: _es)
-		res.append(toJson(e));
+	res.resize(_es.size());
+	for (unsigned i = 0; i < _es.size(); ++i)
+		toJson(_es[i]).swap(res[i]);
 	return res;
 }
 
@@ -0,0 +1,117 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Compact JSON serialiser for RPC responses.
+ */
+
+#include "JsonWriter.h"
+
+using namespace std;
+using namespace dev::rpc;
+
+const size_t JsonWriter::c_retainedCapacity;
+
+string const& JsonWriter::write(Json::Value const& _value)
+{
+	m_buffer.clear();
+	writeValue(_value);
+	m_buffer += '\n';
+	return m_buffer;
+}
+
+void JsonWriter::trim()
+{
+	if (m_buffer.capacity() > c_retainedCapacity)
+		string().swap(m_buffer);
+}
+
+void JsonWriter::writeValue(Json::Value const& _value)
+{
+	switch (_value.type())
+	{
+	case Json::nullValue:
+		m_buffer += "null";
+		break;
+	case Json::intValue:
+		m_buffer += Json::valueToString(_value.asLargestInt());
+		break;
+	case Json::uintValue:
+		m_buffer += Json::valueToString(_value.asLargestUInt());
+		break;
+	case Json::realValue:
+		m_buffer += Json::valueToString(_value.asDouble());
+		break;
+	case Json::stringValue:
+	{
+		char const* begin;
+		char const* end;
+		if (_value.getString(&begin, &end))
+			writeString(begin, end);
+		else
+			m_buffer += "\"\"";
+		break;
+	}
+	case Json::booleanValue:
+		m_buffer += _value.asBool() ? "true" : "false";
+		break;
+	case Json::arrayValue:
+	{
+		m_buffer += '[';
+		Json::ArrayIndex const size = _value.size();
+		for (Json::ArrayIndex i = 0; i < size; ++i)
+		{
+			if (i)
+				m_buffer += ',';
+			writeValue(_value[i]);
+		}
+		m_buffer += ']';
+		break;
+	}
+	case Json::objectValue:
+	{
+		m_buffer += '{';
+		for (auto it = _value.begin(); it != _value.end(); ++it)
+		{
+			if (it != _value.begin())
+				m_buffer += ',';
+			char const* end;
+			char const* begin = it.memberName(&end);
+			writeString(begin, end);
+			m_buffer += ':';
+			writeValue(*it);
+		}
+		m_buffer += '}';
+		break;
+	}
+	}
+}
+
+void JsonWriter::writeString(char const* _begin, char const* _end)
+{
+	for (char const* p = _begin; p != _end; ++p)
+		if (*p < 0x20 || *p > 0x7e || *p == '"' || *p == '\\')
+		{
+			// Escaping rules (notably for non-ASCII) differ between jsoncpp releases; match whichever is linked.
+			Json::FastWriter w;
+			string const quoted = w.write(Json::Value(_begin, _end));
+			m_buffer.append(quoted, 0, quoted.size() - 1);
+			return;
+		}
+	m_buffer += '"';
+	m_buffer.append(_begin, _end);
+	m_buffer += '"';
+}
@@ -0,0 +1,58 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Compact JSON serialiser for RPC responses.
+ */
+
+#pragma once
+
+#include <string>
+#include <json/json.h>
+
+namespace dev
+{
+namespace rpc
+{
+
+/**
+ * @brief Writes a Json::Value byte-for-byte as Json::FastWriter does, but into a buffer that is reused
+ * across calls and without the per-node temporaries FastWriter builds. Responses are dominated by short
+ * hex strings that need no escaping, which are copied straight through; anything else defers to jsoncpp.
+ * Not thread-safe: keep one writer per thread.
+ */
+class JsonWriter
+{
+public:
+	/// Largest buffer kept between responses; an occasional huge one shouldn't pin its memory to the thread.
+	static const size_t c_retainedCapacity = 1024 * 1024;
+
+	/// @returns @a _value serialised, including the trailing newline. Valid until the next call or trim().
+	std::string const& write(Json::Value const& _value);
+	/// Frees the buffer if it has grown beyond c_retainedCapacity. Call once done with the last result.
+	void trim();
+
+	size_t capacity() const { return m_buffer.capacity(); }
+
+private:
+	void writeValue(Json::Value const& _value);
+	void writeString(char const* _begin, char const* _end);
+
+	std::string m_buffer;
+};
+
+}
+}
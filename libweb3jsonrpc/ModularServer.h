@@ -30,7 +30,7 @@
 #include <jsonrpccpp/common/procedure.h>
 #include <jsonrpccpp/server/iprocedureinvokationhandler.h>
 #include <jsonrpccpp/server/abstractserverconnector.h>
-#include <jsonrpccpp/server/requesthandlerfactory.h>
+#include "BatchRequestHandler.h"
 
 template <class I> using AbstractMethodPointer = void(I::*)(Json::Value const& _parameter, Json::Value& _result);
 template <class I> using AbstractNotificationPointer = void(I::*)(Json::Value const& _parameter);
@@ -69,7 +69,7 @@ class ModularServer: public jsonrpc::IProcedureInvokationHandler
 {
 public:
 	ModularServer()
-	: m_handler(jsonrpc::RequestHandlerFactory::createProtocolHandler(jsonrpc::JSONRPC_SERVER_V2, *this))
+	: m_handler(new dev::rpc::BatchRequestHandler(*this))
 	{
 		m_handler->AddProcedure(jsonrpc::Procedure("rpc_modules", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT, NULL));
 		m_implementedModules = Json::objectValue;
@@ -119,9 +119,21 @@ public:
 		return m_connectors.at(_i).get();
 	}
 
+	/// Execute the entries of batch requests on @a _threads threads, each against the chain
+	/// snapshot of @a _client taken when the batch arrived. Call before StartListening().
+	void setBatchExecution(unsigned _threads, dev::eth::Interface* _client)
+	{
+		m_handler->setBatchExecution(_threads, _client);
+	}
+
+	void setAdmission(dev::rpc::RequestClass _class, unsigned _slots, unsigned _queue)
+	{
+		m_handler->setAdmission(_class, _slots, _queue);
+	}
+
 protected:
 	std::vector<std::unique_ptr<jsonrpc::AbstractServerConnector>> m_connectors;
-	std::unique_ptr<jsonrpc::IProtocolHandler> m_handler;
+	std::unique_ptr<dev::rpc::BatchRequestHandler> m_handler;
 	/// Mapping for implemented modules, to be filled by subclasses during construction.
 	Json::Value m_implementedModules;
 };
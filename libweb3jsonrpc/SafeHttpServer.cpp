@@ -23,6 +23,7 @@
 #include <microhttpd.h>
 #include <sstream>
 #include "SafeHttpServer.h"
+#include "BatchRequestHandler.h"
 using namespace std;
 using namespace dev;
 
@@ -48,7 +49,16 @@ bool SafeHttpServer::SendResponse(string const& _response, void* _addInfo)
 	MHD_add_response_header(result, "Content-Type", "application/json");
 	MHD_add_response_header(result, "Access-Control-Allow-Origin", m_allowedOrigin.c_str());
 
-	int ret = MHD_queue_response(client_connection->connection, client_connection->code, result);
+	// The response is produced on this connection's thread, so a refusal by the handler is visible here.
+	// The connection itself is kept alive; the client only has to retry the request.
+	int code = client_connection->code;
+	if (rpc::BatchRequestHandler::refusedOnThisThread())
+	{
+		code = MHD_HTTP_SERVICE_UNAVAILABLE;
+		MHD_add_response_header(result, "Retry-After", "1");
+	}
+
+	int ret = MHD_queue_response(client_connection->connection, code, result);
 	MHD_destroy_response(result);
 	return ret == MHD_YES;
 }
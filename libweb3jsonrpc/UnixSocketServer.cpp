@@ -130,9 +130,9 @@ void UnixDomainSocketServer::CloseConnection(int _socket)
 }
 
 
-size_t UnixDomainSocketServer::Write(int _connection, string const& _data)
+size_t UnixDomainSocketServer::Write(int _connection, char const* _data, size_t _size)
 {
-	ssize_t r = send(_connection, _data.data(), _data.size(), MSG_NOSIGNAL);
+	ssize_t r = send(_connection, _data, _size, MSG_NOSIGNAL);
 	if (r < 0)
 		return 0;
 	return static_cast<size_t>(r);
@@ -41,7 +41,7 @@ public:
 protected:
 	void Listen() override;
 	void CloseConnection(int _socket) override;
-	size_t Write(int _connection, std::string const& _data) override;
+	size_t Write(int _connection, char const* _data, size_t _size) override;
 	size_t Read(int _connection, void* _data, size_t _size) override;
 
 	sockaddr_un m_address;
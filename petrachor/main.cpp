@@ -35,6 +35,9 @@
 #include <libevm/VMFactory.h>
 #include <libethcore/KeyManager.h>
 #include <libethereum/Defaults.h>
+#include <libethereum/PercentileGasPricer.h>
+#include <libethereum/SnapshotDownloader.h>
+#include <libethereum/SnapshotExporter.h>
 #include <libethereum/SnapshotImporter.h>
 #include <libethereum/SnapshotStorage.h>
 #include <libethashseal/EthashClient.h>
@@ -98,6 +101,11 @@ void help()
 		<< "    --no-ipc  Disable IPC server.\n"
 		<< "    --json-rpc-port <n>  Specify JSON-RPC server port (implies '-j', default: " << SensibleHttpPort << ").\n"
 		<< "    --rpccorsdomain <domain>  Domain on which to send Access-Control-Allow-Origin header.\n"
+		<< "    --rpc-batch-threads <n>  Number of threads executing the entries of JSON-RPC batch requests (default: " << SensibleBatchThreads << ").\n"
+		<< "    --rpc-threads <n>  Number of threads serving JSON-RPC HTTP connections (default: " << SensibleHttpThreads << ").\n"
+		<< "    --rpc-expensive-slots <n>  Number of expensive JSON-RPC calls (eth_call, eth_getLogs, debug_*...) run at once; 0 for no limit. Over HTTP, at most one less than --rpc-threads (default: " << SensibleExpensiveRpcSlots << ").\n"
+		<< "    --rpc-cheap-slots <n>  Number of other JSON-RPC calls run at once; 0 for no limit (default: " << SensibleCheapRpcSlots << ").\n"
+		<< "    --rpc-queue <n>  Number of JSON-RPC calls of either kind waiting for a slot before further ones are refused. Over HTTP, expensive calls only wait on connector threads left spare (default: " << SensibleRpcQueue << ").\n"
 		<< "    --admin <password>  Specify admin session key for JSON-RPC (default: auto-generated and printed at start-up).\n"
 		<< "    -K,--kill  Kill the blockchain first.\n"
 		<< "    -R,--rebuild  Rebuild the blockchain from the existing database.\n"
@@ -109,6 +117,7 @@ void help()
 		<< "Client transacting:\n"
 		<< "    --ask <wei>  Set the minimum ask gas price under which no transaction will be mined (default " << toString(DefaultGasPrice) << " ).\n"
 		<< "    --bid <wei>  Set the bid gas price to pay for transactions (default " << toString(DefaultGasPrice) << " ).\n"
+		<< "    --bid-blocks <n>  Bid the gas prices paid over the last n blocks, falling back to --bid (default: off).\n"
 		<< "    --unsafe-transactions  Allow all transactions to proceed without verification. EXTREMELY UNSAFE.\n\n"
 		<< "Client mining:\n"
 		<< "    -a,--address <addr>  Set the author (mining payout) address to given address (default: auto).\n"
@@ -122,6 +131,12 @@ void help()
 		<< "    --no-bootstrap  Do not connect to the default Petrachor peer servers (default only when --no-discovery is used).\n"
 		<< "    -x,--peers <number>  Attempt to connect to a given number of peers (default: 11).\n"
 		<< "    --peer-stretch <number>  Give the accepted connection multiplier (default: 7).\n"
+		<< "    --p2p-threads <n>  Number of threads running network IO and peer message handling (default: 4).\n"
+		<< "    --serve-snapshot <path>  Serve the snapshot in the given directory to peers.\n"
+		<< "    --download-snapshot <path>  Fetch a snapshot from peers into the given directory and import it before syncing blocks.\n"
+		<< "    --snapshot-block <hash>  Only download a snapshot of the block with the given hash.\n"
+		<< "    --snapshot-peers <n>  Without --snapshot-block, download a snapshot once n peers offer the same one (default: " << SnapshotDownloader::c_defaultAgreeingPeers << ").\n"
+		<< "    --export-snapshot <path>  Write a snapshot of the current head block into the given directory and exit.\n"
 
 		<< "    --public-ip <ip>  Force advertised public IP to the given IP (default: auto).\n"
 		<< "    --listen-ip <ip>(:<port>)  Listen on the given IP for incoming connections (default: 0.0.0.0).\n"
@@ -252,6 +267,7 @@ enum class OperationMode
 	Node,
 	Import,
 	ImportSnapshot,
+	ExportSnapshot,
 	Export
 };
 
@@ -328,6 +344,12 @@ int main(int argc, char** argv)
 
 	/// File name for import/export.
 	string filename;
+
+	/// Snapshot directories shared with and fetched from peers.
+	string serveSnapshotPath;
+	string downloadSnapshotPath;
+	h256 snapshotBlockHash;
+	unsigned snapshotPeers = SnapshotDownloader::c_defaultAgreeingPeers;
 	bool safeImport = false;
 
 	/// Hashes/numbers for export range.
@@ -342,6 +364,11 @@ int main(int argc, char** argv)
 	bool adminViaHttp = false;
 	bool ipc = true;
 	std::string rpcCorsDomain = "";
+	unsigned rpcBatchThreads = SensibleBatchThreads;
+	unsigned rpcThreads = SensibleHttpThreads;
+	unsigned rpcExpensiveSlots = SensibleExpensiveRpcSlots;
+	unsigned rpcCheapSlots = SensibleCheapRpcSlots;
+	unsigned rpcQueue = SensibleRpcQueue;
 
 	string jsonAdmin;
 	ChainParams chainParams;
@@ -361,6 +388,7 @@ int main(int argc, char** argv)
 
 	unsigned peers = 11;
 	unsigned peerStretch = 7;
+	unsigned p2pThreads = 4;
 	std::map<NodeID, pair<NodeIPEndpoint,bool>> preferredNodes;
 	bool bootstrap = true;
 	bool disableDiscovery = false;
@@ -382,6 +410,7 @@ int main(int argc, char** argv)
 //	double blockFees = 15.0;
 	u256 askPrice = DefaultGasPrice;
 	u256 bidPrice = DefaultGasPrice;
+	unsigned bidBlocks = 0;
 	bool alwaysConfirm = true;
 
 	/// Wallet password stuff
@@ -635,6 +664,18 @@ int main(int argc, char** argv)
 				return -1;
 			}
 		}
+		else if (arg == "--bid-blocks" && i + 1 < argc)
+		{
+			try
+			{
+				bidBlocks = stoul(argv[++i]);
+			}
+			catch (...)
+			{
+				cerr << "Bad " << arg << " option: " << argv[i] << "\n";
+				return -1;
+			}
+		}
 		else if ((arg == "-m" || arg == "--mining") && i + 1 < argc)
 		{
 			string m = argv[++i];
@@ -679,6 +720,16 @@ int main(int argc, char** argv)
 			jsonRPCURL = atoi(argv[++i]);
 		else if (arg == "--rpccorsdomain" && i + 1 < argc)
 			rpcCorsDomain = argv[++i];
+		else if (arg == "--rpc-batch-threads" && i + 1 < argc)
+			rpcBatchThreads = atoi(argv[++i]);
+		else if (arg == "--rpc-threads" && i + 1 < argc)
+			rpcThreads = max(1, atoi(argv[++i]));
+		else if (arg == "--rpc-expensive-slots" && i + 1 < argc)
+			rpcExpensiveSlots = atoi(argv[++i]);
+		else if (arg == "--rpc-cheap-slots" && i + 1 < argc)
+			rpcCheapSlots = atoi(argv[++i]);
+		else if (arg == "--rpc-queue" && i + 1 < argc)
+			rpcQueue = atoi(argv[++i]);
 		else if (arg == "--json-admin" && i + 1 < argc)
 			jsonAdmin = argv[++i];
 		else if (arg == "--ipc")
@@ -692,6 +743,24 @@ int main(int argc, char** argv)
 			peers = atoi(argv[++i]);
 		else if (arg == "--peer-stretch" && i + 1 < argc)
 			peerStretch = atoi(argv[++i]);
+		else if (arg == "--p2p-threads" && i + 1 < argc)
+			p2pThreads = max(1, atoi(argv[++i]));
+		else if (arg == "--serve-snapshot" && i + 1 < argc)
+			serveSnapshotPath = argv[++i];
+		else if (arg == "--download-snapshot" && i + 1 < argc)
+			downloadSnapshotPath = argv[++i];
+		else if (arg == "--snapshot-block" && i + 1 < argc)
+		{
+			bytes const hash = fromHex(argv[++i]);
+			if (hash.size() != h256::size)
+			{
+				cerr << "Bad " << arg << " option: " << argv[i] << "\n";
+				return -1;
+			}
+			snapshotBlockHash = h256(hash);
+		}
+		else if (arg == "--snapshot-peers" && i + 1 < argc)
+			snapshotPeers = max(1, atoi(argv[++i]));
 		else if (arg == "--peerset" && i + 1 < argc)
 		{
 			string peerset = argv[++i];
@@ -798,6 +867,11 @@ int main(int argc, char** argv)
 			mode = OperationMode::ImportSnapshot;
 			filename = argv[++i];
 		}
+		else if (arg == "--export-snapshot" && i + 1 < argc)
+		{
+			mode = OperationMode::ExportSnapshot;
+			filename = argv[++i];
+		}
 		else
 		{
 			cerr << "Invalid argument: " << arg << "\n";
@@ -928,6 +1002,7 @@ int main(int argc, char** argv)
 	auto netPrefs = publicIP.empty() ? NetworkPreferences(listenIP, listenPort, upnp) : NetworkPreferences(publicIP, listenIP ,listenPort, upnp);
 	netPrefs.discovery = (privateChain.empty() && !disableDiscovery) || enableDiscovery;
 	netPrefs.pin = (pinning || !privateChain.empty()) && !noPinning;
+	netPrefs.ioThreads = p2pThreads;
 
 	auto nodesState = contents(getDataDir() / fs::path("network.rlp"));
 	auto caps = useWhisper ? set<string>{"eth", "shh"} : set<string>{"eth"};
@@ -1098,11 +1173,27 @@ int main(int argc, char** argv)
 		}
 	}
 
+	if (mode == OperationMode::ExportSnapshot)
+	{
+		try
+		{
+			h256 const head = web3.ethereum()->blockChain().currentHash();
+			web3.ethereum()->createSnapshotExporter()->exportSnapshot(head, filename);
+			cout << "Exported snapshot of block " << head << " to " << filename << "\n";
+			return 0;
+		}
+		catch (...)
+		{
+			cerr << "Error during exporting the snapshot: " << boost::current_exception_diagnostic_information() << endl;
+			return -1;
+		}
+	}
+
 
 	web3.setIdealPeerCount(peers);
 	web3.setPeerStretch(peerStretch);
 //	std::shared_ptr<eth::BasicGasPricer> gasPricer = make_shared<eth::BasicGasPricer>(u256(double(ether / 1000) / etherPrice), u256(blockFees * 1000));
-	std::shared_ptr<eth::TrivialGasPricer> gasPricer = make_shared<eth::TrivialGasPricer>(askPrice, bidPrice);
+	std::shared_ptr<eth::TrivialGasPricer> gasPricer = bidBlocks ? make_shared<eth::PercentileGasPricer>(bidBlocks, askPrice, bidPrice) : make_shared<eth::TrivialGasPricer>(askPrice, bidPrice);
 	eth::Client* c = nodeMode == NodeMode::Full ? web3.ethereum() : nullptr;
 	if (c)
 	{
@@ -1129,6 +1220,28 @@ int main(int argc, char** argv)
 	else
 		cout << "Networking disabled. To start, use netstart or pass --bootstrap or a remote host.\n";
 
+	if (c && !serveSnapshotPath.empty())
+		c->setSnapshotStorage(createSnapshotStorage(serveSnapshotPath));
+
+	if (c && !downloadSnapshotPath.empty())
+	{
+		auto downloader = make_shared<SnapshotDownloader>(downloadSnapshotPath, snapshotBlockHash, snapshotPeers);
+		try
+		{
+			c->setSnapshotDownloader(downloader);
+			auto stateImporter = c->createStateImporter();
+			auto blockChainImporter = c->createBlockChainImporter();
+			SnapshotImporter importer(*stateImporter, *blockChainImporter);
+			importer.import(*downloader);
+			c->setSnapshotDownloader(nullptr);
+		}
+		catch (...)
+		{
+			cerr << "Error during downloading the snapshot: " << boost::current_exception_diagnostic_information() << endl;
+			return -1;
+		}
+	}
+
 	unique_ptr<ModularServer<>> jsonrpcHttpServer;
 	unique_ptr<ModularServer<>> jsonrpcIpcServer;
 	unique_ptr<rpc::SessionManager> sessionManager;
@@ -1199,7 +1312,15 @@ int main(int argc, char** argv)
 				new rpc::Debug(*web3.ethereum()),
 				testEth
 			));
-			auto httpConnector = new SafeHttpServer(jsonRPCURL, "", "", SensibleHttpThreads);
+			jsonrpcHttpServer->setBatchExecution(rpcBatchThreads, web3.ethereum());
+			// A request waiting for a slot holds one of the connector threads, so expensive calls may only
+			// run or wait on all but one of them; the last is left for cheap calls.
+			unsigned const spareThreads = rpcThreads - 1;
+			unsigned const httpExpensiveSlots = spareThreads ? (rpcExpensiveSlots ? min(rpcExpensiveSlots, spareThreads) : spareThreads) : 1;
+			unsigned const httpExpensiveQueue = spareThreads > httpExpensiveSlots ? min(rpcQueue, spareThreads - httpExpensiveSlots) : 0;
+			jsonrpcHttpServer->setAdmission(rpc::RequestClass::Expensive, httpExpensiveSlots, httpExpensiveQueue);
+			jsonrpcHttpServer->setAdmission(rpc::RequestClass::Cheap, rpcCheapSlots, rpcQueue);
+			auto httpConnector = new SafeHttpServer(jsonRPCURL, "", "", rpcThreads);
 			httpConnector->setAllowedOrigin(rpcCorsDomain);
 			jsonrpcHttpServer->addConnector(httpConnector);
 			jsonrpcHttpServer->StartListening();
@@ -1215,6 +1336,9 @@ int main(int argc, char** argv)
 				new rpc::Debug(*web3.ethereum()),
 				testEth
 			));
+			jsonrpcIpcServer->setBatchExecution(rpcBatchThreads, web3.ethereum());
+			jsonrpcIpcServer->setAdmission(rpc::RequestClass::Expensive, rpcExpensiveSlots, rpcQueue);
+			jsonrpcIpcServer->setAdmission(rpc::RequestClass::Cheap, rpcCheapSlots, rpcQueue);
 			auto ipcConnector = new IpcServer("geth");
 			jsonrpcIpcServer->addConnector(ipcConnector);
 			ipcConnector->StartListening();
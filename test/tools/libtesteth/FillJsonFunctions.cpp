@@ -135,6 +135,10 @@ json_spirit::mObject fillJsonWithStateChange(State const& _stateOrig, eth::State
 					o["newlyCreated"] = "true";
 					logInfo["newlyCreated"] << "'newlyCreated' : ['true']\n";
 				break;
+				case Change::Kind::Kill:
+					o["selfdestructed"] = "true";
+					logInfo["selfdestructed"] << "'selfdestructed' : ['true']\n";
+				break;
 				default:
 					o["unknownChange"] = "true";
 					logInfo["unknownChange"] << "'unknownChange' : ['true']\n";
@@ -43,6 +43,20 @@ BOOST_AUTO_TEST_CASE(test_toJS)
 	BOOST_CHECK(toJS(d) == "0xff00efbc");
 }
 
+BOOST_AUTO_TEST_CASE(test_toJSQuantities)
+{
+	BOOST_CHECK_EQUAL(toJS(u256(0)), "0x0");
+	BOOST_CHECK_EQUAL(toJS(u256(0xa)), "0xa");
+	BOOST_CHECK_EQUAL(toJS(u256(0x100)), "0x100");
+	BOOST_CHECK_EQUAL(toJS(u256(1) << 64), "0x10000000000000000");
+	BOOST_CHECK_EQUAL(toJS(~u256(0)), "0x" + string(64, 'f'));
+	BOOST_CHECK_EQUAL(toJS(u160(0xbeef)), "0xbeef");
+	BOOST_CHECK_EQUAL(toJS(0u), "0x0");
+	BOOST_CHECK_EQUAL(toJS(int64_t(-1)), "0xffffffffffffffff");
+	BOOST_CHECK_EQUAL(toJS(bytes{0x01, 0x02}, 4), "0x01020000");
+	BOOST_CHECK_EQUAL(toJS(bytes{0x01, 0x02}, 1), "0x0102");
+}
+
 BOOST_AUTO_TEST_CASE(test_jsToBytes)
 {
 	bytes a = {0xff, 0xaa, 0xbb, 0xcc};
@@ -0,0 +1,71 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file LruCache.cpp
+ * @date 2018
+ */
+
+#include <libdevcore/LruCache.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace dev;
+
+namespace dev
+{
+namespace test
+{
+
+BOOST_FIXTURE_TEST_SUITE(LruCacheTest, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(evictsLeastRecentlyUsed)
+{
+	LruCache<unsigned, string> cache(2);
+	cache.put(1, "one");
+	cache.put(2, "two");
+
+	string v;
+	BOOST_REQUIRE(cache.get(1, v));
+	BOOST_CHECK_EQUAL(v, "one");
+
+	cache.put(3, "three");
+	BOOST_CHECK_EQUAL(cache.size(), 2);
+	BOOST_CHECK(!cache.get(2, v));
+	BOOST_CHECK(cache.get(1, v));
+	BOOST_CHECK(cache.get(3, v));
+	BOOST_CHECK_EQUAL(v, "three");
+}
+
+BOOST_AUTO_TEST_CASE(overwrite)
+{
+	LruCache<unsigned, string> cache(2);
+	cache.put(1, "one");
+	cache.put(1, "uno");
+	BOOST_CHECK_EQUAL(cache.size(), 1);
+
+	string v;
+	BOOST_REQUIRE(cache.get(1, v));
+	BOOST_CHECK_EQUAL(v, "uno");
+
+	cache.clear();
+	BOOST_CHECK(!cache.get(1, v));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
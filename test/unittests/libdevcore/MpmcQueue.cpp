@@ -0,0 +1,100 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file MpmcQueue.cpp
+ * @date 2026
+ */
+
+#include <libdevcore/mpmc_queue.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+#include <boost/test/unit_test.hpp>
+#include <thread>
+
+using namespace std;
+using namespace dev;
+
+namespace dev
+{
+namespace test
+{
+
+BOOST_FIXTURE_TEST_SUITE(MpmcQueueTest, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(refusesWhenFull)
+{
+	mpmc_queue<unsigned> q(4);
+	BOOST_CHECK_EQUAL(q.capacity(), 4);
+	for (unsigned i = 0; i < 4; ++i)
+		BOOST_CHECK(q.push(i));
+	BOOST_CHECK(!q.push(4u));
+	BOOST_CHECK_EQUAL(q.depth(), 4);
+	BOOST_CHECK_EQUAL(q.dropped(), 1);
+
+	vector<unsigned> out;
+	BOOST_CHECK_EQUAL(q.try_pop_batch(out, 3), 3);
+	BOOST_CHECK(out == vector<unsigned>({0, 1, 2}));
+	BOOST_CHECK(q.push(5u));
+	BOOST_CHECK_EQUAL(q.try_pop_batch(out, 10), 2);
+	BOOST_CHECK(out == vector<unsigned>({0, 1, 2, 3, 5}));
+	BOOST_CHECK(q.empty());
+}
+
+BOOST_AUTO_TEST_CASE(deliversEveryElementOnce)
+{
+	unsigned const c_producers = 4;
+	unsigned const c_perProducer = 20000;
+	mpmc_queue<unsigned> q(256);
+	atomic<unsigned long long> sum(0);
+	atomic<unsigned> count(0);
+
+	vector<thread> consumers;
+	for (unsigned i = 0; i < 3; ++i)
+		consumers.emplace_back([&](){
+			vector<unsigned> batch;
+			while (q.pop_batch(batch, 16))
+			{
+				for (unsigned v: batch)
+					sum += v;
+				count += batch.size();
+				batch.clear();
+			}
+		});
+
+	vector<thread> producers;
+	for (unsigned p = 0; p < c_producers; ++p)
+		producers.emplace_back([&, p](){
+			for (unsigned i = 0; i < c_perProducer; ++i)
+				while (!q.push(p * c_perProducer + i))
+					this_thread::yield();
+		});
+	for (auto& t: producers)
+		t.join();
+	while (!q.empty())
+		this_thread::yield();
+	q.close();
+	for (auto& t: consumers)
+		t.join();
+
+	unsigned long long const n = c_producers * c_perProducer;
+	BOOST_CHECK_EQUAL(count, n);
+	BOOST_CHECK_EQUAL(sum, n * (n - 1) / 2);
+	BOOST_CHECK_EQUAL(q.pushed(), n);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
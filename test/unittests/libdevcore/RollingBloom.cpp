@@ -0,0 +1,80 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file RollingBloom.cpp
+ * Tests for the rolling Bloom filter.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/RollingBloom.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::test;
+
+namespace
+{
+h256s randomHashes(unsigned _n)
+{
+	h256s ret;
+	for (unsigned i = 0; i < _n; ++i)
+		ret.push_back(h256::random());
+	return ret;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(RollingBloomTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(remembersRecentInsertions)
+{
+	RollingBloom bloom(1000);
+	h256s const hashes = randomHashes(11000);
+	for (unsigned i = 0; i < 1000; ++i)
+		bloom.insert(hashes[i]);
+	for (unsigned i = 0; i < 1000; ++i)
+		BOOST_REQUIRE(bloom.contains(hashes[i]));
+
+	unsigned falsePositives = 0;
+	for (unsigned i = 1000; i < 11000; ++i)
+		falsePositives += bloom.contains(hashes[i]);
+	BOOST_CHECK_LT(falsePositives, 100u);
+}
+
+BOOST_AUTO_TEST_CASE(forgetsOldGenerations)
+{
+	RollingBloom bloom(100);
+	h256s const hashes = randomHashes(301);
+	for (unsigned i = 0; i < 100; ++i)
+		bloom.insert(hashes[i]);
+	// One more generation pushes the first into the previous slot, where it is still found...
+	for (unsigned i = 100; i < 200; ++i)
+		bloom.insert(hashes[i]);
+	BOOST_CHECK(bloom.contains(hashes[0]));
+	BOOST_CHECK(bloom.contains(hashes[199]));
+	// ...and a third drops it.
+	for (unsigned i = 200; i < 301; ++i)
+		bloom.insert(hashes[i]);
+	unsigned remembered = 0;
+	for (unsigned i = 0; i < 100; ++i)
+		remembered += bloom.contains(hashes[i]);
+	BOOST_CHECK_LT(remembered, 5u);
+
+	bloom.clear();
+	BOOST_CHECK(!bloom.contains(hashes[300]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
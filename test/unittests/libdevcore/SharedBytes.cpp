@@ -0,0 +1,69 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SharedBytes.cpp
+ * Tests for the shared byte buffer view.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/SharedBytes.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(SharedBytesTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(slicesShareTheBuffer)
+{
+	bytes data{1, 2, 3, 4, 5, 6};
+	byte const* storage = data.data();
+	SharedBytesRef packet(move(data));
+	BOOST_CHECK(packet.data() == storage);
+	BOOST_CHECK_EQUAL(packet.size(), 6u);
+
+	SharedBytesRef slice = packet.slice(packet.ref().cropped(2, 3));
+	BOOST_CHECK(slice.data() == storage + 2);
+	BOOST_CHECK(slice.toBytes() == bytes({3, 4, 5}));
+
+	// The slice keeps the buffer alive on its own.
+	packet = SharedBytesRef();
+	BOOST_CHECK(packet.empty());
+	BOOST_CHECK(slice.toBytes() == bytes({3, 4, 5}));
+}
+
+BOOST_AUTO_TEST_CASE(foreignRangesAreCopied)
+{
+	bytes other{7, 8, 9};
+	SharedBytesRef packet(bytes{1, 2, 3});
+	SharedBytesRef copy = packet.slice(&other);
+	BOOST_CHECK(copy.data() != other.data());
+	BOOST_CHECK(copy.toBytes() == other);
+
+	SharedBytesRef fromEmpty = SharedBytesRef().slice(&other);
+	BOOST_CHECK(fromEmpty.toBytes() == other);
+}
+
+BOOST_AUTO_TEST_CASE(movedFromIsEmpty)
+{
+	SharedBytesRef packet(bytes{1, 2, 3});
+	SharedBytesRef moved(move(packet));
+	BOOST_CHECK(packet.empty());
+	BOOST_CHECK_EQUAL(moved.size(), 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
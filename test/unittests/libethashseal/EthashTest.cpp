@@ -18,6 +18,8 @@
  * Ethash class testing.
  */
 
+#include <atomic>
+#include <thread>
 #include <boost/test/unit_test.hpp>
 #include <test/tools/libtesteth/TestOutputHelper.h>
 #include <libethashseal/Ethash.h>
@@ -96,4 +98,92 @@ BOOST_AUTO_TEST_CASE(calculateDifficultyByzantiumMaxAdjustment)
 	BOOST_REQUIRE_EQUAL(ethash.calculateDifficulty(header, parentHeader), 951688);
 }
 
+BOOST_AUTO_TEST_CASE(stakeTicketsAreCachedPerParent)
+{
+	ChainOperationParams params;
+	params.minimumDifficulty = 2;
+	params.difficultyBoundDivisor = 2048;
+
+	Ethash ethash;
+	ethash.setChainParams(params);
+	ethash.setKeyPairs({KeyPair<BLS>::create()});
+
+	BlockHeader parentHeader;
+	parentHeader.clear();
+	parentHeader.setNumber(1);
+	parentHeader.setTimestamp(100);
+	parentHeader.setDifficulty(2);
+	Ethash::setStakeModifier(parentHeader, StakeModifier(sha3("modifier")));
+
+	// Difficulty stays at 2, so a unit balance gives each timestamp even odds.
+	unsigned balanceQueries = 0;
+	BalanceRetriever balanceRetriever = [&](Address const&, BlockNumber const&) { ++balanceQueries; return u256(1); };
+
+	StakeTickets tickets = ethash.stakeTickets(parentHeader, 101, 130, balanceRetriever);
+	BOOST_REQUIRE(!tickets.empty());
+	BlockHeader header;
+	header.clear();
+	header.setNumber(2);
+	for (auto const& t: tickets)
+	{
+		BOOST_REQUIRE(t.timestamp >= 101 && t.timestamp <= 130);
+		header.setTimestamp(t.timestamp);
+		header.setDifficulty(ethash.calculateDifficulty(header, parentHeader));
+		BOOST_CHECK(Ethash::verifyStakeSignature(t.key.pub(), t.signature, Ethash::computeStakeMessage(Ethash::stakeModifier(parentHeader), t.timestamp)));
+		BOOST_CHECK(Ethash::computeStakeSignatureHash(t.signature) <= ethash.boundary(header, 1));
+	}
+
+	StakeTickets overlapping = ethash.stakeTickets(parentHeader, 110, 140, balanceRetriever);
+	vector<int64_t> expected;
+	for (auto const& t: tickets)
+		if (t.timestamp >= 110)
+			expected.push_back(t.timestamp);
+	vector<int64_t> got;
+	for (auto const& t: overlapping)
+		if (t.timestamp <= 130)
+			got.push_back(t.timestamp);
+	BOOST_CHECK(expected == got);
+	BOOST_CHECK_EQUAL(balanceQueries, 1);
+
+	// Nothing can be sealed at or before the parent's timestamp.
+	BOOST_CHECK(ethash.stakeTickets(parentHeader, 50, 100, balanceRetriever).empty());
+}
+
+BOOST_AUTO_TEST_CASE(preparedTicketsAreUsedWhenSealing)
+{
+	ChainOperationParams params;
+	params.minimumDifficulty = 2;
+	params.difficultyBoundDivisor = 2048;
+
+	Ethash ethash;
+	ethash.setChainParams(params);
+	ethash.setKeyPairs({KeyPair<BLS>::create()});
+
+	BlockHeader parentHeader;
+	parentHeader.clear();
+	parentHeader.setNumber(1);
+	parentHeader.setTimestamp(utcTime() - 10);
+	parentHeader.setDifficulty(2);
+	Ethash::setStakeModifier(parentHeader, StakeModifier(sha3("modifier")));
+
+	atomic<unsigned> prepareQueries(0);
+	ethash.prepareSeal(parentHeader, [&](Address const&, BlockNumber const&) { ++prepareQueries; return u256(1); });
+	BOOST_REQUIRE_EQUAL(prepareQueries, 1);
+
+	// Only checking the seal we make may ask for a balance now; finding tickets again would too.
+	atomic<unsigned> sealQueries(0);
+	atomic<bool> sealed(false);
+	BlockHeader header;
+	header.clear();
+	header.setNumber(2);
+	header.setParentHash(parentHeader.hash());
+	ethash.onSealGenerated([&](bytes const&) { sealed = true; });
+	ethash.generateSeal(header, parentHeader, [&](Address const&, BlockNumber const&) { ++sealQueries; return u256(1); });
+	for (auto deadline = chrono::steady_clock::now() + chrono::seconds(45); ethash.isMining() && chrono::steady_clock::now() < deadline;)
+		this_thread::sleep_for(chrono::milliseconds(50));
+	BOOST_REQUIRE(!ethash.isMining());
+	BOOST_CHECK_LE(sealQueries, sealed ? 1u : 0u);
+	BOOST_CHECK_EQUAL(prepareQueries, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -45,4 +45,31 @@ BOOST_AUTO_TEST_CASE(UnsignedTransactionIsValidBeforeConstantinople)
 	ethash.SealEngineFace::verifyTransaction(ImportRequirements::TransactionSignatures, tx, header, 0); // check that it doesn't throw
 }
 
+BOOST_AUTO_TEST_CASE(ForeignSignatureIsRejectedFromForkBlock)
+{
+	ChainOperationParams params;
+	params.constantinopleForkBlock = u256(0x1000);
+	params.signatureVerificationForkBlock = 5;
+
+	Ethash ethash;
+	ethash.setChainParams(params);
+
+	AccountKeys::Pair sender = AccountKeys::Pair::create();
+	AccountKeys::Pair impostor = AccountKeys::Pair::create();
+	Transaction signedTx(0, 0, 25000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0, sender.secret());
+	RLPStream forged;
+	forged.appendList(7);
+	forged << signedTx.nonce() << signedTx.gasPrice() << signedTx.gas() << signedTx.receiveAddress() << signedTx.value() << signedTx.data();
+	AccountKeys::SignatureStruct(signedTx.signature(), impostor.pub()).streamRLP(forged);
+	Transaction tx(forged.out(), CheckTransaction::Everything);
+
+	BlockHeader header;
+	header.clear();
+	header.setNumber(4);
+	ethash.SealEngineFace::verifyTransaction(ImportRequirements::TransactionSignatures, tx, header, 0);
+	header.setNumber(5);
+	BOOST_CHECK_THROW(ethash.SealEngineFace::verifyTransaction(ImportRequirements::TransactionSignatures, tx, header, 0), InvalidSignature);
+	ethash.SealEngineFace::verifyTransaction(ImportRequirements::TransactionSignatures, signedTx, header, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
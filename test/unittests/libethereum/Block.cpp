@@ -229,6 +229,35 @@ BOOST_AUTO_TEST_CASE(bGasPricer)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(bSyncArrived)
+{
+	TestBlockChain testBlockchain(TestBlockChain::defaultGenesisBlock(63000));
+	TestBlock const& genesisBlock = testBlockchain.testGenesis();
+	OverlayDB const& genesisDB = genesisBlock.state().db();
+	BlockChain const& blockchain = testBlockchain.interface();
+
+	TestBlock testBlock;
+	Transactions arrived;
+	auto current = testBlock.transactionQueue().onCurrent([&](Transaction const& _t){ arrived.push_back(_t); });
+	testBlock.addTransaction(TestTransaction::defaultTransaction(1, 1, 21000));
+	BOOST_REQUIRE_EQUAL(arrived.size(), 1);
+
+	ZeroGasPricer gp;
+	Block block = blockchain.genesisBlock(genesisDB);
+	block.sync(blockchain);
+
+	// Never synced with the queue: the whole queue is gone through.
+	arrived.clear();
+	BOOST_CHECK_EQUAL(block.syncArrived(blockchain, testBlock.transactionQueue(), gp, arrived).first.size(), 1);
+
+	// From now on only the transactions that arrived are tried.
+	testBlock.addTransaction(TestTransaction::defaultTransaction(2, 1, 21000));
+	BOOST_REQUIRE_EQUAL(arrived.size(), 1);
+	BOOST_CHECK_EQUAL(block.syncArrived(blockchain, testBlock.transactionQueue(), gp, arrived).first.size(), 1);
+	BOOST_CHECK_EQUAL(block.pending().size(), 2);
+	BOOST_CHECK(block.syncArrived(blockchain, testBlock.transactionQueue(), gp, Transactions()).first.empty());
+}
+
 BOOST_AUTO_TEST_CASE(bGetReceiptOverflow)
 {
 	TestBlockChain bc;
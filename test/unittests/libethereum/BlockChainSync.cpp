@@ -0,0 +1,70 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BlockChainSync.cpp
+ * Tests for the adaptive sync request sizing.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libethereum/BlockChainSync.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(BlockChainSyncTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(fastPeerGetsLargerRequests)
+{
+	SyncThroughput t(128, 16, 1024);
+	auto now = SyncThroughput::Clock::now();
+	t.requested(128, now);
+	t.received(128, now + chrono::milliseconds(100));
+	// Growth is capped at twice the last request.
+	BOOST_CHECK_EQUAL(t.requestSize(), 256);
+	for (int i = 0; i < 5; ++i)
+	{
+		t.requested(t.requestSize(), now);
+		t.received(t.requestSize(), now + chrono::milliseconds(100));
+	}
+	BOOST_CHECK_EQUAL(t.requestSize(), 1024);
+}
+
+BOOST_AUTO_TEST_CASE(slowPeerGetsSmallerRequests)
+{
+	SyncThroughput t(128, 16, 1024);
+	auto now = SyncThroughput::Clock::now();
+	t.requested(128, now);
+	t.received(128, now + chrono::seconds(8));
+	// 16 items per second at a 2 second target.
+	BOOST_CHECK_EQUAL(t.requestSize(), 32);
+	t.requested(32, now);
+	t.received(0, now + chrono::seconds(1));
+	// An empty answer pulls the smoothed rate down to 11.2 items per second.
+	BOOST_CHECK_EQUAL(t.requestSize(), 22);
+}
+
+BOOST_AUTO_TEST_CASE(unsolicitedResponseIgnored)
+{
+	SyncThroughput t(128, 16, 1024);
+	t.received(1000);
+	BOOST_CHECK_EQUAL(t.requestSize(), 128);
+	BOOST_CHECK_EQUAL(t.itemsPerSecond(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,9 +21,12 @@
  */
 
 #include <libethereum/BlockQueue.h>
+#include <libdevcore/TransientDirectory.h>
 #include <test/tools/libtesteth/TestHelper.h>
 #include <test/tools/libtesteth/BlockChainHelper.h>
 #include <test/tools/libtesteth/JsonSpiritHeaders.h>
+#include <numeric>
+#include <random>
 
 using namespace std;
 using namespace dev;
@@ -100,4 +103,96 @@ BOOST_AUTO_TEST_CASE(BlockQueueImport)
 	BOOST_REQUIRE_MESSAGE(res == ImportResult::UnknownParent, "Simple block import to BlockQueue should have return UnknownParent");
 }
 
+BOOST_AUTO_TEST_CASE(SizedBlockMapSpillsFurthestAheadFirst)
+{
+	TransientDirectory dir;
+	BlockSpill spill(dir.path() + "/blockqueue.ring", 100);
+	BOOST_REQUIRE(spill.isOpen());
+
+	SizedBlockMap<time_t> blocks;
+	blocks.setSpill(&spill);
+	auto block = [](byte _b) { return bytes(40, _b); };
+	BOOST_REQUIRE(blocks.insert(10, h256(1), block(1), 1));
+	BOOST_REQUIRE(blocks.insert(20, h256(2), block(2), 2));
+	BOOST_REQUIRE(blocks.insert(30, h256(3), block(3), 3));
+	BOOST_CHECK(!blocks.insert(30, h256(3), block(3), 3));
+	BOOST_CHECK_EQUAL(blocks.size(), 120);
+
+	// Blocks 3 and 2 fill the ring; block 4 would wrap onto block 3, so it stays in memory.
+	BOOST_CHECK_EQUAL(blocks.spill(40), 2);
+	BOOST_CHECK_EQUAL(blocks.size(), 40);
+	BOOST_CHECK_EQUAL(blocks.spilledCount(), 2);
+	BOOST_CHECK_EQUAL(blocks.spilledSize(), 80);
+	BOOST_REQUIRE(blocks.insert(40, h256(4), block(4), 4));
+	BOOST_CHECK_EQUAL(blocks.spill(40), 0);
+
+	auto removed = blocks.removeByKeyNotGreater(30);
+	BOOST_REQUIRE_EQUAL(removed.size(), 3);
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		BOOST_CHECK(removed[i].first == h256(i + 1));
+		BOOST_CHECK(removed[i].second == block(i + 1));
+	}
+	BOOST_CHECK_EQUAL(spill.entries(), 0);
+	BOOST_CHECK_EQUAL(blocks.spilledCount(), 0);
+
+	BOOST_CHECK_EQUAL(blocks.spill(0), 1);
+	BOOST_CHECK_EQUAL(blocks.size(), 0);
+	removed = blocks.removeByKeyEqual(40);
+	BOOST_REQUIRE_EQUAL(removed.size(), 1);
+	BOOST_CHECK(removed[0].second == block(4));
+	BOOST_CHECK(blocks.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(SizedBlockQueueIndexedOperations)
+{
+	size_t const c_blocks = 10000;
+	auto placeholder = [](size_t _i)
+	{
+		BlockHeader bi;
+		bi.setSha3Uncles(h256(_i + 1));
+		bi.setParentHash(h256(_i));
+		return VerifiedBlock(move(bi));
+	};
+
+	Timer timer;
+	SizedBlockQueue<VerifiedBlock> queue;
+	for (size_t i = 0; i < c_blocks; ++i)
+		queue.enqueue(placeholder(i));
+
+	// Verification completes out of order; every block keeps its place in the queue.
+	vector<size_t> order(c_blocks);
+	iota(order.begin(), order.end(), 0);
+	shuffle(order.begin(), order.end(), mt19937(0));
+	for (size_t i: order)
+	{
+		VerifiedBlock block = placeholder(i);
+		block.blockData = SharedBytesRef(bytes(8, byte(i)));
+		BOOST_REQUIRE(queue.replace(h256(i + 1), move(block)));
+	}
+	BOOST_CHECK_EQUAL(queue.size(), c_blocks * 8);
+	BOOST_CHECK(queue.nextHash() == h256(1));
+
+	for (size_t i = 1; i < c_blocks; i += 2)
+		BOOST_REQUIRE(queue.remove(h256(i + 1)));
+	BOOST_CHECK(!queue.remove(h256(2)));
+	BOOST_CHECK_EQUAL(queue.count(), c_blocks / 2);
+
+	for (size_t i = 2; i < c_blocks; i += 4)
+	{
+		auto children = queue.removeByParent(h256(i));
+		BOOST_REQUIRE_EQUAL(children.size(), 1);
+		BOOST_CHECK(children[0].verified.info.sha3Uncles() == h256(i + 1));
+	}
+	BOOST_CHECK(queue.removeByParent(h256(2)).empty());
+
+	auto rest = queue.dequeueMultiple(c_blocks);
+	BOOST_REQUIRE_EQUAL(rest.size(), c_blocks / 4);
+	for (size_t k = 0; k < rest.size(); ++k)
+		BOOST_CHECK(rest[k].verified.info.sha3Uncles() == h256(4 * k + 1));
+	BOOST_CHECK(queue.isEmpty());
+	BOOST_CHECK_EQUAL(queue.size(), 0);
+	BOOST_TEST_MESSAGE("SizedBlockQueue, " << c_blocks << " blocks: " << timer.elapsed() << "s");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
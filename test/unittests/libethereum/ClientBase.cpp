@@ -22,6 +22,7 @@
 #include <boost/test/unit_test.hpp>
 #include <libdevcore/CommonJS.h>
 #include <libethashseal/Ethash.h>
+#include <test/tools/libtesteth/BlockChainHelper.h>
 #include <test/tools/libtesteth/TestOutputHelper.h>
 #include <test/tools/libtesteth/TestUtils.h>
 #include <test/tools/libtestutils/FixedClient.h>
@@ -221,3 +222,130 @@ BOOST_AUTO_TEST_CASE(blocks)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+namespace
+{
+
+Address const c_sender("a94f5374fce5edbc8e2a8697c15331677e6ebf0b");
+Address const c_recipient("1000000000000000000000000000000000000001");
+Address const c_loop("1000000000000000000000000000000000000002");		///< Jumps back to the start for ever.
+Address const c_revert("1000000000000000000000000000000000000003");		///< REVERT straight away.
+Address const c_selfdestruct("1000000000000000000000000000000000000004");	///< SELFDESTRUCT to the caller.
+int64_t const c_estimateCap = 1000000;
+
+/// A chain whose genesis holds the accounts called below, and a client on it.
+class EstimateGasFixture: public TestOutputHelper
+{
+public:
+	EstimateGasFixture():
+		networkSelector(eth::Network::ByzantiumTest),
+		chain(genesis()),
+		client(chain.interface(), chain.interface().genesisBlock(chain.testGenesis().state().db()))
+	{}
+
+	/// Estimates as ClientBase::estimateGas did before it shared one overlay between its trials:
+	/// a fresh State for each, and a plain bisection from the intrinsic cost.
+	pair<u256, ExecutionResult> referenceEstimate(Address const& _dest, u256 const& _value)
+	{
+		BlockChain const& bc = client.bc();
+		int64_t upperBound = c_estimateCap;
+		int64_t lowerBound = Transaction::baseGasRequired(false, bytesConstRef(), EVMSchedule());
+		Block bk = client.block(PendingBlock);
+		ExecutionResult er;
+		ExecutionResult lastGood;
+		bool good = false;
+		while (upperBound != lowerBound)
+		{
+			int64_t mid = (lowerBound + upperBound) / 2;
+			Transaction t(_value, 1, mid, _dest, bytes(), bk.transactionsFrom(c_sender));
+			t.forceSender(c_sender);
+			EnvInfo const env(bk.info(), bc.lastBlockHashes(), 0, mid, bc.sealEngine()->chainParams().chainID);
+			State tempState(bk.state());
+			tempState.addBalance(c_sender, (u256)(t.gas() * t.gasPrice() + t.value()));
+			er = tempState.execute(env, *bc.sealEngine(), t, Permanence::Reverted).first;
+			if (er.excepted == TransactionException::OutOfGas ||
+				er.excepted == TransactionException::OutOfGasBase ||
+				er.excepted == TransactionException::OutOfGasIntrinsic ||
+				er.codeDeposit == CodeDeposit::Failed ||
+				er.excepted == TransactionException::BadJumpDestination)
+				lowerBound = lowerBound == mid ? upperBound : mid;
+			else
+			{
+				lastGood = er;
+				upperBound = upperBound == mid ? lowerBound : mid;
+				good = true;
+			}
+		}
+		return make_pair(upperBound, good ? lastGood : er);
+	}
+
+	void checkAgainstReference(Address const& _dest, u256 const& _value = 0)
+	{
+		auto expected = referenceEstimate(_dest, _value);
+		auto estimate = client.estimateGas(c_sender, _value, _dest, bytes(), c_estimateCap, 1, PendingBlock);
+		BOOST_CHECK_EQUAL(estimate.first, expected.first);
+		BOOST_CHECK(estimate.second.excepted == expected.second.excepted);
+		// When every limit fails, the two report different failed runs.
+		if (expected.second.excepted != TransactionException::OutOfGas)
+			BOOST_CHECK_EQUAL(estimate.second.gasUsed, expected.second.gasUsed);
+	}
+
+	NetworkSelector networkSelector;
+	TestBlockChain chain;
+	FixedClient client;
+
+private:
+	static TestBlock genesis()
+	{
+		auto account = [](string const& _code)
+		{
+			mObject ret;
+			ret["balance"] = "1000000000000000000";
+			ret["nonce"] = "0";
+			ret["code"] = _code;
+			ret["storage"] = mObject();
+			return ret;
+		};
+		mObject accounts;
+		accounts[toHex(c_sender.ref())] = account("");
+		accounts[toHex(c_loop.ref())] = account("0x5b600056");
+		accounts[toHex(c_revert.ref())] = account("0x60006000fd");
+		accounts[toHex(c_selfdestruct.ref())] = account("0x33ff");
+		return TestBlock(TestBlockChain::defaultGenesisBlockJson(), accounts);
+	}
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(ClientBaseEstimateGas, EstimateGasFixture)
+
+BOOST_AUTO_TEST_CASE(simpleTransfer)
+{
+	checkAgainstReference(c_recipient, 1);
+	BOOST_CHECK_EQUAL(client.estimateGas(c_sender, 1, c_recipient, bytes(), c_estimateCap, 1, PendingBlock).first, 21000);
+}
+
+BOOST_AUTO_TEST_CASE(outOfGas)
+{
+	checkAgainstReference(c_loop);
+	auto estimate = client.estimateGas(c_sender, 0, c_loop, bytes(), c_estimateCap, 1, PendingBlock);
+	BOOST_CHECK_EQUAL(estimate.first, c_estimateCap);
+	BOOST_CHECK(estimate.second.excepted == TransactionException::OutOfGas);
+}
+
+BOOST_AUTO_TEST_CASE(revert)
+{
+	checkAgainstReference(c_revert);
+	BOOST_CHECK(client.estimateGas(c_sender, 0, c_revert, bytes(), c_estimateCap, 1, PendingBlock).second.excepted == TransactionException::RevertInstruction);
+}
+
+BOOST_AUTO_TEST_CASE(selfdestruct)
+{
+	// Every trial after the first only matches if rolling back restored the killed account.
+	checkAgainstReference(c_selfdestruct);
+	// The refund halves the net gas used, so the estimate has to look past it to the peak.
+	auto estimate = client.estimateGas(c_sender, 0, c_selfdestruct, bytes(), c_estimateCap, 1, PendingBlock);
+	BOOST_CHECK(estimate.first > estimate.second.gasUsed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -87,6 +87,8 @@ public:
 
 	void onPeerTransactions(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
+	void onPeerTransactionHashes(std::shared_ptr<EthereumPeer>, h256s const&) override {}
+
 	void onPeerBlockHeaders(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
 	void onPeerBlockBodies(std::shared_ptr<EthereumPeer>, RLP const&) override {}
@@ -99,7 +101,47 @@ public:
 
 	void onPeerReceipts(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
+	void onPeerSnapshotManifest(std::shared_ptr<EthereumPeer>, RLP const& _r) override { m_snapshotManifests.push_back(_r.data().toBytes()); }
+
+	void onPeerSnapshotData(std::shared_ptr<EthereumPeer>, RLP const& _r) override { m_snapshotData.push_back(_r.data().toBytes()); }
+
 	void onPeerAborting() override {}
+
+	vector<bytes> m_snapshotManifests;
+	vector<bytes> m_snapshotData;
+};
+
+class MockEthereumHostData: public EthereumHostDataFace
+{
+public:
+	pair<bytes, unsigned> blockHeaders(RLP const&, unsigned, u256, bool) const override { return {}; }
+
+	pair<bytes, unsigned> blockBodies(RLP const&) const override { return {}; }
+
+	strings nodeData(RLP const&) const override { return {}; }
+
+	pair<bytes, unsigned> receipts(RLP const&) const override { return {}; }
+
+	pair<bytes, unsigned> pooledTransactions(RLP const&) const override { return {}; }
+
+	bytes snapshotManifest() const override { return m_manifest; }
+
+	string snapshotData(h256 const& _chunkHash) const override
+	{
+		auto it = m_chunks.find(_chunkHash);
+		return it == m_chunks.end() ? string() : it->second;
+	}
+
+	bytes m_manifest;
+	map<h256, string> m_chunks;
+};
+
+/// Lets tests feed packets to the peer as its session would.
+class TestEthereumPeer: public EthereumPeer
+{
+public:
+	using EthereumPeer::EthereumPeer;
+	using Capability::interpret;
 };
 
 class EthereumPeerTestFixture: public TestOutputHelper
@@ -185,4 +227,129 @@ BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestReceipts)
 	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[2]), blockHash2);
 }
 
+BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestTransactions)
+{
+	h256 txHash0("0x949d991d685738352398dff73219ab19c62c06e6f8ce899fbae755d5127ed1ef");
+	h256 txHash1("0x0e4562a10381dec21b205ed72637e6b1b523bdd0e4d4d50af5cd23dd4500a217");
+	session->m_notes.clear();
+	peer.requestTransactions({ txHash0, txHash1 });
+
+	uint8_t code = static_cast<uint8_t>(session->m_bytesSent[0]);
+	BOOST_REQUIRE_EQUAL(code, offset + 0x09);
+
+	bytes payloadSent(session->m_bytesSent.begin() + 1, session->m_bytesSent.end());
+	RLP rlp(payloadSent);
+	BOOST_REQUIRE_EQUAL(rlp.itemCount(), 2);
+	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[0]), txHash0);
+	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[1]), txHash1);
+	// Fetching announced transactions runs alongside sync, so it must not touch the asking state.
+	BOOST_CHECK(session->m_notes.find("ask") == session->m_notes.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+class SnapshotPacketFixture: public TestOutputHelper
+{
+public:
+	SnapshotPacketFixture():
+		session(std::make_shared<MockSession>()),
+		observer(std::make_shared<MockEthereumPeerObserver>()),
+		hostData(std::make_shared<MockEthereumHostData>()),
+		peer(std::make_shared<TestEthereumPeer>(session, &hostCap, UserPacket, CapDesc{ "eth", 64 }, 0))
+	{
+		peer->init(64, 2, 0, h256(0), h256(0), hostData, observer);
+	}
+
+	/// Delivers a packet of type @a _id with the given payload list to the peer.
+	void receive(unsigned _id, RLPStream const& _payload)
+	{
+		bytes const payload = _payload.out();
+		peer->interpret(_id, RLP(payload));
+	}
+
+	uint8_t sentCode() const { return static_cast<uint8_t>(session->m_bytesSent[0]); }
+	bytes sentPayload() const { return bytes(session->m_bytesSent.begin() + 1, session->m_bytesSent.end()); }
+
+	MockHostCapability hostCap;
+	std::shared_ptr<MockSession> session;
+	std::shared_ptr<MockEthereumPeerObserver> observer;
+	std::shared_ptr<MockEthereumHostData> hostData;
+	std::shared_ptr<TestEthereumPeer> peer;
+};
+
+BOOST_FIXTURE_TEST_SUITE(EthereumPeerSnapshotPackets, SnapshotPacketFixture)
+
+BOOST_AUTO_TEST_CASE(getSnapshotManifestIsAnsweredWithServedManifest)
+{
+	RLPStream manifest(2);
+	manifest << 2 << h256(1);
+	hostData->m_manifest = manifest.out();
+
+	receive(GetSnapshotManifestPacket, RLPStream(0));
+
+	BOOST_REQUIRE_EQUAL(sentCode(), UserPacket + SnapshotManifestPacket);
+	bytes const payload = sentPayload();
+	RLP const rlp(payload);
+	BOOST_REQUIRE_EQUAL(rlp.itemCount(), 1);
+	BOOST_CHECK(rlp[0].data().toBytes() == hostData->m_manifest);
+}
+
+BOOST_AUTO_TEST_CASE(getSnapshotManifestWithoutSnapshotIsAnsweredEmpty)
+{
+	receive(GetSnapshotManifestPacket, RLPStream(0));
+
+	BOOST_REQUIRE_EQUAL(sentCode(), UserPacket + SnapshotManifestPacket);
+	bytes const payload = sentPayload();
+	BOOST_CHECK_EQUAL(RLP(payload).itemCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(getSnapshotDataIsAnsweredWithChunk)
+{
+	h256 const known("0x949d991d685738352398dff73219ab19c62c06e6f8ce899fbae755d5127ed1ef");
+	hostData->m_chunks[known] = "compressed chunk";
+
+	RLPStream request(1);
+	request << known;
+	receive(GetSnapshotDataPacket, request);
+
+	BOOST_REQUIRE_EQUAL(sentCode(), UserPacket + SnapshotDataPacket);
+	bytes payload = sentPayload();
+	BOOST_REQUIRE_EQUAL(RLP(payload).itemCount(), 1);
+	BOOST_CHECK_EQUAL(RLP(payload)[0].toString(), "compressed chunk");
+
+	RLPStream unknown(1);
+	unknown << h256(1);
+	receive(GetSnapshotDataPacket, unknown);
+	payload = sentPayload();
+	BOOST_CHECK_EQUAL(RLP(payload).itemCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(malformedGetSnapshotDataIsNotAnswered)
+{
+	session->m_bytesSent.clear();
+	receive(GetSnapshotDataPacket, RLPStream(0));
+	BOOST_CHECK(session->m_bytesSent.empty());
+}
+
+BOOST_AUTO_TEST_CASE(snapshotAnswersReachObserverOnlyWhenAsked)
+{
+	RLPStream data(1);
+	data << "chunk";
+	// Still waiting for the peer's status, so this was not asked for.
+	receive(SnapshotDataPacket, data);
+	BOOST_CHECK(observer->m_snapshotData.empty());
+
+	peer->setIdle();
+	peer->requestSnapshotData(h256(1));
+	receive(SnapshotManifestPacket, RLPStream(0));
+	BOOST_CHECK(observer->m_snapshotManifests.empty());
+	receive(SnapshotDataPacket, data);
+	BOOST_REQUIRE_EQUAL(observer->m_snapshotData.size(), 1);
+	BOOST_CHECK(observer->m_snapshotData[0] == data.out());
+
+	peer->requestSnapshotManifest();
+	receive(SnapshotManifestPacket, RLPStream(0));
+	BOOST_CHECK_EQUAL(observer->m_snapshotManifests.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
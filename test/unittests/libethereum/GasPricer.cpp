@@ -25,6 +25,7 @@
 #include <libethereum/ChainParams.h>
 #include <libethereum/GasPricer.h>
 #include <libethereum/BasicGasPricer.h>
+#include <libethereum/PercentileGasPricer.h>
 #include <test/tools/libtesteth/TestHelper.h>
 #include <test/tools/libtestutils/BlockChainLoader.h>
 #include <boost/filesystem/path.hpp>
@@ -186,4 +187,42 @@ BOOST_AUTO_TEST_CASE(basicGasPricer_highGasUsage_HighestPrio)
 	u256 _expectedBid = 30000000000000;
 	dev::test::executeGasPricerTest("highGasUsage_Frontier", 30.679, 15.0, "/BlockchainTests/bcGasPricerTest/highGasUsage.json", TransactionPriority::Highest, _expectedAsk, _expectedBid, eth::Network::FrontierTest);
 }
+
+BOOST_AUTO_TEST_CASE(percentileGasPricer)
+{
+	PercentileGasPricer gp(2, 1, 7);
+	BOOST_CHECK_EQUAL(gp.ask(Block(Block::Null)), 1);
+	BOOST_CHECK_EQUAL(gp.bid(), 7);
+
+	PercentileGasPricer::GasSamples samples;
+	for (unsigned price = 1; price <= 8; ++price)
+		samples.emplace_back(price, 21000);
+	gp.noteBlock(h256(1), samples);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Lowest), 1);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Low), 2);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Medium), 4);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::High), 6);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Highest), 8);
+
+	// Weighted by gas used: this one transaction outweighs the first block three to one.
+	gp.noteBlock(h256(2), {{30, 3 * 8 * 21000}});
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Lowest), 1);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Low), 8);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Medium), 30);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Highest), 30);
+
+	// The window is two blocks long, so the first block drops out.
+	gp.noteBlock(h256(3), {{20 * shannon, 21000}});
+	BOOST_CHECK_EQUAL(gp.blocks(), 2);
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Lowest), 30);
+	BOOST_CHECK(gp.bid(TransactionPriority::Highest) >= 20 * shannon);
+	BOOST_CHECK(gp.bid(TransactionPriority::Highest) <= 20 * shannon * 33 / 32);
+
+	gp.forgetBlock(h256(3));
+	BOOST_CHECK_EQUAL(gp.bid(TransactionPriority::Highest), 30);
+	gp.forgetBlock(h256(2));
+	BOOST_CHECK_EQUAL(gp.blocks(), 0);
+	BOOST_CHECK_EQUAL(gp.bid(), 7);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
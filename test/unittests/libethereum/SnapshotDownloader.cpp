@@ -0,0 +1,328 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SnapshotDownloader.cpp
+ * Tests for downloading snapshots from peers and resuming them from disk.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/CommonIO.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libethereum/EthereumPeer.h>
+#include <libethereum/SnapshotDownloader.h>
+#include <libp2p/Host.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::p2p;
+using namespace dev::test;
+
+namespace
+{
+
+bytes createManifest(h256s const& _stateChunks, h256s const& _blockChunks, h256 const& _blockHash = h256())
+{
+	RLPStream s(6);
+	s << 2 << _stateChunks << _blockChunks << h256() << 1 << _blockHash;
+	return s.out();
+}
+
+class MockHostCapability: public HostCapabilityFace
+{
+protected:
+	string name() const override { return "eth"; }
+	u256 version() const override { return 64; }
+	unsigned messageCount() const override { return PacketCount; }
+	shared_ptr<Capability> newPeerCapability(shared_ptr<SessionFace> const&, unsigned, CapDesc const&, uint16_t) override { return nullptr; }
+};
+
+/// Keeps the last packet a peer sent.
+class MockSession: public SessionFace
+{
+public:
+	void start() override {}
+	void disconnect(DisconnectReason) override {}
+	void ping() override {}
+	bool isConnected() const override { return true; }
+	NodeID id() const override { return {}; }
+	void sealAndSend(RLPStream& _s, uint16_t) override { _s.swapOut(m_bytesSent); }
+	int rating() const override { return 0; }
+	void addRating(int) override {}
+	void addNote(string const&, string const&) override {}
+	PeerSessionInfo info() const override { return PeerSessionInfo{ NodeID{}, "", "", 0, chrono::steady_clock::duration{}, {}, 0, {}, 0 }; }
+	chrono::steady_clock::time_point connectionTime() override { return chrono::steady_clock::time_point{}; }
+	void registerCapability(CapDesc const&, shared_ptr<Capability>) override {}
+	void registerFraming(uint16_t) override {}
+	map<CapDesc, shared_ptr<Capability>> const& capabilities() const override { return m_capabilities; }
+	shared_ptr<Peer> peer() const override { return nullptr; }
+	chrono::steady_clock::time_point lastReceived() const override { return chrono::steady_clock::time_point{}; }
+	ReputationManager& repMan() override { return m_repMan; }
+
+	ReputationManager m_repMan;
+	map<CapDesc, shared_ptr<Capability>> m_capabilities;
+	bytes m_bytesSent;
+};
+
+class MockEthereumPeerObserver: public EthereumPeerObserverFace
+{
+public:
+	void onPeerStatus(shared_ptr<EthereumPeer>) override {}
+	void onPeerTransactions(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerTransactionHashes(shared_ptr<EthereumPeer>, h256s const&) override {}
+	void onPeerBlockHeaders(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerBlockBodies(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerNewHashes(shared_ptr<EthereumPeer>, vector<pair<h256, u256>> const&) override {}
+	void onPeerNewBlock(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerNodeData(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerReceipts(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerSnapshotManifest(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerSnapshotData(shared_ptr<EthereumPeer>, RLP const&) override {}
+	void onPeerAborting() override {}
+};
+
+class TestEthereumPeer: public EthereumPeer
+{
+public:
+	using EthereumPeer::EthereumPeer;
+	using Capability::interpret;
+};
+
+/// An eth/64 peer past its status exchange, whose requests can be inspected.
+struct SnapshotPeer
+{
+	SnapshotPeer():
+		session(make_shared<MockSession>()),
+		peer(make_shared<TestEthereumPeer>(session, &hostCap, UserPacket, CapDesc{ "eth", 64 }, 0))
+	{
+		peer->init(64, 2, 0, h256(), h256(), nullptr, make_shared<MockEthereumPeerObserver>());
+		RLPStream status(5);
+		status << 64 << 2 << 0 << h256() << h256();
+		bytes const s = status.out();
+		peer->interpret(StatusPacket, RLP(s));
+		session->m_bytesSent.clear();
+	}
+
+	/// @returns the type of the packet sent since the last call, or PacketCount if none.
+	unsigned sentPacket()
+	{
+		unsigned const ret = session->m_bytesSent.empty() ? PacketCount : session->m_bytesSent[0] - UserPacket;
+		if (!session->m_bytesSent.empty())
+			m_lastPayload = bytes(session->m_bytesSent.begin() + 1, session->m_bytesSent.end());
+		session->m_bytesSent.clear();
+		return ret;
+	}
+
+	/// @returns the chunk asked for by the last GetSnapshotData sentPacket() returned.
+	h256 requestedChunk() const { return RLP(m_lastPayload)[0].toHash<h256>(); }
+
+	MockHostCapability hostCap;
+	shared_ptr<MockSession> session;
+	shared_ptr<TestEthereumPeer> peer;
+	bytes m_lastPayload;
+};
+
+bytes answer(bytes const& _item, bool _raw)
+{
+	RLPStream s(_item.empty() ? 0 : 1);
+	if (_raw && !_item.empty())
+		s.appendRaw(_item);
+	else if (!_item.empty())
+		s << _item;
+	return s.out();
+}
+
+void offerManifest(SnapshotDownloader& _downloader, SnapshotPeer& _p, bytes const& _manifest)
+{
+	_downloader.requestNext(_p.peer);
+	BOOST_REQUIRE_EQUAL(_p.sentPacket(), GetSnapshotManifestPacket);
+	bytes const r = answer(_manifest, true);
+	_p.peer->setIdle();
+	_downloader.onPeerManifest(_p.peer, RLP(r));
+}
+
+void sendChunk(SnapshotDownloader& _downloader, SnapshotPeer& _p, bytes const& _chunk)
+{
+	bytes const r = answer(_chunk, false);
+	_p.peer->setIdle();
+	_downloader.onPeerData(_p.peer, RLP(r));
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(SnapshotDownloaderTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(resumesFromDirectory)
+{
+	TransientDirectory dir;
+	bytes const chunk = fromHex("0xdeadbeef");
+	h256 const present = sha3(chunk);
+	h256 const missing = sha3(bytes{1, 2, 3});
+	bytes const manifest = createManifest({present, missing}, {});
+	writeFile(boost::filesystem::path(dir.path()) / "MANIFEST", manifest);
+	writeFile(boost::filesystem::path(dir.path()) / toHex(present), chunk);
+
+	SnapshotDownloader downloader(dir.path());
+	BOOST_CHECK(downloader.readManifest() == manifest);
+	BOOST_CHECK_EQUAL(downloader.progress().first, 1);
+	BOOST_CHECK_EQUAL(downloader.progress().second, 2);
+
+	string const compressed = downloader.readCompressedChunk(present);
+	BOOST_CHECK(bytes(compressed.begin(), compressed.end()) == chunk);
+}
+
+BOOST_AUTO_TEST_CASE(abortReleasesReaders)
+{
+	TransientDirectory dir;
+	SnapshotDownloader downloader(dir.path());
+	downloader.abort();
+	BOOST_CHECK_THROW(downloader.readManifest(), SnapshotDownloadAborted);
+}
+
+BOOST_AUTO_TEST_CASE(manifestIsAdoptedOnceEnoughPeersAgree)
+{
+	TransientDirectory dir;
+	SnapshotDownloader downloader(dir.path(), h256(), 2);
+	bytes const manifest = createManifest({sha3(bytes{1})}, {});
+	SnapshotPeer first, other, second;
+
+	offerManifest(downloader, first, manifest);
+	offerManifest(downloader, other, createManifest({sha3(bytes{2})}, {}));
+	BOOST_CHECK_EQUAL(downloader.progress().second, 0);
+	// Peers that made an offer are not asked again while it is pending.
+	downloader.requestNext(first.peer);
+	BOOST_CHECK_EQUAL(first.sentPacket(), PacketCount);
+
+	offerManifest(downloader, second, manifest);
+	BOOST_CHECK_EQUAL(downloader.progress().second, 1);
+	BOOST_CHECK(downloader.readManifest() == manifest);
+	BOOST_CHECK_EQUAL(second.sentPacket(), GetSnapshotDataPacket);
+
+	downloader.requestNext(other.peer);
+	BOOST_CHECK_EQUAL(other.sentPacket(), PacketCount);
+}
+
+BOOST_AUTO_TEST_CASE(trustedBlockHashSelectsManifest)
+{
+	TransientDirectory dir;
+	h256 const trusted = sha3(bytes{42});
+	SnapshotDownloader downloader(dir.path(), trusted);
+	SnapshotPeer wrong, right;
+
+	offerManifest(downloader, wrong, createManifest({sha3(bytes{1})}, {}, sha3(bytes{43})));
+	BOOST_CHECK_EQUAL(downloader.progress().second, 0);
+	downloader.requestNext(wrong.peer);
+	BOOST_CHECK_EQUAL(wrong.sentPacket(), PacketCount);
+
+	bytes const manifest = createManifest({sha3(bytes{1})}, {}, trusted);
+	offerManifest(downloader, right, manifest);
+	BOOST_CHECK(downloader.readManifest() == manifest);
+	BOOST_CHECK_EQUAL(right.sentPacket(), GetSnapshotDataPacket);
+}
+
+BOOST_AUTO_TEST_CASE(untrustedManifestOnDiskIsNotResumed)
+{
+	TransientDirectory dir;
+	writeFile(boost::filesystem::path(dir.path()) / "MANIFEST", createManifest({sha3(bytes{1})}, {}, sha3(bytes{43})));
+
+	SnapshotDownloader downloader(dir.path(), sha3(bytes{42}));
+	BOOST_CHECK_EQUAL(downloader.progress().second, 0);
+}
+
+BOOST_AUTO_TEST_CASE(onPeerDataStoresVerifiedChunks)
+{
+	TransientDirectory dir;
+	bytes const chunk = fromHex("0xdeadbeef");
+	bytes const manifest = createManifest({sha3(chunk)}, {});
+	SnapshotDownloader downloader(dir.path(), h256(), 1);
+	SnapshotPeer p;
+
+	offerManifest(downloader, p, manifest);
+	BOOST_REQUIRE_EQUAL(p.sentPacket(), GetSnapshotDataPacket);
+	BOOST_CHECK_EQUAL(p.requestedChunk(), sha3(chunk));
+
+	sendChunk(downloader, p, chunk);
+	BOOST_CHECK_EQUAL(downloader.progress().first, 1);
+	string const stored = downloader.readCompressedChunk(sha3(chunk));
+	BOOST_CHECK(bytes(stored.begin(), stored.end()) == chunk);
+	BOOST_CHECK(contents((boost::filesystem::path(dir.path()) / toHex(sha3(chunk))).string()) == chunk);
+	// Nothing is left to ask for.
+	BOOST_CHECK_EQUAL(p.sentPacket(), PacketCount);
+}
+
+BOOST_AUTO_TEST_CASE(onPeerDataRejectsWrongChunks)
+{
+	TransientDirectory dir;
+	bytes const chunk = fromHex("0xdeadbeef");
+	SnapshotDownloader downloader(dir.path(), h256(), 1);
+	SnapshotPeer bad, good;
+
+	offerManifest(downloader, bad, createManifest({sha3(chunk)}, {}));
+	BOOST_REQUIRE_EQUAL(bad.sentPacket(), GetSnapshotDataPacket);
+	sendChunk(downloader, bad, fromHex("0xbaadf00d"));
+	BOOST_CHECK_EQUAL(downloader.progress().first, 0);
+
+	downloader.requestNext(bad.peer);
+	BOOST_CHECK_EQUAL(bad.sentPacket(), PacketCount);
+	downloader.requestNext(good.peer);
+	BOOST_REQUIRE_EQUAL(good.sentPacket(), GetSnapshotDataPacket);
+	BOOST_CHECK_EQUAL(good.requestedChunk(), sha3(chunk));
+
+	// Answers nobody asked for are dropped.
+	sendChunk(downloader, bad, chunk);
+	BOOST_CHECK_EQUAL(downloader.progress().first, 0);
+	sendChunk(downloader, good, chunk);
+	BOOST_CHECK_EQUAL(downloader.progress().first, 1);
+}
+
+BOOST_AUTO_TEST_CASE(unansweredRequestsAreReassigned)
+{
+	TransientDirectory dir;
+	bytes const chunk = fromHex("0xdeadbeef");
+	SnapshotDownloader downloader(dir.path(), h256(), 1);
+	SnapshotPeer slow, fast;
+
+	offerManifest(downloader, slow, createManifest({sha3(chunk)}, {}));
+	BOOST_REQUIRE_EQUAL(slow.sentPacket(), GetSnapshotDataPacket);
+
+	downloader.requestNext(fast.peer);
+	BOOST_CHECK_EQUAL(fast.sentPacket(), PacketCount);
+
+	// The slow peer's asking timeout disconnects it, which hands its request back.
+	weak_ptr<TestEthereumPeer> const gone = slow.peer;
+	slow.peer.reset();
+	BOOST_REQUIRE(gone.expired());
+	downloader.onPeerAborting();
+	downloader.requestNext(fast.peer);
+	BOOST_REQUIRE_EQUAL(fast.sentPacket(), GetSnapshotDataPacket);
+	BOOST_CHECK_EQUAL(fast.requestedChunk(), sha3(chunk));
+
+	sendChunk(downloader, fast, chunk);
+	BOOST_CHECK_EQUAL(downloader.progress().first, 1);
+}
+
+BOOST_AUTO_TEST_CASE(readersGiveUpWhenDownloadStalls)
+{
+	TransientDirectory dir;
+	SnapshotDownloader downloader(dir.path());
+	downloader.setStallTimeout(chrono::milliseconds(50));
+	BOOST_CHECK_THROW(downloader.readManifest(), SnapshotDownloadStalled);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
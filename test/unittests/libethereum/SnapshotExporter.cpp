@@ -0,0 +1,99 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file SnapshotExporter.cpp
+ * Tests for exporting state snapshots.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libdevcore/TrieCommon.h>
+#include <libethereum/BlockChainImporter.h>
+#include <libethereum/SnapshotExporter.h>
+#include <libethereum/SnapshotImporter.h>
+#include <libethereum/SnapshotStorage.h>
+#include <libethereum/StateImporter.h>
+#include <test/tools/libtesteth/BlockChainHelper.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+class NullBlockChainImporter: public BlockChainImporterFace
+{
+public:
+	void importBlock(BlockHeader const&, OverlayDB const&, RLP, RLP, RLP, u256 const&) override {}
+	void setChainStartBlockNumber(u256 const&) override {}
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(SnapshotExporterTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(stateRoundTrip)
+{
+	OverlayDB sourceDb;
+	auto source = createStateImporter(sourceDb);
+	bytes const code = fromHex("0x6000600055");
+	h256 const sharedCode = source->importCode(&code);
+	for (unsigned i = 0; i < 300; ++i)
+	{
+		std::map<h256, bytes> storage;
+		// One account with enough storage to be split over several chunks.
+		for (unsigned j = 0; j < (i == 7 ? 400 : i % 4); ++j)
+			storage[sha3(toBigEndian(u256(i * 1000 + j)))] = rlp(j + 1);
+		source->importAccount(sha3(toBigEndian(u256(i))), i, u256(i) * 1000, storage, i % 3 ? EmptySHA3 : sharedCode);
+	}
+	source->commitStateDatabase();
+	h256 const stateRoot = source->stateRoot();
+
+	TestBlockChain bc;
+	SnapshotExporter exporter(sourceDb, bc.interface());
+	exporter.setMaxChunkSize(2048);
+	TransientDirectory dir;
+	h256s const stateChunks = exporter.exportState(stateRoot, dir.path(), 4);
+	BOOST_CHECK_GT(stateChunks.size(), 10);
+
+	RLPStream manifest(6);
+	manifest << 2 << stateChunks << h256s() << stateRoot << 1 << h256();
+	writeFile(boost::filesystem::path(dir.path()) / "MANIFEST", manifest.out());
+
+	OverlayDB targetDb;
+	auto target = createStateImporter(targetDb);
+	NullBlockChainImporter blockChainImporter;
+	SnapshotImporter importer(*target, blockChainImporter);
+	importer.import(*createSnapshotStorage(dir.path()));
+	BOOST_CHECK_EQUAL(target->stateRoot(), stateRoot);
+}
+
+BOOST_AUTO_TEST_CASE(emptyStateHasNoChunks)
+{
+	OverlayDB db;
+	TestBlockChain bc;
+	SnapshotExporter exporter(db, bc.interface());
+	TransientDirectory dir;
+	BOOST_CHECK(exporter.exportState(EmptyTrie, dir.path()).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
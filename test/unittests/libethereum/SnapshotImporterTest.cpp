@@ -94,6 +94,7 @@ namespace
 			auto it = chunks.find(_chunkHash);
 			return it == chunks.end() ? std::string{} : std::string(it->second.begin(), it->second.end());
 		}
+		std::string readCompressedChunk(h256 const&) const override { return {}; }
 
 		bytes manifest;
 		std::map<h256, bytes> chunks;
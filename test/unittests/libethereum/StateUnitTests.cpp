@@ -22,6 +22,8 @@
 #include <libethereum/Block.h>
 #include <libethcore/BasicAuthority.h>
 #include <libethereum/Defaults.h>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 using namespace dev;
@@ -54,6 +56,62 @@ BOOST_AUTO_TEST_CASE(LoadAccountCode)
 	));
 }
 
+BOOST_AUTO_TEST_CASE(RollbackKill)
+{
+	Address addr{"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"};
+	State s{0};
+	s.createContract(addr);
+	s.addBalance(addr, 100);
+	s.setStorage(addr, 1, 2);
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+
+	size_t const savept = s.savepoint();
+	s.kill(addr);
+	BOOST_CHECK_EQUAL(s.balance(addr), 0);
+	s.rollback(savept);
+
+	BOOST_CHECK(s.addressInUse(addr));
+	BOOST_CHECK_EQUAL(s.balance(addr), 100);
+	BOOST_CHECK_EQUAL(s.storage(addr, 1), 2);
+}
+
+BOOST_AUTO_TEST_CASE(CommittedViewsReadConcurrently)
+{
+	State s{0};
+	vector<Address> accounts;
+	for (unsigned i = 1; i <= 200; ++i)
+	{
+		accounts.push_back(Address(i));
+		s.addBalance(accounts.back(), i);
+		s.setNonce(accounts.back(), i * 2);
+	}
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	// Uncommitted changes are not part of a view.
+	s.addBalance(accounts.front(), 1000);
+
+	SharedMutex x_s;
+	atomic<unsigned> mismatches{0};
+	vector<thread> readers;
+	for (unsigned t = 0; t < 8; ++t)
+		readers.emplace_back([&, t]()
+		{
+			for (unsigned i = 0; i < 500; ++i)
+			{
+				ReadGuard l(x_s);
+				State const view = s.committedView();
+				l.unlock();
+				unsigned const n = (i * 7 + t) % accounts.size() + 1;
+				if (view.balance(accounts[n - 1]) != n || view.getNonce(accounts[n - 1]) != n * 2)
+					++mismatches;
+			}
+		});
+	for (auto& r: readers)
+		r.join();
+
+	BOOST_CHECK_EQUAL(mismatches.load(), 0);
+	BOOST_CHECK_EQUAL(s.balance(accounts.front()), 1001);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -24,6 +24,7 @@
 #include "test/tools/libtesteth/TestHelper.h"
 #include <libethcore/Exceptions.h>
 #include <libethcore/Common.h>
+#include <libethcore/SignatureCache.h>
 #include <libevm/VMFace.h>
 using namespace dev;
 using namespace eth;
@@ -187,4 +188,55 @@ BOOST_AUTO_TEST_CASE(CheckLowSForUnsignedTransactionThrows)
 	BOOST_REQUIRE_THROW(tx.checkLowS(), TransactionIsUnsigned);
 }
 
+BOOST_AUTO_TEST_CASE(SignatureIsVerifiedOnceAndCached)
+{
+	SignatureCache::instance().clear();
+	AccountKeys::Pair sender = AccountKeys::Pair::create();
+	Transaction tx(0, 0, 25000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0, sender.secret());
+	bytes const rlp = tx.rlp();
+
+	Transaction fromPool(rlp, CheckTransaction::Everything);
+	BOOST_CHECK(!SignatureCache::instance().contains(tx.sha3()));
+	fromPool.checkSignature();
+	BOOST_CHECK(SignatureCache::instance().contains(tx.sha3()));
+	unsigned const hits = SignatureCache::instance().hits();
+
+	Transaction fromBlock(rlp, CheckTransaction::Everything);
+	fromBlock.checkSignature();
+	BOOST_CHECK_EQUAL(SignatureCache::instance().hits(), hits + 1);
+	BOOST_CHECK(fromBlock.sender() == sender.address());
+}
+
+BOOST_AUTO_TEST_CASE(SignatureWithForeignPublicKeyIsNotCached)
+{
+	SignatureCache::instance().clear();
+	AccountKeys::Pair sender = AccountKeys::Pair::create();
+	AccountKeys::Pair impostor = AccountKeys::Pair::create();
+	Transaction tx(0, 0, 25000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0, sender.secret());
+
+	RLPStream forged;
+	forged.appendList(7);
+	forged << tx.nonce() << tx.gasPrice() << tx.gas() << tx.receiveAddress() << tx.value() << tx.data();
+	AccountKeys::SignatureStruct(tx.signature(), impostor.pub()).streamRLP(forged);
+
+	Transaction t(forged.out(), CheckTransaction::Everything);
+	BOOST_REQUIRE_THROW(t.checkSignature(), InvalidSignature);
+	BOOST_CHECK(!SignatureCache::instance().contains(t.sha3()));
+}
+
+BOOST_AUTO_TEST_CASE(ZeroSignatureWithPublicKeyThrows)
+{
+	AccountKeys::Pair impostor = AccountKeys::Pair::create();
+	Transaction tx(0, 0, 25000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0);
+
+	RLPStream forged;
+	forged.appendList(7);
+	forged << tx.nonce() << tx.gasPrice() << tx.gas() << tx.receiveAddress() << tx.value() << tx.data();
+	AccountKeys::SignatureStruct(AccountKeys::Signature(), impostor.pub()).streamRLP(forged);
+
+	Transaction t(forged.out(), CheckTransaction::Everything);
+	BOOST_CHECK(t.hasZeroSignature());
+	BOOST_REQUIRE_THROW(t.checkSignature(), InvalidSignature);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -75,6 +75,33 @@ BOOST_AUTO_TEST_CASE(tqMaxNonce)
 	BOOST_CHECK(10 == txq.maxNonce(to));
 }
 
+BOOST_AUTO_TEST_CASE(tqLookupByHash)
+{
+	dev::eth::TransactionQueue txq;
+	const u256 gasCost =  10 * szabo;
+	const u256 gas = 25000;
+	Address dest = Address("0x095e7baea6a6c7c4c2dfeb977efac326af552d87");
+	Secret sec = Secret("0x45a915e4d060149eb4365960e6a7a45f334393093061116b197e3240065ff2d8");
+	Transaction tx0(0, gasCost, gas, dest, bytes(), 0, sec);
+	Transaction tx1(0, gasCost, gas, dest, bytes(), 1, sec);
+	Transaction unknown(0, gasCost, gas, dest, bytes(), 2, sec);
+
+	txq.import(tx0);
+	txq.import(tx1);
+	BOOST_CHECK(txq.isKnown(tx0.sha3()));
+	BOOST_CHECK(!txq.isKnown(unknown.sha3()));
+
+	Transactions found = txq.transactions({tx1.sha3(), unknown.sha3(), tx0.sha3()});
+	BOOST_REQUIRE_EQUAL(found.size(), 2);
+	BOOST_CHECK(found[0].sha3() == tx1.sha3());
+	BOOST_CHECK(found[1].sha3() == tx0.sha3());
+
+	txq.drop(tx0.sha3());
+	BOOST_CHECK(txq.transactions({tx0.sha3()}).empty());
+	// Dropped transactions are not worth fetching again.
+	BOOST_CHECK(txq.isKnown(tx0.sha3()));
+}
+
 BOOST_AUTO_TEST_CASE(tqPriority)
 {
 	dev::eth::TransactionQueue txq;
@@ -129,6 +156,35 @@ BOOST_AUTO_TEST_CASE(tqPriority)
 
 }
 
+BOOST_AUTO_TEST_CASE(tqPriorityAcrossSenders)
+{
+	dev::eth::TransactionQueue txq;
+
+	const u256 gas = 25000;
+	Address dest = Address("0x095e7baea6a6c7c4c2dfeb977efac326af552d87");
+	Secret sender1 = Secret("0x3333333333333333333333333333333333333333333333333333333333333333");
+	Secret sender2 = Secret("0x4444444444444444444444444444444444444444444444444444444444444444");
+	Secret sender3 = Secret("0x5555555555555555555555555555555555555555555555555555555555555555");
+	Transaction a0(0, 10 * szabo, gas, dest, bytes(), 0, sender1);
+	Transaction a1(0, 50 * szabo, gas, dest, bytes(), 1, sender1);
+	Transaction b0(0, 30 * szabo, gas, dest, bytes(), 0, sender2);
+	Transaction b1(0, 25 * szabo, gas, dest, bytes(), 1, sender2);
+	Transaction b2(0, 40 * szabo, gas, dest, bytes(), 2, sender2);
+	Transaction c5(0, 20 * szabo, gas, dest, bytes(), 5, sender3);
+	for (auto const& t: {b2, a1, c5, b1, a0, b0})
+		BOOST_REQUIRE(txq.import(t) == ImportResult::Success);
+
+	// Transaction::operator== ignores nonce, gas price and sender, so compare hashes.
+	auto hashes = [](Transactions const& _ts) { h256s ret; for (auto const& t: _ts) ret.push_back(t.sha3()); return ret; };
+	BOOST_CHECK((h256s{b0.sha3(), c5.sha3(), a0.sha3(), a1.sha3(), b1.sha3(), b2.sha3()}) == hashes(txq.topTransactions(256)));
+	BOOST_CHECK((h256s{b0.sha3(), c5.sha3(), a0.sha3()}) == hashes(txq.topTransactions(3)));
+	BOOST_CHECK((h256s{b0.sha3(), a0.sha3(), a1.sha3(), b1.sha3(), b2.sha3()}) == hashes(txq.topTransactions(256, {c5.sha3()})));
+
+	// Dropping a lane's head moves the rest of the lane up.
+	txq.drop(b0.sha3());
+	BOOST_CHECK((h256s{b1.sha3(), c5.sha3(), a0.sha3(), a1.sha3(), b2.sha3()}) == hashes(txq.topTransactions(256)));
+}
+
 BOOST_AUTO_TEST_CASE(tqFuture)
 {
 	dev::eth::TransactionQueue txq;
@@ -310,4 +366,63 @@ BOOST_AUTO_TEST_CASE(tqEqueue)
 	BOOST_REQUIRE(topTr.size() == 1);
 }
 
+BOOST_AUTO_TEST_CASE(tqSenderStateAdmission)
+{
+	TransactionQueue txq;
+	const u256 gasCost = 10 * szabo;
+	const u256 gas = 25000;
+	Address dest = Address("0x095e7baea6a6c7c4c2dfeb977efac326af552d87");
+	Secret sec = Secret("0x45a915e4d060149eb4365960e6a7a45f334393093061116b197e3240065ff2d8");
+	Transaction stale(0, gasCost, gas, dest, bytes(), 4, sec);
+	Transaction next(0, gasCost, gas, dest, bytes(), 5, sec);
+	Transaction expensive(1, gasCost, gas, dest, bytes(), 6, sec);
+
+	unsigned reads = 0;
+	txq.senderStates().setReader([&](Address const&) { ++reads; return SenderState{5, gasCost * gas}; });
+
+	BOOST_CHECK(txq.import(stale) == ImportResult::NonceTooLow);
+	BOOST_CHECK(txq.import(expensive) == ImportResult::InsufficientBalance);
+	BOOST_CHECK(txq.import(next) == ImportResult::Success);
+	BOOST_CHECK_EQUAL(reads, 1);
+	BOOST_CHECK_EQUAL(txq.senderStates().hits(), 2);
+
+	// An import touching someone else leaves the entry; touching the sender forces a fresh read.
+	txq.senderStates().noteImported(AddressHash{dest});
+	BOOST_CHECK(txq.import(stale) == ImportResult::NonceTooLow);
+	BOOST_CHECK_EQUAL(reads, 1);
+	txq.senderStates().noteImported(AddressHash{next.from()});
+	BOOST_CHECK(txq.import(stale) == ImportResult::NonceTooLow);
+	BOOST_CHECK_EQUAL(reads, 2);
+}
+
+BOOST_AUTO_TEST_CASE(tqImportBatch)
+{
+	TransactionQueue txq;
+	const u256 gasCost = 10 * szabo;
+	const u256 gas = 25000;
+	Address dest = Address("0x095e7baea6a6c7c4c2dfeb977efac326af552d87");
+	Secret sec = Secret("0x45a915e4d060149eb4365960e6a7a45f334393093061116b197e3240065ff2d8");
+
+	vector<bytes> txs;
+	for (unsigned i = 0; i < 100; ++i)
+		txs.push_back(Transaction(0, gasCost, gas, dest, bytes(), i, sec).rlp());
+	txs.push_back(txs[3]);
+	txs.push_back(bytes{0x01, 0x02});
+
+	auto results = txq.importBatch(txs);
+	BOOST_REQUIRE_EQUAL(results.size(), txs.size());
+	for (unsigned i = 0; i < 100; ++i)
+	{
+		BOOST_CHECK(results[i].second == sha3(txs[i]));
+		if (i != 3)
+			BOOST_CHECK(results[i].first == ImportResult::Success);
+	}
+	// The duplicate races the original through the verifiers; exactly one of them gets in.
+	BOOST_CHECK(results[100].second == results[3].second);
+	BOOST_CHECK((results[3].first == ImportResult::Success) != (results[100].first == ImportResult::Success));
+	BOOST_CHECK(results[101].first == ImportResult::Malformed);
+	BOOST_CHECK(!results[101].second);
+	BOOST_CHECK_EQUAL(txq.knownTransactions().size(), 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
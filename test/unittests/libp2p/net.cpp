@@ -104,10 +104,11 @@ struct TestNodeTable: public NodeTable
 			{
 				// manually add node for test
 				{
-					Guard ln(x_nodes);
 					shared_ptr<NodeEntry> node(new NodeEntry(m_node.id, n.first.pub(), NodeIPEndpoint(ourIp, n.second, n.second)));
 					node->pending = false;
-					m_nodes[node->id] = node;
+					NodeShard& shard = nodeShard(node->id);
+					Guard ln(shard.x_nodes);
+					shard.nodes[node->id] = node;
 				}
 				noteActiveNode(n.first.pub(), bi::udp::endpoint(ourIp, n.second));
 			}
@@ -117,8 +118,9 @@ struct TestNodeTable: public NodeTable
 
 	void reset()
 	{
-		Guard l(x_state);
-		for (auto& n: m_state) n.nodes.clear();
+		for (auto& n: m_state)
+			DEV_GUARDED(n.x_nodes)
+				n.nodes.clear();
 	}
 };
 
@@ -150,11 +152,12 @@ public:
 	TestUDPSocket(): m_socket(new UDPSocket<TestUDPSocket, 1024>(m_io, *this, 30300)) {}
 
 	void onDisconnected(UDPSocketFace*) {};
-	void onReceived(UDPSocketFace*, bi::udp::endpoint const&, bytesConstRef _packet) { if (_packet.toString() == "AAAA") success = true; }
+	void onReceived(UDPSocketFace*, bi::udp::endpoint const&, bytesConstRef _packet) { if (_packet.toString() == "AAAA") { success = true; ++received; } }
 
 	shared_ptr<UDPSocket<TestUDPSocket, 1024>> m_socket;
 
 	bool success = false;
+	std::atomic<unsigned> received{0};
 };
 
 BOOST_AUTO_TEST_CASE(requestTimeout)
@@ -306,6 +309,24 @@ BOOST_AUTO_TEST_CASE(udpOnce)
 	BOOST_REQUIRE_EQUAL(true, a.success);
 }
 
+BOOST_AUTO_TEST_CASE(udpBurst)
+{
+	if (test::Options::get().nonetwork)
+	{
+		clog << "Skipping test network/net/udpBurst. --nonetwork flag is set.\n";
+		return;
+	}
+
+	// More datagrams than one batch, queued before any is sent.
+	UDPDatagram d(bi::udp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), 30300), bytes({65,65,65,65}));
+	TestUDPSocket a; a.m_socket->connect();
+	for (unsigned i = 0; i < 200; ++i)
+		a.m_socket->send(d);
+	a.start();
+	this_thread::sleep_for(chrono::seconds(1));
+	BOOST_REQUIRE_EQUAL(a.received.load(), 200);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(netTypes, TestOutputHelper)
@@ -127,6 +127,43 @@ BOOST_AUTO_TEST_CASE(host)
 	BOOST_REQUIRE_EQUAL(host2.peerCount(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(multiThreadedHost)
+{
+	if (test::Options::get().nonetwork)
+	{
+		clog << "Skipping test libp2p/p2p/multiThreadedHost. --nonetwork flag is set.\n";
+		return;
+	}
+
+	NetworkPreferences prefs("127.0.0.1", 0, false);
+	prefs.ioThreads = 4;
+	Host host1("Test", prefs);
+	Host host2("Test", prefs);
+	host1.registerCapability(make_shared<TestHostCap>());
+	host2.registerCapability(make_shared<TestHostCap>());
+	host1.start();
+	host2.start();
+	BOOST_REQUIRE(host1.haveNetwork() && host2.haveNetwork());
+
+	host1.addNode(host2.id(), NodeIPEndpoint(bi::address::from_string("127.0.0.1"), host2.listenPort(), host2.listenPort()));
+
+	// Handshake and hello are handled on the sockets' strands across the io threads.
+	int const step = 10;
+	for (unsigned i = 0; i < 24000; i += step)
+	{
+		this_thread::sleep_for(chrono::milliseconds(step));
+		if (host1.peerCount() > 0 && host2.peerCount() > 0)
+			break;
+	}
+	BOOST_REQUIRE_EQUAL(host1.peerCount(), 1);
+	BOOST_REQUIRE_EQUAL(host2.peerCount(), 1);
+
+	// Stopping must join the extra io threads.
+	host1.stop();
+	host2.stop();
+	BOOST_CHECK(!host1.isStarted() && !host2.isStarted());
+}
+
 BOOST_AUTO_TEST_CASE(networkConfig)
 {
 	if (test::Options::get().nonetwork)
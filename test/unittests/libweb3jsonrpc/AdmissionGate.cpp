@@ -0,0 +1,224 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file AdmissionGate.cpp
+ * Tests for RPC request admission.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libweb3jsonrpc/AdmissionGate.h>
+#include <libweb3jsonrpc/BatchRequestHandler.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace dev;
+using namespace dev::rpc;
+using namespace dev::test;
+
+namespace
+{
+
+/// Answers every method with 1; debug_wait only does so once released.
+class WaitingMethods: public jsonrpc::IProcedureInvokationHandler
+{
+public:
+	void HandleMethodCall(jsonrpc::Procedure& _proc, Json::Value const&, Json::Value& _output) override
+	{
+		if (_proc.GetProcedureName() == "debug_wait")
+		{
+			unique_lock<mutex> l(x_state);
+			++m_waiting;
+			m_changed.notify_all();
+			m_changed.wait(l, [this]() { return m_released; });
+		}
+		_output = 1;
+	}
+	void HandleNotificationCall(jsonrpc::Procedure&, Json::Value const&) override {}
+
+	void waitFor(unsigned _waiting)
+	{
+		unique_lock<mutex> l(x_state);
+		m_changed.wait(l, [&]() { return m_waiting >= _waiting; });
+	}
+	void release()
+	{
+		lock_guard<mutex> l(x_state);
+		m_released = true;
+		m_changed.notify_all();
+	}
+
+private:
+	mutex x_state;
+	condition_variable m_changed;
+	unsigned m_waiting = 0;
+	bool m_released = false;
+};
+
+string call(string const& _method, unsigned _id)
+{
+	return "{\"jsonrpc\":\"2.0\",\"id\":" + to_string(_id) + ",\"method\":\"" + _method + "\",\"params\":[]}";
+}
+
+Json::Value parse(string const& _response)
+{
+	Json::Value ret;
+	Json::Reader().parse(_response, ret, false);
+	return ret;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(AdmissionGateTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(unlimitedByDefault)
+{
+	AdmissionGate gate;
+	for (unsigned i = 0; i < 100; ++i)
+		BOOST_REQUIRE(gate.enter());
+	BOOST_CHECK_EQUAL(gate.running(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(refusesBeyondQueue)
+{
+	AdmissionGate gate;
+	gate.configure(1, 0, chrono::milliseconds(0));
+	BOOST_REQUIRE(gate.enter());
+	BOOST_CHECK(!gate.enter());
+	BOOST_CHECK_EQUAL(gate.refused(), 1u);
+	gate.leave();
+	BOOST_CHECK(gate.enter());
+}
+
+BOOST_AUTO_TEST_CASE(waiterTakesFreedSlot)
+{
+	AdmissionGate gate;
+	gate.configure(1, 1, chrono::seconds(10));
+	BOOST_REQUIRE(gate.enter());
+
+	bool admitted = false;
+	thread waiter([&]() { admitted = gate.enter(); });
+	while (gate.waiting() == 0)
+		this_thread::yield();
+	// The queue holds a single waiter, so a third request is refused straight away.
+	BOOST_CHECK(!gate.enter());
+	gate.leave();
+	waiter.join();
+	BOOST_CHECK(admitted);
+	BOOST_CHECK_EQUAL(gate.running(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(waiterTimesOut)
+{
+	AdmissionGate gate;
+	gate.configure(1, 1, chrono::milliseconds(10));
+	BOOST_REQUIRE(gate.enter());
+	BOOST_CHECK(!gate.enter());
+	BOOST_CHECK_EQUAL(gate.waiting(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(weightTakesSeveralSlots)
+{
+	AdmissionGate gate;
+	gate.configure(3, 0, chrono::milliseconds(0));
+	BOOST_REQUIRE(gate.enter(2));
+	BOOST_CHECK(!gate.enter(2));
+	BOOST_REQUIRE(gate.enter());
+	gate.leave(2);
+	gate.leave();
+
+	// More than there are slots takes all of them rather than never getting in.
+	BOOST_REQUIRE(gate.enter(5));
+	BOOST_CHECK_EQUAL(gate.running(), 3u);
+	BOOST_CHECK(!gate.enter());
+	gate.leave(5);
+	BOOST_CHECK_EQUAL(gate.running(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(classifyRequests)
+{
+	Json::Value cheap;
+	cheap["method"] = "eth_blockNumber";
+	Json::Value expensive;
+	expensive["method"] = "debug_traceTransaction";
+	Json::Value batch(Json::arrayValue);
+	batch.append(cheap);
+	BOOST_CHECK(BatchRequestHandler::classify(cheap) == RequestClass::Cheap);
+	BOOST_CHECK(BatchRequestHandler::classify(expensive) == RequestClass::Expensive);
+	BOOST_CHECK(BatchRequestHandler::classify(batch) == RequestClass::Cheap);
+	batch.append(expensive);
+	BOOST_CHECK(BatchRequestHandler::classify(batch) == RequestClass::Expensive);
+
+	BOOST_CHECK_EQUAL(BatchRequestHandler::expensiveCount(cheap), 0u);
+	BOOST_CHECK_EQUAL(BatchRequestHandler::expensiveCount(expensive), 1u);
+	batch.append(expensive);
+	BOOST_CHECK_EQUAL(BatchRequestHandler::expensiveCount(batch), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(cheapCallsRunWhileExpensiveSlotsAreBusy)
+{
+	WaitingMethods methods;
+	BatchRequestHandler handler(methods);
+	handler.AddProcedure(jsonrpc::Procedure("debug_wait", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_INTEGER, NULL));
+	handler.AddProcedure(jsonrpc::Procedure("eth_blockNumber", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_INTEGER, NULL));
+	handler.setAdmission(RequestClass::Expensive, 2, 0);
+	handler.setAdmission(RequestClass::Cheap, 2, 0);
+
+	vector<thread> expensive;
+	for (unsigned i = 0; i < 2; ++i)
+		expensive.emplace_back([&, i]() { string response; handler.HandleRequest(call("debug_wait", i), response); });
+	methods.waitFor(2);
+
+	string response;
+	handler.HandleRequest(call("eth_blockNumber", 10), response);
+	BOOST_CHECK(!BatchRequestHandler::refusedOnThisThread());
+	BOOST_CHECK_EQUAL(parse(response)["result"].asInt(), 1);
+
+	// Further expensive calls are turned away rather than left holding the thread.
+	handler.HandleRequest(call("debug_wait", 11), response);
+	BOOST_CHECK(BatchRequestHandler::refusedOnThisThread());
+	BOOST_CHECK_EQUAL(parse(response)["error"]["code"].asInt(), c_errorServerBusy);
+
+	methods.release();
+	for (auto& t: expensive)
+		t.join();
+}
+
+BOOST_AUTO_TEST_CASE(batchesTakeASlotPerExpensiveEntry)
+{
+	WaitingMethods methods;
+	BatchRequestHandler handler(methods);
+	handler.AddProcedure(jsonrpc::Procedure("debug_wait", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_INTEGER, NULL));
+	handler.setAdmission(RequestClass::Expensive, 3, 0);
+
+	thread running([&]() { string response; handler.HandleRequest(call("debug_wait", 1), response); });
+	methods.waitFor(1);
+
+	// Two slots are left: a batch of three expensive entries doesn't fit, one of two does.
+	string response;
+	handler.HandleRequest("[" + call("debug_wait", 2) + "," + call("debug_wait", 3) + "," + call("debug_wait", 4) + "]", response);
+	BOOST_CHECK(BatchRequestHandler::refusedOnThisThread());
+
+	methods.release();
+	handler.HandleRequest("[" + call("debug_wait", 5) + "," + call("debug_wait", 6) + "]", response);
+	BOOST_CHECK(!BatchRequestHandler::refusedOnThisThread());
+	BOOST_CHECK_EQUAL(parse(response).size(), 2u);
+	running.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
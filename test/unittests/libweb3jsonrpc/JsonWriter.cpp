@@ -0,0 +1,128 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonWriter.cpp
+ * Tests and benchmark for the RPC response serialiser.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <libdevcore/CommonJS.h>
+#include <libweb3jsonrpc/JsonWriter.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::rpc;
+using namespace dev::test;
+namespace ut = boost::unit_test;
+
+namespace
+{
+/// Shaped like eth_getBlockByNumber with full transactions.
+Json::Value syntheticBlock(unsigned _transactions)
+{
+	Json::Value block;
+	block["hash"] = toJS(h256::random());
+	block["parentHash"] = toJS(h256::random());
+	block["number"] = toJS(u256(4000000));
+	block["logsBloom"] = toJS(h2048::random());
+	block["extraData"] = toJS(bytes(32, 0xab));
+	block["uncles"] = Json::Value(Json::arrayValue);
+	Json::Value& transactions = block["transactions"] = Json::Value(Json::arrayValue);
+	for (unsigned i = 0; i < _transactions; ++i)
+	{
+		Json::Value t;
+		t["hash"] = toJS(h256::random());
+		t["input"] = toJS(bytes(68, byte(i)));
+		t["to"] = toJS(Address::random());
+		t["from"] = toJS(Address::random());
+		t["gas"] = toJS(u256(21000 + i));
+		t["gasPrice"] = toJS(u256(20000000000));
+		t["nonce"] = toJS(u256(i));
+		t["value"] = toJS(u256(1000000000000000000) * i);
+		t["transactionIndex"] = toJS(i);
+		transactions.append(t);
+	}
+	return block;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(JsonWriterTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(matchesFastWriter)
+{
+	Json::Value v;
+	v["null"] = Json::Value();
+	v["int"] = -42;
+	v["uint"] = Json::Value(Json::UInt64(1) << 63);
+	v["real"] = 1.5;
+	v["bool"] = true;
+	v["emptyArray"] = Json::Value(Json::arrayValue);
+	v["emptyObject"] = Json::Value(Json::objectValue);
+	v["escaped"] = "quote\" backslash\\ newline\n control\x01 unicode\xc3\xa9";
+	v["key\"escaped"] = "0x00";
+	v["nested"].append(syntheticBlock(3));
+
+	JsonWriter writer;
+	Json::FastWriter fastWriter;
+	BOOST_CHECK_EQUAL(writer.write(v), fastWriter.write(v));
+	BOOST_CHECK_EQUAL(writer.write(Json::Value("0x1")), fastWriter.write(Json::Value("0x1")));
+	BOOST_CHECK_EQUAL(writer.write(Json::Value()), fastWriter.write(Json::Value()));
+}
+
+BOOST_AUTO_TEST_CASE(trimDropsLargeBuffers)
+{
+	JsonWriter writer;
+	writer.write(syntheticBlock(3));
+	size_t const small = writer.capacity();
+	writer.trim();
+	BOOST_CHECK_EQUAL(writer.capacity(), small);
+
+	writer.write(Json::Value(string(JsonWriter::c_retainedCapacity, 'a')));
+	BOOST_REQUIRE(writer.capacity() > JsonWriter::c_retainedCapacity);
+	writer.trim();
+	BOOST_CHECK(writer.capacity() < JsonWriter::c_retainedCapacity);
+	BOOST_CHECK_EQUAL(writer.write(Json::Value("0x1")), "\"0x1\"\n");
+}
+
+BOOST_AUTO_TEST_CASE(bench_serialiseBlock, *ut::label("bench"))
+{
+	if (!Options::get().all)
+	{
+		std::cout << "Skipping benchmark test because --all option is not specified.\n";
+		return;
+	}
+
+	Json::Value const block = syntheticBlock(500);
+	int const n = 200;
+	Json::FastWriter fastWriter;
+	JsonWriter writer;
+	BOOST_REQUIRE_EQUAL(writer.write(block), fastWriter.write(block));
+
+	Timer timer;
+	for (int i = 0; i < n; ++i)
+		fastWriter.write(block);
+	auto fast = std::chrono::duration_cast<std::chrono::microseconds>(timer.duration() / n).count();
+
+	timer.restart();
+	for (int i = 0; i < n; ++i)
+		writer.write(block);
+	auto ours = std::chrono::duration_cast<std::chrono::microseconds>(timer.duration() / n).count();
+
+	std::cout << ut::framework::current_test_case().p_name << ": FastWriter " << fast << " us, JsonWriter " << ours << " us\n";
+}
+
+BOOST_AUTO_TEST_SUITE_END()